@@ -4,10 +4,35 @@
 
 #include "ARCNode.h"
 #include "ARCLinkList.h"
+#include "BackgroundEvictor.h"
+#include "Doorkeeper.h"
+#include "CacheResize.h"
+#include "CacheSnapshot.h"
+#include "TagIndex.h"
+#include <atomic>
+#include <algorithm>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
 #include <unordered_map>
 #include <map>
+#include <vector>
+
+/**
+* ARC 其中一半（LRU 部分 T1/B1 或 LFU 部分 T2/B2）的状态，用于快照
+* entries 为 <key, value, freq>，ghosts 只保存 key，均按 最久 -> 最近 排列
+*/
+template<typename Key, typename Value>
+struct ARCPartState {
+	int capacity = 0;
+	int ghostCapacity = 0;
+	std::vector<std::tuple<Key, Value, int>> entries;
+	std::vector<Key> ghosts;
+};
 
 template<typename Key, typename Value>
 class ARC_LRUCache {
@@ -26,6 +51,9 @@ class ARC_LRUCache {
 	int _ghostCapacity;
 	NodeMap _ghostMap;
 	NodeList _ghostList;
+	EvictionStats _evictionStats;
+	// 主缓存淘汰（进入 ghost）时在锁内调用
+	std::function<void(const Key&)> _onEvict;
 
 	bool updateNodeAccess(NodePtr node) {
 		++node->_freq;
@@ -44,10 +72,42 @@ public:
 		node->_next.reset();
 	}
 
+	/**
+	* 主缓存中是否有 key
+	*/
+	bool contains(Key key) {
+		std::lock_guard<std::mutex> lock(_mtx);
+		return _nodeMap.find(key) != _nodeMap.end();
+	}
+
+	/**
+	* 从主缓存与 ghost 中删除 key，返回主缓存中是否有它
+	*/
+	bool remove(Key key) {
+		std::lock_guard<std::mutex> lock(_mtx);
+		auto ghost = _ghostMap.find(key);
+		if (ghost != _ghostMap.end()) {
+			removeFromList(ghost->second);
+			_ghostMap.erase(ghost);
+		}
+		auto it = _nodeMap.find(key);
+		if (it == _nodeMap.end()) return false;
+		removeFromList(it->second);
+		_nodeMap.erase(it);
+		return true;
+	}
+
+	/**
+	* 设置淘汰回调，需在并发访问开始前调用
+	*/
+	void setEvictionCallback(std::function<void(const Key&)> onEvict) { _onEvict = std::move(onEvict); }
+
 	/**
 	* 检查key对应的节点是否存在，存在则移除节点并返回true；否则返回false。
 	*/
 	bool checkGhost(Key key) {
+		// 后台淘汰线程会并发修改 ghost 链表，这里也需要加锁
+		std::lock_guard<std::mutex> lock(_mtx);
 		auto it = _ghostMap.find(key);
 		if (it == _ghostMap.end()) {
 			return false;
@@ -59,12 +119,13 @@ public:
 	}
 
 	/**
-	* 删除最少使用的元素
+	* 删除最少使用的元素，跳过被 pin 的节点；全部被 pin 时返回 false
 	*/
-	void kickOut() {
+	bool kickOut() {
 		// 从主缓存 链表 删除
-		auto removedNode = _nodeList.tailRemove().lock();
-		if (!removedNode || _nodeList.isEmpty()) return;
+		NodePtr removedNode = _nodeList.findFromTail([](const NodePtr& node) { return !node->_pin.pinned(); });
+		if (!removedNode) return false;
+		_nodeList.nodeRemove(removedNode);
 		
 		if (_ghostMap.size() >= _ghostCapacity) {
 			auto removedGhost = _ghostList.tailRemove().lock();
@@ -78,18 +139,22 @@ public:
 		_ghostMap[removedNode->_key] = removedNode;
 		// 从主缓存 Map 删除
 		_nodeMap.erase(removedNode->_key);
+		if (_onEvict) _onEvict(removedNode->_key);
+		return true;
 	}
 
 	/**
 	* 主缓存扩容
 	*/
 	void expandCapacity() {
+		std::lock_guard<std::mutex> lock(_mtx);
 		++_capacity;
 	}
 	/**
 	* 主缓存缩容
 	*/
 	bool shrinkCapacity() {
+		std::lock_guard<std::mutex> lock(_mtx);
 		if (_capacity <= 0) return false;
 		// Cache 已满，删除最近最久未使用节点
 		if (_nodeMap.size() >= _capacity) {
@@ -99,6 +164,102 @@ public:
 		return true;
 	}
 
+	int getCapacity() {
+		std::lock_guard<std::mutex> lock(_mtx);
+		return _capacity;
+	}
+	/**
+	* 设置主缓存与 ghost 的容量，超出的部分由 trim 分批淘汰
+	*/
+	void setCapacity(int capacity, int ghostCapacity) {
+		std::lock_guard<std::mutex> lock(_mtx);
+		_capacity = capacity > 0 ? capacity : 0;
+		_ghostCapacity = ghostCapacity > 0 ? ghostCapacity : 0;
+	}
+	/**
+	* 最多淘汰 maxEvictions 个超出容量的条目（主缓存淘汰进入 ghost），返回是否仍超出容量
+	*/
+	bool trim(size_t maxEvictions) {
+		std::lock_guard<std::mutex> lock(_mtx);
+		size_t evicted = 0;
+		// 剩下的条目都被 pin 时停止，等 handle 释放后再淘汰
+		bool blocked = false;
+		for (; evicted < maxEvictions && _nodeMap.size() > static_cast<size_t>(_capacity); ++evicted) {
+			if (!kickOut()) {
+				blocked = true;
+				break;
+			}
+		}
+		for (; evicted < maxEvictions && _ghostMap.size() > static_cast<size_t>(_ghostCapacity); ++evicted) {
+			auto removedGhost = _ghostList.tailRemove().lock();
+			if (!removedGhost) break;
+			_ghostMap.erase(removedGhost->_key);
+		}
+		return (!blocked && _nodeMap.size() > static_cast<size_t>(_capacity)) || _ghostMap.size() > static_cast<size_t>(_ghostCapacity);
+	}
+	/**
+	* 最多淘汰 maxEvictions 个条目（进入 ghost），使主缓存至少留出 headroom 个空位，返回是否仍然不足
+	*/
+	bool evictToHeadroom(size_t headroom, size_t maxEvictions) {
+		std::lock_guard<std::mutex> lock(_mtx);
+		size_t capacity = _capacity > 0 ? static_cast<size_t>(_capacity) : 0;
+		size_t limit = capacity > headroom ? capacity - headroom : 0;
+		size_t evicted = 0;
+		for (; evicted < maxEvictions && _nodeMap.size() > limit; ++evicted) {
+			if (!kickOut()) return false;
+		}
+		_evictionStats.backgroundEvictions += evicted;
+		return _nodeMap.size() > limit;
+	}
+	EvictionStats getEvictionStats() {
+		std::lock_guard<std::mutex> lock(_mtx);
+		return _evictionStats;
+	}
+
+	/**
+	* 导出 T1 与 B1，持锁拷贝
+	*/
+	ARCPartState<Key, Value> exportState() {
+		std::lock_guard<std::mutex> lock(_mtx);
+		ARCPartState<Key, Value> state;
+		state.capacity = _capacity;
+		state.ghostCapacity = _ghostCapacity;
+		state.entries.reserve(_nodeMap.size());
+		_nodeList.forEachFromTail([&state](const NodePtr& node) {
+			state.entries.emplace_back(node->_key, node->_value, node->_freq);
+		});
+		state.ghosts.reserve(_ghostMap.size());
+		_ghostList.forEachFromTail([&state](const NodePtr& node) {
+			state.ghosts.push_back(node->_key);
+		});
+		return state;
+	}
+
+	/**
+	* 清空并导入 T1 与 B1
+	*/
+	void importState(const ARCPartState<Key, Value>& state) {
+		std::lock_guard<std::mutex> lock(_mtx);
+		_nodeList.clear();
+		_nodeMap.clear();
+		_ghostList.clear();
+		_ghostMap.clear();
+		_capacity = state.capacity;
+		_ghostCapacity = state.ghostCapacity;
+		for (const auto& [key, value, freq] : state.entries) {
+			if (_nodeMap.size() >= static_cast<size_t>(_capacity) || _nodeMap.count(key)) continue;
+			NodePtr node = std::make_shared<Node>(key, value, freq);
+			_nodeMap[key] = node;
+			_nodeList.headInsert(node);
+		}
+		for (const auto& key : state.ghosts) {
+			if (_ghostMap.size() >= static_cast<size_t>(_ghostCapacity) || _ghostMap.count(key)) continue;
+			NodePtr node = std::make_shared<Node>(key, Value{});
+			_ghostMap[key] = node;
+			_ghostList.headInsert(node);
+		}
+	}
+
 	/**
 	* 从LRU读取缓存
 	*/
@@ -113,32 +274,62 @@ public:
 			removeFromList(node);
 			shouldTransform = updateNodeAccess(node);
 			// 如果达到阈值，应该加入到LFU，用 shouldTransform 进行标识，然后从LRU删除，交给 ARCCache 处理
+			value = node->_value;
 			if (shouldTransform) {
 				_nodeMap.erase(key);
 				return true;
 			}
 			_nodeList.headInsert(node);
-			value = node->_value;
 			return true;
 		}
 		// Node 不存在
 		return false;
 	}
+
+	/**
+	* 从LRU读取缓存，返回引用节点的 handle；达到阈值时与 get 一样从LRU删除，由 ARCCache 写入LFU
+	*/
+	CacheHandle<Key, Value> getHandle(Key key, bool& shouldTransform, const std::shared_ptr<PinBudget>& budget,
+		const std::function<size_t(const Value&)>& sizeOf) {
+		std::lock_guard<std::mutex> lock(_mtx);
+		auto it = _nodeMap.find(key);
+		if (it == _nodeMap.end()) {
+			return CacheHandle<Key, Value>();
+		}
+		NodePtr node = it->second;
+		removeFromList(node);
+		shouldTransform = updateNodeAccess(node);
+		if (shouldTransform) {
+			_nodeMap.erase(it);
+		}
+		else {
+			_nodeList.headInsert(node);
+		}
+		bool pinned = budget->pin(node->_pin, [&node, &sizeOf]() { return sizeOf ? sizeOf(node->_value) : sizeof(Value); });
+		return CacheHandle<Key, Value>(node, node->_key, node->_value, pinned ? &node->_pin : nullptr, budget);
+	}
 	
 	/**
 	* 向LRU写入缓存
 	*/
 	bool put(Key key, Value value, bool& shouldTransform) {
-		if (_capacity <= 0) return false;
 		// 加锁
 		std::lock_guard<std::mutex> lock(_mtx);
+		if (_capacity <= 0) return false;
 		// 查找 Node
 		auto it = _nodeMap.find(key);
 		if (it != _nodeMap.end()) {
 			// Node 存在，更新频数，添加到节点头部
-			NodePtr node = _nodeMap[key];
-			node->_value = value;
+			NodePtr node = it->second;
 			removeFromList(node);
+			if (node->_pin.pinned()) {
+				// 被 handle 引用的节点不在原地修改值，换成新节点，旧节点由 handle 保留
+				node = std::make_shared<Node>(key, value, node->_freq);
+				it->second = node;
+			}
+			else {
+				node->_value = value;
+			}
 			shouldTransform = updateNodeAccess(node);
 			// 如果达到阈值，应该加入到LFU，用 shouldTransform 进行标识，然后从LRU删除，交给 ARCCache 处理
 			if (shouldTransform) {
@@ -148,9 +339,9 @@ public:
 			_nodeList.headInsert(node);
 			return true;
 		}
-		// Cache 已满，删除最近最久未使用节点
-		if (_nodeMap.size() >= _capacity) {
-			kickOut();
+		// Cache 已满，删除最近最久未使用节点；全部被 pin 时暂时超出容量，之后由 trim 淘汰回来
+		if (_nodeMap.size() >= _capacity && kickOut()) {
+			++_evictionStats.inlineEvictions;
 		}
 		// Node 不存在，创建新 Node 并插入链表头部，在 Map 中添加记录
 		NodePtr newNode = std::make_shared<Node>(key, value);
@@ -167,7 +358,7 @@ class ARC_LFUCache {
 	using NodeMap = std::unordered_map<Key, NodePtr>;
 	using List = HashLink<Key, Value>;
 	using FreqPtr = std::unique_ptr<List>;
-	using FreqMap = std::map<Key, FreqPtr>;
+	using FreqMap = std::map<int, FreqPtr>;
 
 	std::mutex _mtx;
 	int _transformThreshold;
@@ -180,6 +371,9 @@ class ARC_LFUCache {
 	int _ghostCapacity;
 	NodeMap _ghostMap;
 	List _ghostList;
+	EvictionStats _evictionStats;
+	// 主缓存淘汰（进入 ghost）时在锁内调用
+	std::function<void(const Key&)> _onEvict;
 
 	void insertToFreqList(NodePtr node) {
 		if (_freqListMap.find(node->_freq) == _freqListMap.end()) {
@@ -201,17 +395,38 @@ class ARC_LFUCache {
 		}
 	}
 
-	void kickOut() {
-		// 判空
-		if (_freqListMap.empty()) return;
+	/**
+	* 频数链表按频数有序，第一个非空链表即最小频数；连续淘汰前调用
+	*/
+	void updateMinFreq() {
+		for (auto& pair : _freqListMap) {
+			if (!pair.second->isEmpty()) {
+				_minFreqCount = pair.first;
+				break;
+			}
+		}
+	}
 
-		if (_freqListMap[_minFreqCount]->isEmpty()) return;
+	/**
+	* 删除频数最小、同频数中最久未访问的节点，跳过被 pin 的节点；全部被 pin 时返回 false
+	*/
+	bool kickOut() {
+		// 判空
+		if (_freqListMap.empty()) return false;
 
-		// 从主缓存 链表 删除最少使用节点
-		auto removedNode = _freqListMap[_minFreqCount]->tailRemove().lock();
-		if (_freqListMap[_minFreqCount]->isEmpty()) {
-			++_minFreqCount;
+		// 从主缓存 链表 删除最少使用节点；最小频数链表全部被 pin 时继续找更高的频数
+		NodePtr removedNode;
+		for (auto it = _freqListMap.lower_bound(_minFreqCount); it != _freqListMap.end(); ++it) {
+			removedNode = it->second->findFromTail([](const NodePtr& node) { return !node->_pin.pinned(); });
+			if (removedNode) {
+				it->second->nodeRemove(removedNode);
+				if (it->first == _minFreqCount && it->second->isEmpty()) {
+					++_minFreqCount;
+				}
+				break;
+			}
 		}
+		if (!removedNode) return false;
 
 		// 节点添加到 ghost
 		if (_ghostMap.size() >= _ghostCapacity) {
@@ -228,6 +443,8 @@ class ARC_LFUCache {
 		_ghostMap[removedNode->_key] = removedNode;
 		// 从主缓存 Map 删除
 		_nodeMap.erase(removedNode->_key);
+		if (_onEvict) _onEvict(removedNode->_key);
+		return true;
 	}
 
 	void removeFromList(NodePtr node) {
@@ -243,10 +460,48 @@ public:
 		, _transformThreshold(transformThreshold)
 		, _minFreqCount(0) {}
 
+	/**
+	* 主缓存中是否有 key
+	*/
+	bool contains(Key key) {
+		std::lock_guard<std::mutex> lock(_mtx);
+		return _nodeMap.find(key) != _nodeMap.end();
+	}
+
+	/**
+	* 从主缓存与 ghost 中删除 key，返回主缓存中是否有它
+	*/
+	bool remove(Key key) {
+		std::lock_guard<std::mutex> lock(_mtx);
+		auto ghost = _ghostMap.find(key);
+		if (ghost != _ghostMap.end()) {
+			removeFromList(ghost->second);
+			_ghostMap.erase(ghost);
+		}
+		auto it = _nodeMap.find(key);
+		if (it == _nodeMap.end()) return false;
+		NodePtr node = it->second;
+		auto list = _freqListMap.find(node->_freq);
+		if (list != _freqListMap.end()) {
+			list->second->nodeRemove(node);
+			// 最小频数链表删空后重新定位，否则 kickOut 找不到可淘汰的节点
+			if (node->_freq == _minFreqCount && list->second->isEmpty()) updateMinFreq();
+		}
+		_nodeMap.erase(it);
+		return true;
+	}
+
+	/**
+	* 设置淘汰回调，需在并发访问开始前调用
+	*/
+	void setEvictionCallback(std::function<void(const Key&)> onEvict) { _onEvict = std::move(onEvict); }
+
 	/**
 	* 检查 key 是否在 ghost 中，在的话删除并返回true，否则返回false
 	*/
 	bool checkGhost(Key key) {
+		// 后台淘汰线程会并发修改 ghost 链表，这里也需要加锁
+		std::lock_guard<std::mutex> lock(_mtx);
 		auto it = _ghostMap.find(key);
 		if (it == _ghostMap.end()) {
 			return false;
@@ -261,12 +516,14 @@ public:
 	* Cache 扩容
 	*/
 	void expandCapacity() {
+		std::lock_guard<std::mutex> lock(_mtx);
 		++_capacity;
 	}
 	/**
 	* Cache 缩容
 	*/
 	bool shrinkCapacity() {
+		std::lock_guard<std::mutex> lock(_mtx);
 		if (_capacity <= 0) return false;
 		if (_nodeMap.size() >= _capacity) {
 			kickOut();
@@ -276,6 +533,110 @@ public:
 		return true;
 	}
 	
+	int getCapacity() {
+		std::lock_guard<std::mutex> lock(_mtx);
+		return _capacity;
+	}
+	/**
+	* 设置主缓存与 ghost 的容量，超出的部分由 trim 分批淘汰
+	*/
+	void setCapacity(int capacity, int ghostCapacity) {
+		std::lock_guard<std::mutex> lock(_mtx);
+		_capacity = capacity > 0 ? capacity : 0;
+		_ghostCapacity = ghostCapacity > 0 ? ghostCapacity : 0;
+	}
+	/**
+	* 最多淘汰 maxEvictions 个超出容量的条目（主缓存淘汰进入 ghost），返回是否仍超出容量
+	*/
+	bool trim(size_t maxEvictions) {
+		std::lock_guard<std::mutex> lock(_mtx);
+		size_t evicted = 0;
+		// 剩下的条目都被 pin 时停止，等 handle 释放后再淘汰
+		bool blocked = false;
+		for (; evicted < maxEvictions && _nodeMap.size() > static_cast<size_t>(_capacity); ++evicted) {
+			updateMinFreq();
+			if (!kickOut()) {
+				blocked = true;
+				break;
+			}
+		}
+		for (; evicted < maxEvictions && _ghostMap.size() > static_cast<size_t>(_ghostCapacity); ++evicted) {
+			auto removedGhost = _ghostList.tailRemove().lock();
+			if (!removedGhost) break;
+			_ghostMap.erase(removedGhost->_key);
+		}
+		return (!blocked && _nodeMap.size() > static_cast<size_t>(_capacity)) || _ghostMap.size() > static_cast<size_t>(_ghostCapacity);
+	}
+	/**
+	* 最多淘汰 maxEvictions 个条目（进入 ghost），使主缓存至少留出 headroom 个空位，返回是否仍然不足
+	*/
+	bool evictToHeadroom(size_t headroom, size_t maxEvictions) {
+		std::lock_guard<std::mutex> lock(_mtx);
+		size_t capacity = _capacity > 0 ? static_cast<size_t>(_capacity) : 0;
+		size_t limit = capacity > headroom ? capacity - headroom : 0;
+		size_t evicted = 0;
+		for (; evicted < maxEvictions && _nodeMap.size() > limit; ++evicted) {
+			updateMinFreq();
+			if (!kickOut()) return false;
+		}
+		_evictionStats.backgroundEvictions += evicted;
+		return _nodeMap.size() > limit;
+	}
+	EvictionStats getEvictionStats() {
+		std::lock_guard<std::mutex> lock(_mtx);
+		return _evictionStats;
+	}
+
+	/**
+	* 导出 T2 与 B2：按频数从高到低，同一频数内从最久到最近
+	*/
+	ARCPartState<Key, Value> exportState() {
+		std::lock_guard<std::mutex> lock(_mtx);
+		ARCPartState<Key, Value> state;
+		state.capacity = _capacity;
+		state.ghostCapacity = _ghostCapacity;
+		state.entries.reserve(_nodeMap.size());
+		for (auto it = _freqListMap.rbegin(); it != _freqListMap.rend(); ++it) {
+			it->second->forEachFromTail([&state](const NodePtr& node) {
+				state.entries.emplace_back(node->_key, node->_value, node->_freq);
+			});
+		}
+		state.ghosts.reserve(_ghostMap.size());
+		_ghostList.forEachFromTail([&state](const NodePtr& node) {
+			state.ghosts.push_back(node->_key);
+		});
+		return state;
+	}
+
+	/**
+	* 清空并导入 T2 与 B2
+	*/
+	void importState(const ARCPartState<Key, Value>& state) {
+		std::lock_guard<std::mutex> lock(_mtx);
+		_freqListMap.clear();
+		_nodeMap.clear();
+		_ghostList.clear();
+		_ghostMap.clear();
+		_capacity = state.capacity;
+		_ghostCapacity = state.ghostCapacity;
+		_minFreqCount = 0;
+		for (const auto& [key, value, freq] : state.entries) {
+			if (_nodeMap.size() >= static_cast<size_t>(_capacity) || _nodeMap.count(key)) continue;
+			NodePtr node = std::make_shared<Node>(key, value, freq < 1 ? 1 : freq);
+			_nodeMap[key] = node;
+			insertToFreqList(node);
+			if (_minFreqCount == 0 || node->_freq < _minFreqCount) {
+				_minFreqCount = node->_freq;
+			}
+		}
+		for (const auto& key : state.ghosts) {
+			if (_ghostMap.size() >= static_cast<size_t>(_ghostCapacity) || _ghostMap.count(key)) continue;
+			NodePtr node = std::make_shared<Node>(key, Value{});
+			_ghostMap[key] = node;
+			_ghostList.headInsert(node);
+		}
+	}
+
 	/**
 	* 读取缓存
 	*/
@@ -295,28 +656,51 @@ public:
 		insertToFreqList(node);
 		return true;
 	}
+
+	/**
+	* 读取缓存，返回引用节点的 handle
+	*/
+	CacheHandle<Key, Value> getHandle(Key key, const std::shared_ptr<PinBudget>& budget, const std::function<size_t(const Value&)>& sizeOf) {
+		std::lock_guard<std::mutex> lock(_mtx);
+		auto it = _nodeMap.find(key);
+		if (it == _nodeMap.end()) {
+			return CacheHandle<Key, Value>();
+		}
+		NodePtr node = it->second;
+		removeFromFreqList(node);
+		++node->_freq;
+		insertToFreqList(node);
+		bool pinned = budget->pin(node->_pin, [&node, &sizeOf]() { return sizeOf ? sizeOf(node->_value) : sizeof(Value); });
+		return CacheHandle<Key, Value>(node, node->_key, node->_value, pinned ? &node->_pin : nullptr, budget);
+	}
 	
 	/**
 	* 写入缓存
 	*/
 	bool put(Key key, Value value) {
-		if (_capacity <= 0) return false;
-
 		std::lock_guard<std::mutex> lock(_mtx);
+		if (_capacity <= 0) return false;
 		auto it = _nodeMap.find(key);
 		if (it != _nodeMap.end()) {
 			// Node 存在更新值
 			auto node = it->second;
-			node->_value = value;
 			removeFromFreqList(node);
+			if (node->_pin.pinned()) {
+				// 被 handle 引用的节点不在原地修改值，换成新节点，旧节点由 handle 保留
+				node = std::make_shared<Node>(key, value, node->_freq);
+				it->second = node;
+			}
+			else {
+				node->_value = value;
+			}
 			++node->_freq;
 			insertToFreqList(node);
 			return true;
 		}
 		// Node 存在
-		if (_nodeMap.size() >= _capacity) {
-			// Cache 已满，删除最近最少被使用节点
-			kickOut();
+		if (_nodeMap.size() >= _capacity && kickOut()) {
+			// Cache 已满，删除最近最少被使用节点；全部被 pin 时暂时超出容量，之后由 trim 淘汰回来
+			++_evictionStats.inlineEvictions;
 		}
 		// 创建新节点并插入缓存
 		NodePtr newNode = std::make_shared<ARCNode<Key, Value>>(key, value);
@@ -330,10 +714,27 @@ public:
 
 template<typename Key, typename Value>
 class ARCCache {
-	int _capacity;
+	std::atomic<int> _capacity;
+	// 串行化 setCapacity 与 loadSnapshot
+	std::mutex _resizeMutex;
+	// LRU 与 LFU 的容量拆分：ghost 命中引起的容量转移持有共享锁，setCapacity 与快照读写持有独占锁，
+	// 因此读到的两部分容量之和总是等于 _capacity。加锁顺序为 _resizeMutex -> _splitMutex -> 部分
+	std::shared_mutex _splitMutex;
 	int _transformThreshold;
 	std::unique_ptr<ARC_LRUCache<Key, Value>> _LRU;
 	std::unique_ptr<ARC_LFUCache<Key, Value>> _LFU;
+	// 可选的写入门卫，为空时所有 put 都写入
+	std::shared_ptr<Doorkeeper> _doorkeeper;
+	// tag 与 key 前缀的二级索引。两部分淘汰时在各自的锁内通过回调删除记录，加锁顺序为 部分 -> _tagMutex；
+	// 没有用过标签和前缀索引时 _tagsActive 为 false，淘汰回调不加锁
+	std::mutex _tagMutex;
+	TagIndex<Key> _tagIndex;
+	std::atomic<bool> _tagsActive{ false };
+	// getHandle 的 pin 预算，两部分共享；_pinSizeOf 为空时按 sizeof(Value) 计
+	std::shared_ptr<PinBudget> _pinBudget = std::make_shared<PinBudget>();
+	std::function<size_t(const Value&)> _pinSizeOf;
+	// 后台淘汰线程，最后声明，析构时最先停止
+	std::unique_ptr<BackgroundEvictor> _evictor;
 	
 	/**
 	* 检查所查值是否在 Ghost 中，在的话扩容对应缓存部分
@@ -343,12 +744,14 @@ class ARCCache {
 		// 检查是否在 Ghost
 		if (_LRU->checkGhost(key)) {
 			// 先缩容再扩容
+			std::shared_lock<std::shared_mutex> lock(_splitMutex);
 			if (_LFU->shrinkCapacity()) {
 				_LRU->expandCapacity();
 			}
 			inGhost = true;
 		}
 		else if (_LFU->checkGhost(key)) {
+			std::shared_lock<std::shared_mutex> lock(_splitMutex);
 			if (_LRU->shrinkCapacity()) {
 				_LFU->expandCapacity();
 			}
@@ -357,16 +760,144 @@ class ARCCache {
 		return inGhost;
 	}
 
+	/**
+	* put 的主体，返回是否写入（门卫拒绝或容量为 0 时为 false）
+	*/
+	bool putEntry(const Key& key, const Value& value) {
+		bool shouldTransform = false;
+		bool written;
+		if (_LRU->checkGhost(key)) {
+			written = _LRU->put(key, value, shouldTransform);
+			if (written && shouldTransform) {
+				_LFU->put(key, value);
+			}
+		}else if(_LFU->checkGhost(key)){
+			written = _LFU->put(key, value);
+		}
+		else {
+			// 门卫：既不在缓存也不在 ghost 中、且窗口内第一次出现的 key 不写入
+			if (_doorkeeper && !_LRU->contains(key) && !_LFU->contains(key) && !_doorkeeper->admit(key)) {
+				return false;
+			}
+			written = _LRU->put(key, value, shouldTransform);
+			if (written && shouldTransform) {
+				_LFU->put(key, value);
+			}
+		}
+		if (written && _tagsActive.load(std::memory_order_relaxed)) {
+			std::lock_guard<std::mutex> lock(_tagMutex);
+			_tagIndex.track(key);
+		}
+		return written;
+	}
+
+	void onEvict(const Key& key) {
+		if (!_tagsActive.load(std::memory_order_relaxed)) return;
+		std::lock_guard<std::mutex> lock(_tagMutex);
+		_tagIndex.erase(key);
+	}
+
+	// 每批在 _tagMutex 内从索引取出最多 batch 个 key，释放后再逐个从两部分删除
+	template<typename Take>
+	size_t invalidateBatches(Take take) {
+		size_t removed = 0;
+		CacheResize::runInBatches([&](size_t batch) {
+			std::vector<Key> keys;
+			{
+				std::lock_guard<std::mutex> lock(_tagMutex);
+				keys = take(batch);
+			}
+			for (const Key& key : keys) {
+				// 不能短路：key 从 LRU 提升到 LFU 的过程中可能短暂地两边都有
+				if (_LRU->remove(key) | _LFU->remove(key)) ++removed;
+			}
+			return keys.size() == batch;
+		});
+		return removed;
+	}
+
 public:
+	using Handle = CacheHandle<Key, Value>;
+
 	ARCCache(int capacity, int transformThreshold) 
 		: _capacity(capacity), 
 		_transformThreshold(transformThreshold),
 		_LRU(std::make_unique<ARC_LRUCache<Key, Value>>(static_cast<int>(capacity / 2), static_cast<int>(capacity / 2), transformThreshold)),
-		_LFU(std::make_unique<ARC_LFUCache<Key, Value>>(_capacity - static_cast<int>(capacity/2), _capacity - static_cast<int>(capacity / 2), transformThreshold))
-	{}
+		_LFU(std::make_unique<ARC_LFUCache<Key, Value>>(capacity - static_cast<int>(capacity / 2), capacity - static_cast<int>(capacity / 2), transformThreshold))
+	{
+		_LRU->setEvictionCallback([this](const Key& key) { onEvict(key); });
+		_LFU->setEvictionCallback([this](const Key& key) { onEvict(key); });
+	}
 
 	~ARCCache() = default;
 
+	/**
+	* 运行时调整总容量：按当前自适应比例拆分给 LRU 与 LFU 两部分，ghost 容量按构造时的规则重新设置，
+	* 超出的条目分批淘汰
+	*/
+	void setCapacity(int capacity) {
+		capacity = capacity > 0 ? capacity : 0;
+		std::lock_guard<std::mutex> resize(_resizeMutex);
+		{
+			std::unique_lock<std::shared_mutex> lock(_splitMutex);
+			int lruCapacity = _LRU->getCapacity();
+			int total = lruCapacity + _LFU->getCapacity();
+			int newLru = total > 0 ? static_cast<int>(static_cast<long long>(capacity) * lruCapacity / total) : capacity / 2;
+			_capacity.store(capacity);
+			_LRU->setCapacity(newLru, capacity / 2);
+			_LFU->setCapacity(capacity - newLru, capacity - capacity / 2);
+		}
+		CacheResize::runInBatches([this](size_t batch) { return _LRU->trim(batch); });
+		CacheResize::runInBatches([this](size_t batch) { return _LFU->trim(batch); });
+	}
+	int getCapacity() const { return _capacity.load(); }
+
+	/**
+	* 开启后台淘汰：后台线程让 LRU 与 LFU 两部分共保持 headroom 个空余槽位（按两部分当前容量分配），
+	* put 通常不必在锁内淘汰并维护 ghost 链表；空位用完时 put 仍在锁内淘汰
+	*/
+	void enableBackgroundEviction(size_t headroom, std::chrono::milliseconds interval = std::chrono::milliseconds(1)) {
+		_evictor.reset();
+		_evictor = std::make_unique<BackgroundEvictor>([this, headroom](size_t batch) { return maintain(headroom, batch); }, interval);
+	}
+	void disableBackgroundEviction() {
+		_evictor.reset();
+	}
+	/**
+	* 执行一批维护，返回是否还有部分空位不足
+	*/
+	bool maintain(size_t headroom, size_t maxEvictions) {
+		size_t lruCapacity = static_cast<size_t>(std::max(0, _LRU->getCapacity()));
+		size_t lfuCapacity = static_cast<size_t>(std::max(0, _LFU->getCapacity()));
+		size_t total = lruCapacity + lfuCapacity;
+		size_t lruHeadroom = total > 0 ? headroom * lruCapacity / total : 0;
+		bool remaining = _LRU->evictToHeadroom(lruHeadroom, maxEvictions);
+		remaining |= _LFU->evictToHeadroom(headroom - lruHeadroom, maxEvictions);
+		return remaining;
+	}
+	/**
+	* 开启写入门卫，windowSize 为 0 时取容量的 4 倍；需在并发访问开始前调用。
+	* 在 ghost 中的 key 说明近期出现过，直接写入
+	*/
+	void enableDoorkeeper(size_t windowSize = 0, double falsePositiveRate = 0.01) {
+		if (windowSize == 0) {
+			int capacity = _capacity.load();
+			windowSize = static_cast<size_t>(capacity > 0 ? capacity : 1) * 4;
+		}
+		_doorkeeper = std::make_shared<Doorkeeper>(windowSize, falsePositiveRate);
+	}
+	void disableDoorkeeper() {
+		_doorkeeper.reset();
+	}
+	Doorkeeper::Stats getDoorkeeperStats() const {
+		return _doorkeeper ? _doorkeeper->getStats() : Doorkeeper::Stats();
+	}
+	EvictionStats getEvictionStats() {
+		EvictionStats lru = _LRU->getEvictionStats();
+		EvictionStats lfu = _LFU->getEvictionStats();
+		return EvictionStats{ lru.inlineEvictions + lfu.inlineEvictions, lru.backgroundEvictions + lfu.backgroundEvictions };
+	}
+
 	bool get(Key key, Value& value) {
 		checkGhostCaches(key);
 
@@ -385,21 +916,163 @@ public:
 		get(key, v);
 		return v;
 	}
+	/**
+	* 零拷贝读取：返回引用缓存节点的 handle，未命中时 handle 为空。
+	* pin 成功的条目在 handle 释放前不会被淘汰；超出 pin 预算时 handle 持有值的拷贝
+	*/
+	Handle getHandle(Key key) {
+		checkGhostCaches(key);
 
-	void put(Key key, Value value) {
 		bool shouldTransform = false;
-		if (_LRU->checkGhost(key)) {
-			if (_LRU->put(key, value, shouldTransform)) {
-				if (shouldTransform) {
-					_LFU->put(key, value);
-				}
+		Handle handle = _LRU->getHandle(key, shouldTransform, _pinBudget, _pinSizeOf);
+		if (handle) {
+			// 与 get 一样，达到阈值时以取出的值写入 LFU；handle 仍引用已离开 LRU 的原节点
+			if (shouldTransform) {
+				_LFU->put(key, handle.value());
 			}
-		}else if(_LFU->checkGhost(key)){
-			_LFU->put(key, value);
+			return handle;
 		}
-		else {
-			_LRU->put(key, value);
+		return _LFU->getHandle(key, _pinBudget, _pinSizeOf);
+	}
+	/**
+	* 设置 pin 预算：被 handle pin 住的条目最多占用 maxBytes 字节，sizeOf 为空时每个条目按 sizeof(Value) 计。
+	* 需在并发访问开始前调用，已发出的 handle 仍归还到原来的预算
+	*/
+	void setPinLimit(size_t maxBytes, std::function<size_t(const Value&)> sizeOf = nullptr) {
+		_pinBudget = std::make_shared<PinBudget>(maxBytes);
+		_pinSizeOf = std::move(sizeOf);
+	}
+	PinBudget::Stats getPinStats() const {
+		return _pinBudget->getStats();
+	}
+
+	void put(Key key, Value value) {
+		putEntry(key, value);
+	}
+	/**
+	* 写入并用 tags 替换 key 原有的标签；不带 tags 的 put 保留原有标签。
+	* 写入与记录标签之间如果 key 恰好被淘汰，会留下一条无效记录，失效该 tag 时跳过
+	*/
+	void put(Key key, Value value, const std::vector<std::string>& tags) {
+		_tagsActive.store(true, std::memory_order_relaxed);
+		if (!putEntry(key, value)) return;
+		std::lock_guard<std::mutex> lock(_tagMutex);
+		_tagIndex.setTags(key, tags);
+	}
+
+	/**
+	* 从缓存与 ghost 中删除 key，返回缓存中是否有它
+	*/
+	bool remove(Key key) {
+		bool removed = _LRU->remove(key) | _LFU->remove(key);
+		onEvict(key);
+		return removed;
+	}
+
+	/**
+	* 删除所有带 tag 的条目，返回删除数量；每批最多 kEvictBatch 个，批次之间释放锁
+	*/
+	size_t invalidateTag(const std::string& tag) {
+		return invalidateBatches([this, &tag](size_t batch) { return _tagIndex.takeTag(tag, batch); });
+	}
+	/**
+	* 删除所有 key 以 prefix 开头的条目（仅 std::string key）。
+	* 首次调用时建立前缀索引，之后每次写入都要在 _tagMutex 内记录 key
+	*/
+	size_t invalidatePrefix(std::string_view prefix) {
+		enablePrefixIndex();
+		return invalidateBatches([this, prefix](size_t batch) { return _tagIndex.takePrefix(prefix, batch); });
+	}
+	void enablePrefixIndex() {
+		{
+			std::lock_guard<std::mutex> lock(_tagMutex);
+			if (_tagIndex.prefixEnabled()) return;
+			// 先开启再补录现有 key，补录期间的写入由 putEntry 自行记录
+			_tagIndex.enablePrefix(std::vector<Key>());
+			_tagsActive.store(true, std::memory_order_relaxed);
+		}
+		std::vector<Key> keys;
+		for (const auto& part : { _LRU->exportState(), _LFU->exportState() }) {
+			for (const auto& entry : part.entries) keys.push_back(std::get<0>(entry));
 		}
+		std::lock_guard<std::mutex> lock(_tagMutex);
+		for (const Key& key : keys) _tagIndex.track(key);
+	}
+
+	/**
+	* 保存 T1/B1/T2/B2 以及两部分当前的自适应容量
+	*/
+	bool saveSnapshot(const std::string& path) {
+		ARCPartState<Key, Value> lru, lfu;
+		{
+			// 两部分在同一次拆分下导出，容量之和等于总容量
+			std::unique_lock<std::shared_mutex> split(_splitMutex);
+			lru = _LRU->exportState();
+			lfu = _LFU->exportState();
+		}
+		SnapshotWriter writer(path, SnapshotKind::ARC);
+		for (auto* part : { &lru, &lfu }) {
+			writer.beginSection(SnapshotSection::Meta, 2);
+			writer.writeRecord(static_cast<int32_t>(part->capacity));
+			writer.writeRecord(static_cast<int32_t>(part->ghostCapacity));
+			writer.beginSection(SnapshotSection::Entries, part->entries.size());
+			for (const auto& [key, value, freq] : part->entries) {
+				writer.write(key);
+				writer.write(value);
+				writer.writeRecord(static_cast<int32_t>(freq));
+			}
+			writer.beginSection(SnapshotSection::Ghosts, part->ghosts.size());
+			for (const auto& key : part->ghosts) {
+				writer.writeRecord(key);
+			}
+		}
+		return writer.finish();
+	}
+
+	bool loadSnapshot(const std::string& path) {
+		SnapshotReader reader;
+		if (!reader.open(path, SnapshotKind::ARC)) return false;
+		ARCPartState<Key, Value> parts[2];
+		for (auto& part : parts) {
+			uint64_t count = 0;
+			int32_t capacity = 0, ghostCapacity = 0;
+			if (!reader.beginSection(SnapshotSection::Meta, count) || count != 2
+				|| !reader.read(capacity) || !reader.read(ghostCapacity)) return false;
+			part.capacity = capacity;
+			part.ghostCapacity = ghostCapacity;
+			if (!reader.beginSection(SnapshotSection::Entries, count) || count > reader.remaining()) return false;
+			part.entries.reserve(static_cast<size_t>(count));
+			for (uint64_t i = 0; i < count; ++i) {
+				Key key{};
+				Value value{};
+				int32_t freq = 0;
+				if (!reader.read(key) || !reader.read(value) || !reader.read(freq)) return false;
+				part.entries.emplace_back(std::move(key), std::move(value), freq);
+			}
+			if (!reader.beginSection(SnapshotSection::Ghosts, count) || count > reader.remaining()) return false;
+			part.ghosts.reserve(static_cast<size_t>(count));
+			for (uint64_t i = 0; i < count; ++i) {
+				Key key{};
+				if (!reader.read(key)) return false;
+				part.ghosts.push_back(std::move(key));
+			}
+		}
+		if (!reader.atEnd()) return false;
+		std::lock_guard<std::mutex> resize(_resizeMutex);
+		{
+			// 两部分容量之和必须与当前缓存一致，否则视为不兼容的快照
+			std::unique_lock<std::shared_mutex> split(_splitMutex);
+			if (parts[0].capacity + parts[1].capacity != _capacity.load()) return false;
+			_LRU->importState(parts[0]);
+			_LFU->importState(parts[1]);
+		}
+		// 快照不带标签；前缀索引按导入的 key 重建
+		std::lock_guard<std::mutex> lock(_tagMutex);
+		_tagIndex.clear();
+		for (const auto& part : parts) {
+			for (const auto& entry : part.entries) _tagIndex.track(std::get<0>(entry));
+		}
+		return true;
 	}
 };
 
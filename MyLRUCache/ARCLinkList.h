@@ -21,6 +21,9 @@ public:
 		_head->_next = _tail;
 		_tail->_prev = _head;
 	}
+	~HashLink() { clear(); }
+	HashLink(const HashLink&) = delete;
+	HashLink& operator=(const HashLink&) = delete;
 	void headInsert(NodePtr node) {
 		node->_next = _head->_next;
 		node->_prev = _head;
@@ -58,6 +61,39 @@ public:
 	bool isEmpty() {
 		return _head->_next == _tail;
 	}
+	/**
+	* 从尾部向头部找第一个满足 pred 的节点，没有时返回空
+	*/
+	template<typename Pred>
+	NodePtr findFromTail(Pred pred) {
+		for (NodePtr node = _tail->_prev.lock(); node != _head; node = node->_prev.lock()) {
+			if (pred(node)) return node;
+		}
+		return nullptr;
+	}
+	/**
+	* 从尾部（最久）向头部（最近）遍历
+	*/
+	template<typename Fn>
+	void forEachFromTail(Fn fn) {
+		for (NodePtr node = _tail->_prev.lock(); node != _head; node = node->_prev.lock()) {
+			fn(node);
+		}
+	}
+	/**
+	* 逐个断开所有节点，避免 shared_ptr 链递归析构
+	*/
+	void clear() {
+		NodePtr node = _head->_next;
+		while (node && node != _tail) {
+			NodePtr next = node->_next;
+			node->_prev.reset();
+			node->_next.reset();
+			node = next;
+		}
+		_head->_next = _tail;
+		_tail->_prev = _head;
+	}
 };
 
 #endif // ARCLINKLIST_H
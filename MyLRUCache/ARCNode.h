@@ -2,6 +2,7 @@
 #ifndef ARCNODE_H
 #define ARCNODE_H
 
+#include "PinnedHandle.h"
 #include <memory>
 
 template<typename Key, typename Value>
@@ -11,6 +12,8 @@ struct ARCNode {
 	int _freq;
 	std::weak_ptr<ARCNode<Key, Value>> _prev;
 	std::shared_ptr<ARCNode<Key, Value>> _next;
+	// 被 handle pin 住时不参与淘汰，值也不在原地修改
+	PinState _pin;
 
 	ARCNode(Key key, Value value, int freq = 1) 
 		: _key(key), _value(value), _freq(freq), _next(nullptr) {}
@@ -0,0 +1,321 @@
+#pragma once
+#ifndef ADAPTIVECACHE_H
+#define ADAPTIVECACHE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/****************************************
+WindowedSegments
+
+AdaptiveCache 的淘汰结构，非线程安全。条目分在两个 LRU 段中：
+	window 段：新 key 先进入这里，纯按最近访问淘汰；
+	main   段：window 段溢出的条目要和 main 段的 LRU 条目比较访问次数，次数多的留在 main。
+window 占比越大越接近 LRU，越小越偏向按频率保留。访问次数每经过 10 倍容量次访问减半，
+让过去的热点逐渐失去优势。
+****************************************/
+template<typename Key, typename Value>
+class WindowedSegments {
+public:
+	WindowedSegments(size_t capacity, double windowRatio) : _capacity(capacity) {
+		setWindowRatio(windowRatio);
+	}
+
+	size_t size() const { return _map.size(); }
+	size_t windowCapacity() const { return _windowCapacity; }
+
+	/**
+	* 命中时返回指向 value 的指针并更新访问次数与位置，未命中返回 nullptr
+	*/
+	Value* access(const Key& key) {
+		tick();
+		auto it = _map.find(key);
+		if (it == _map.end()) return nullptr;
+		Position& pos = it->second;
+		if (pos.entry->freq < kMaxFreq) ++pos.entry->freq;
+		std::list<Entry>& segment = pos.inWindow ? _window : _main;
+		segment.splice(segment.begin(), segment, pos.entry);
+		return &pos.entry->value;
+	}
+
+	/**
+	* 插入新 key（调用者保证 key 不存在）
+	*/
+	void insert(const Key& key, const Value& value) {
+		if (_capacity == 0) return;
+		_window.push_front(Entry{ key, value, 1 });
+		_map[key] = Position{ _window.begin(), true };
+		if (_window.size() > _windowCapacity) {
+			demoteWindowTail();
+		}
+	}
+
+	bool erase(const Key& key) {
+		auto it = _map.find(key);
+		if (it == _map.end()) return false;
+		(it->second.inWindow ? _window : _main).erase(it->second.entry);
+		_map.erase(it);
+		return true;
+	}
+
+	/**
+	* 调整 window 占比，条目在两段之间挪动，不丢弃任何条目
+	*/
+	void setWindowRatio(double ratio) {
+		ratio = std::clamp(ratio, 0.0, 1.0);
+		_windowCapacity = std::max<size_t>(1, static_cast<size_t>(static_cast<double>(_capacity) * ratio + 0.5));
+		if (_windowCapacity > _capacity) _windowCapacity = _capacity;
+		size_t mainCapacity = _capacity - _windowCapacity;
+		while (_window.size() > _windowCapacity) {
+			moveTail(_window, _main, true, false);
+		}
+		while (_main.size() > mainCapacity) {
+			// main 段缩小时，多出的条目排到 window 的末尾，下一次溢出时重新参与比较
+			moveTail(_main, _window, false, true);
+		}
+	}
+
+private:
+	static constexpr uint32_t kMaxFreq = 255;
+
+	struct Entry {
+		Key key;
+		Value value;
+		uint32_t freq;
+	};
+	struct Position {
+		typename std::list<Entry>::iterator entry;
+		bool inWindow;
+	};
+
+	void tick() {
+		if (++_accesses < _capacity * 10) return;
+		_accesses = 0;
+		for (Entry& entry : _window) entry.freq >>= 1;
+		for (Entry& entry : _main) entry.freq >>= 1;
+	}
+
+	/**
+	* window 溢出：main 未满时直接进入 main，否则与 main 的 LRU 条目比较访问次数，淘汰较少的一个
+	*/
+	void demoteWindowTail() {
+		size_t mainCapacity = _capacity - _windowCapacity;
+		if (_main.size() < mainCapacity) {
+			moveTail(_window, _main, true, false);
+			return;
+		}
+		if (mainCapacity == 0 || _window.back().freq <= _main.back().freq) {
+			evictTail(_window);
+			return;
+		}
+		evictTail(_main);
+		moveTail(_window, _main, true, false);
+	}
+
+	void moveTail(std::list<Entry>& from, std::list<Entry>& to, bool toFront, bool toWindow) {
+		auto entry = std::prev(from.end());
+		to.splice(toFront ? to.begin() : to.end(), from, entry);
+		_map[entry->key].inWindow = toWindow;
+	}
+
+	void evictTail(std::list<Entry>& segment) {
+		_map.erase(segment.back().key);
+		segment.pop_back();
+	}
+
+	size_t _capacity;
+	size_t _windowCapacity = 1;
+	size_t _accesses = 0;
+	std::list<Entry> _window;
+	std::list<Entry> _main;
+	std::unordered_map<Key, Position> _map;
+};
+
+/****************************************
+AdaptiveCache
+
+根据负载自动调节 window 占比的缓存，在“偏 LRU”和“偏 LFU”之间切换：
+按 key 哈希采样约 1/sampleRate 的访问，喂给几个不同 window 占比的影子缓存
+（只记 key，容量同比例缩小）。每个周期结束时比较各影子的命中率，
+胜者明显好于当前配置时把主缓存的 window 占比切到胜者，调整过程不丢弃条目。
+****************************************/
+template<typename Key, typename Value>
+class AdaptiveCache {
+public:
+	struct Stats {
+		double windowRatio = 0;			// 当前 window 占比
+		uint64_t epochs = 0;			// 已完成的调节周期
+		uint64_t switches = 0;			// 切换配置的次数
+		std::vector<double> candidateRatios;
+		std::vector<double> candidateHitRates;	// 最近一个周期各影子的命中率（%）
+	};
+
+	/**
+	* sampleRate 为采样间隔（约每 sampleRate 个 key 采 1 个），initialRatio 为初始 window 占比
+	*/
+	AdaptiveCache(int capacity, int sampleRate = 16, double initialRatio = 0.01)
+		: _segments(capacity > 0 ? static_cast<size_t>(capacity) : 0, initialRatio),
+		_sampleRate(sampleRate > 0 ? static_cast<uint32_t>(sampleRate) : 1) {
+		size_t shadowCapacity = std::max<size_t>(16, static_cast<size_t>(capacity > 0 ? capacity : 0) / _sampleRate);
+		_epochLength = std::max<size_t>(2000, shadowCapacity * 8);
+		for (double ratio : kCandidateRatios) {
+			_shadows.push_back(Shadow{ ratio, WindowedSegments<Key, bool>(shadowCapacity, ratio), 0 });
+		}
+		_current = closestCandidate(initialRatio);
+		_stats.windowRatio = initialRatio;
+		_stats.candidateRatios.assign(std::begin(kCandidateRatios), std::end(kCandidateRatios));
+		_stats.candidateHitRates.assign(_shadows.size(), 0.0);
+	}
+
+	bool get(Key key, Value& value) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		sample(key);
+		Value* found = _segments.access(key);
+		if (!found) return false;
+		value = *found;
+		return true;
+	}
+	Value get(Key key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+	void put(Key key, Value value) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		Value* found = _segments.access(key);
+		if (found) {
+			*found = value;
+			return;
+		}
+		_segments.insert(key, value);
+	}
+	bool remove(Key key) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _segments.erase(key);
+	}
+
+	size_t size() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _segments.size();
+	}
+	Stats getStats() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _stats;
+	}
+
+private:
+	static constexpr double kCandidateRatios[] = { 0.01, 0.1, 0.25, 0.5, 0.75, 1.0 };
+	// 胜者命中率至少高出当前配置这么多（百分点）才切换，避免在两个接近的配置间来回抖动
+	static constexpr double kSwitchMargin = 0.5;
+
+	struct Shadow {
+		double ratio;
+		WindowedSegments<Key, bool> segments;
+		size_t hits;
+	};
+
+	static size_t closestCandidate(double ratio) {
+		size_t best = 0;
+		for (size_t i = 1; i < std::size(kCandidateRatios); ++i) {
+			if (std::abs(kCandidateRatios[i] - ratio) < std::abs(kCandidateRatios[best] - ratio)) best = i;
+		}
+		return best;
+	}
+
+	bool sampled(const Key& key) const {
+		uint64_t h = static_cast<uint64_t>(std::hash<Key>()(key)) * 0x9E3779B97F4A7C15ull;
+		return (h >> 40) % _sampleRate == 0;
+	}
+
+	/**
+	* 把采样到的访问喂给所有影子，周期结束时决定主缓存的配置
+	*/
+	void sample(const Key& key) {
+		if (!sampled(key)) return;
+		for (Shadow& shadow : _shadows) {
+			if (shadow.segments.access(key)) ++shadow.hits;
+			else shadow.segments.insert(key, true);
+		}
+		if (++_sampledAccesses < _epochLength) return;
+
+		size_t winner = _current;
+		for (size_t i = 0; i < _shadows.size(); ++i) {
+			_stats.candidateHitRates[i] = _shadows[i].hits * 100.0 / static_cast<double>(_sampledAccesses);
+			if (_shadows[i].hits > _shadows[winner].hits) winner = i;
+		}
+		if (winner != _current && _stats.candidateHitRates[winner] - _stats.candidateHitRates[_current] >= kSwitchMargin) {
+			_current = winner;
+			_segments.setWindowRatio(_shadows[winner].ratio);
+			_stats.windowRatio = _shadows[winner].ratio;
+			++_stats.switches;
+		}
+		++_stats.epochs;
+		_sampledAccesses = 0;
+		for (Shadow& shadow : _shadows) shadow.hits = 0;
+	}
+
+	std::mutex _mutex;
+	WindowedSegments<Key, Value> _segments;
+	uint32_t _sampleRate;
+	size_t _epochLength;
+	size_t _sampledAccesses = 0;
+	size_t _current = 0;
+	std::vector<Shadow> _shadows;
+	Stats _stats;
+};
+
+/****************************************
+HashAdaptiveCache
+
+按 key 哈希分片的 AdaptiveCache，每个分片独立采样、独立调节
+****************************************/
+template<typename Key, typename Value>
+class HashAdaptiveCache {
+private:
+	int _capacity;
+	int _sliceNum;
+	std::vector<std::unique_ptr<AdaptiveCache<Key, Value>>> _slices;
+
+	AdaptiveCache<Key, Value>& sliceFor(const Key& key) {
+		return *_slices[std::hash<Key>()(key) % _sliceNum];
+	}
+public:
+	HashAdaptiveCache(int capacity, int sliceNum, int sampleRate = 16) : _capacity(capacity), _sliceNum(sliceNum) {
+		for (int i = 0; i < _sliceNum; ++i) {
+			_slices.push_back(std::make_unique<AdaptiveCache<Key, Value>>(_capacity / _sliceNum, sampleRate));
+		}
+	}
+	bool get(Key key, Value& value) {
+		return sliceFor(key).get(key, value);
+	}
+	Value get(Key key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+	void put(Key key, Value value) {
+		sliceFor(key).put(key, value);
+	}
+	bool remove(Key key) {
+		return sliceFor(key).remove(key);
+	}
+
+	/**
+	* 每个分片当前的配置与调节记录
+	*/
+	std::vector<typename AdaptiveCache<Key, Value>::Stats> getStats() {
+		std::vector<typename AdaptiveCache<Key, Value>::Stats> stats;
+		for (auto& slice : _slices) stats.push_back(slice->getStats());
+		return stats;
+	}
+};
+
+#endif // ADAPTIVECACHE_H
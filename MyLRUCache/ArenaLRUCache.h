@@ -0,0 +1,339 @@
+#pragma once
+#ifndef ARENALRUCACHE_H
+#define ARENALRUCACHE_H
+
+#include "SlabArena.h"
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/****************************************
+ArenaLRUCache
+
+面向 std::string 键值的 LRU：key 与 value 连续拷贝进分片自己的 SlabArena，
+节点只保存 32 位下标与长度（24 字节），哈希索引是存放节点下标的开放寻址表，
+查找时直接用 string_view 与 arena 中的字节比较。
+每个条目的元数据约为 24 字节节点 + 约 5 字节索引槽（负载因子 0.8），合计不到 32 字节。
+****************************************/
+class ArenaLRUCache {
+public:
+	/**
+	* capacity 为条目数上限；memoryLimit 为 arena 页内存上限（0 表示不限制）
+	*/
+	explicit ArenaLRUCache(int capacity, size_t memoryLimit = 0)
+		: _capacity(capacity > 0 ? static_cast<uint32_t>(capacity) : 0), _arena(memoryLimit) {
+		if (_capacity > kMaxNodes) _capacity = kMaxNodes;
+		// 条目数上限已知，一次性分配节点数组与索引，避免扩容带来的空闲容量
+		_nodes.reserve(_capacity);
+		_index.assign(indexSizeFor(_capacity), kNull);
+	}
+
+	bool get(std::string_view key, std::string& value) {
+		return visit(key, [&value](std::string_view v) { value.assign(v.data(), v.size()); });
+	}
+	std::string get(std::string_view key) {
+		std::string value;
+		get(key, value);
+		return value;
+	}
+
+	/**
+	* 命中时在持锁状态下以 string_view 形式访问 value，避免拷贝
+	*/
+	template<typename Fn>
+	bool visit(std::string_view key, Fn fn) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		uint32_t hash = hashOf(key);
+		uint32_t node = find(key, hash);
+		if (node == kNull) return false;
+		moveToTail(node);
+		fn(valueOf(node));
+		return true;
+	}
+
+	/**
+	* 写入缓存；单个条目超过 arena 最大级别或内存上限无法满足时返回 false
+	*/
+	bool put(std::string_view key, std::string_view value) {
+		if (_capacity == 0 || key.size() > UINT32_MAX || value.size() > UINT32_MAX) return false;
+		std::lock_guard<std::mutex> lock(_mutex);
+		uint32_t hash = hashOf(key);
+		uint32_t node = find(key, hash);
+		size_t bytes = key.size() + value.size();
+		if (node != kNull) {
+			ArenaNode& n = _nodes[node];
+			if (bytes > _arena.chunkSize(n.slot)) {
+				SlabArena::Ref slot = allocate(bytes, node);
+				if (slot == SlabArena::kInvalidRef) return false;
+				std::memcpy(_arena.data(slot), key.data(), key.size());
+				_arena.free(_nodes[node].slot);
+				_nodes[node].slot = slot;
+			}
+			std::memcpy(_arena.data(_nodes[node].slot) + key.size(), value.data(), value.size());
+			_nodes[node].valueLen = static_cast<uint32_t>(value.size());
+			moveToTail(node);
+			return true;
+		}
+		// 先分配再按条目数上限淘汰：分配失败时不淘汰任何条目；分配时为腾出空间淘汰过条目的，_size 已随之减少
+		SlabArena::Ref slot = allocate(bytes, kNull);
+		if (slot == SlabArena::kInvalidRef) return false;
+		if (_size >= _capacity) {
+			evict();
+		}
+		char* data = _arena.data(slot);
+		std::memcpy(data, key.data(), key.size());
+		std::memcpy(data + key.size(), value.data(), value.size());
+
+		node = newNode();
+		ArenaNode& n = _nodes[node];
+		n.hash = hash;
+		n.slot = slot;
+		n.keyLen = static_cast<uint32_t>(key.size());
+		n.valueLen = static_cast<uint32_t>(value.size());
+		linkTail(node);
+		indexInsert(node);
+		++_size;
+		return true;
+	}
+
+	bool remove(std::string_view key) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		uint32_t node = find(key, hashOf(key));
+		if (node == kNull) return false;
+		erase(node);
+		return true;
+	}
+
+	size_t size() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _size;
+	}
+
+	/**
+	* 节点数组 + 索引的字节数，不含 key/value 本身
+	*/
+	size_t metadataBytes() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _nodes.capacity() * sizeof(ArenaNode) + _index.capacity() * sizeof(uint32_t);
+	}
+	size_t arenaBytes() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _arena.pageBytes();
+	}
+
+private:
+	static constexpr uint32_t kNull = UINT32_MAX;
+
+	struct ArenaNode {
+		uint32_t prev;
+		uint32_t next;
+		uint32_t hash;
+		SlabArena::Ref slot;   // [key bytes][value bytes]
+		uint32_t keyLen;
+		uint32_t valueLen;
+	};
+	static_assert(sizeof(ArenaNode) == 24, "ArenaNode should stay compact");
+
+	static uint32_t hashOf(std::string_view key) {
+		size_t h = std::hash<std::string_view>()(key);
+		return static_cast<uint32_t>(h ^ (h >> 32));
+	}
+
+	std::string_view keyOf(uint32_t node) const {
+		return std::string_view(_arena.data(_nodes[node].slot), _nodes[node].keyLen);
+	}
+	std::string_view valueOf(uint32_t node) const {
+		return std::string_view(_arena.data(_nodes[node].slot) + _nodes[node].keyLen, _nodes[node].valueLen);
+	}
+
+	/**
+	* 分配 arena 空间，失败时从最久未使用端起淘汰同一级别的条目后重试（不会淘汰 keep 节点）。
+	* 页不在级别之间转移，淘汰其他级别的条目腾不出空间；没有同级别的条目时直接失败，不清空缓存
+	*/
+	SlabArena::Ref allocate(size_t bytes, uint32_t keep) {
+		SlabArena::Ref slot = _arena.allocate(bytes);
+		uint32_t victim = _head;
+		while (slot == SlabArena::kInvalidRef) {
+			while (victim != kNull && (victim == keep || !_arena.sameClass(_nodes[victim].slot, bytes))) {
+				victim = _nodes[victim].next;
+			}
+			if (victim == kNull) break;
+			uint32_t next = _nodes[victim].next;
+			erase(victim);
+			victim = next;
+			slot = _arena.allocate(bytes);
+		}
+		return slot;
+	}
+
+	void evict() {
+		if (_head != kNull) {
+			erase(_head);
+		}
+	}
+
+	void erase(uint32_t node) {
+		indexErase(node);
+		unlink(node);
+		_arena.free(_nodes[node].slot);
+		_nodes[node].next = _freeNodes;
+		_freeNodes = node;
+		--_size;
+	}
+
+	uint32_t newNode() {
+		if (_freeNodes != kNull) {
+			uint32_t node = _freeNodes;
+			_freeNodes = _nodes[node].next;
+			return node;
+		}
+		_nodes.push_back(ArenaNode{});
+		return static_cast<uint32_t>(_nodes.size() - 1);
+	}
+
+	// ---- 双向链表：_head 为最久未使用，_tail 为最近使用 ----
+	void linkTail(uint32_t node) {
+		_nodes[node].prev = _tail;
+		_nodes[node].next = kNull;
+		if (_tail != kNull) _nodes[_tail].next = node;
+		else _head = node;
+		_tail = node;
+	}
+	void unlink(uint32_t node) {
+		ArenaNode& n = _nodes[node];
+		if (n.prev != kNull) _nodes[n.prev].next = n.next;
+		else _head = n.next;
+		if (n.next != kNull) _nodes[n.next].prev = n.prev;
+		else _tail = n.prev;
+	}
+	void moveToTail(uint32_t node) {
+		if (node == _tail) return;
+		unlink(node);
+		linkTail(node);
+	}
+
+	// ---- 开放寻址索引（线性探测，删除时后移，不留墓碑） ----
+	// 槽位 = 6 位哈希标签 | 26 位节点下标，探测时先比较标签，不必访问节点
+	static constexpr int kNodeBits = 26;
+	static constexpr uint32_t kNodeMask = (uint32_t{ 1 } << kNodeBits) - 1;
+	static constexpr uint32_t kMaxNodes = kNodeMask;
+
+	static uint32_t slotOf(uint32_t node, uint32_t hash) { return ((hash & 0x3F) << kNodeBits) | node; }
+	// 用乘法把哈希映射到 [0, size)，索引大小不必是 2 的幂
+	size_t home(uint32_t hash) const { return static_cast<size_t>((static_cast<uint64_t>(hash) * _index.size()) >> 32); }
+	size_t nextSlot(size_t i) const { return i + 1 == _index.size() ? 0 : i + 1; }
+
+	static size_t indexSizeFor(size_t entries) { return entries * 5 / 4 + 16; }
+
+	uint32_t find(std::string_view key, uint32_t hash) const {
+		uint32_t tag = (hash & 0x3F) << kNodeBits;
+		for (size_t i = home(hash);; i = nextSlot(i)) {
+			uint32_t slot = _index[i];
+			if (slot == kNull) return kNull;
+			if ((slot & ~kNodeMask) != tag) continue;
+			uint32_t node = slot & kNodeMask;
+			if (_nodes[node].hash == hash && _nodes[node].keyLen == key.size() && keyOf(node) == key) {
+				return node;
+			}
+		}
+	}
+
+	void indexInsert(uint32_t node) {
+		// 负载因子上限 0.8
+		if ((static_cast<size_t>(_size) + 1) * 5 > _index.size() * 4) {
+			rehash(_index.size() * 2);
+		}
+		size_t i = home(_nodes[node].hash);
+		while (_index[i] != kNull) i = nextSlot(i);
+		_index[i] = slotOf(node, _nodes[node].hash);
+	}
+
+	void indexErase(uint32_t node) {
+		size_t i = home(_nodes[node].hash);
+		while ((_index[i] & kNodeMask) != node || _index[i] == kNull) i = nextSlot(i);
+		_index[i] = kNull;
+		// 把后面受影响的槽位前移，保持探测链连续
+		for (size_t j = nextSlot(i); _index[j] != kNull; j = nextSlot(j)) {
+			size_t h = home(_nodes[_index[j] & kNodeMask].hash);
+			bool movable = (i <= j) ? (h <= i || h > j) : (h <= i && h > j);
+			if (movable) {
+				_index[i] = _index[j];
+				_index[j] = kNull;
+				i = j;
+			}
+		}
+	}
+
+	void rehash(size_t newSize) {
+		std::vector<uint32_t> old;
+		old.swap(_index);
+		_index.assign(newSize, kNull);
+		for (uint32_t slot : old) {
+			if (slot == kNull) continue;
+			size_t i = home(_nodes[slot & kNodeMask].hash);
+			while (_index[i] != kNull) i = nextSlot(i);
+			_index[i] = slot;
+		}
+	}
+
+	std::mutex _mutex;
+	uint32_t _capacity;
+	uint32_t _size = 0;
+	uint32_t _head = kNull;
+	uint32_t _tail = kNull;
+	uint32_t _freeNodes = kNull;
+	std::vector<ArenaNode> _nodes;
+	std::vector<uint32_t> _index;
+	SlabArena _arena;
+};
+
+/****************************************
+HashArenaLRUCache
+
+按 key 哈希分片的 ArenaLRUCache，每个分片有独立的锁和 arena
+****************************************/
+class HashArenaLRUCache {
+private:
+	int _capacity;
+	int _sliceNum;
+	std::vector<std::unique_ptr<ArenaLRUCache>> _slices;
+
+	ArenaLRUCache& slice(std::string_view key) {
+		return *_slices[std::hash<std::string_view>()(key) % static_cast<size_t>(_sliceNum)];
+	}
+public:
+	HashArenaLRUCache(int capacity, int sliceNum, size_t memoryLimit = 0) : _capacity(capacity), _sliceNum(sliceNum) {
+		for (int i = 0; i < _sliceNum; ++i) {
+			_slices.push_back(std::make_unique<ArenaLRUCache>(_capacity / _sliceNum, memoryLimit / static_cast<size_t>(_sliceNum)));
+		}
+	}
+	bool get(std::string_view key, std::string& value) { return slice(key).get(key, value); }
+	std::string get(std::string_view key) { return slice(key).get(key); }
+	template<typename Fn>
+	bool visit(std::string_view key, Fn fn) { return slice(key).visit(key, fn); }
+	bool put(std::string_view key, std::string_view value) { return slice(key).put(key, value); }
+	bool remove(std::string_view key) { return slice(key).remove(key); }
+
+	size_t size() {
+		size_t total = 0;
+		for (auto& s : _slices) total += s->size();
+		return total;
+	}
+	size_t metadataBytes() {
+		size_t total = 0;
+		for (auto& s : _slices) total += s->metadataBytes();
+		return total;
+	}
+	size_t arenaBytes() {
+		size_t total = 0;
+		for (auto& s : _slices) total += s->arenaBytes();
+		return total;
+	}
+};
+
+#endif // ARENALRUCACHE_H
@@ -0,0 +1,365 @@
+#pragma once
+#ifndef ASYNCCACHE_H
+#define ASYNCCACHE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/****************************************
+Task
+
+惰性启动的协程任务：创建时不执行，被 co_await 时才开始，结束后通过对称转移恢复等待者。
+****************************************/
+template<typename T = void>
+class Task;
+
+namespace AsyncDetail {
+	template<typename Promise>
+	struct FinalAwaiter {
+		bool await_ready() noexcept { return false; }
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+			auto continuation = handle.promise().continuation;
+			return continuation ? continuation : std::noop_coroutine();
+		}
+		void await_resume() noexcept {}
+	};
+
+	struct PromiseBase {
+		std::coroutine_handle<> continuation;
+		std::exception_ptr error;
+
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		void unhandled_exception() { error = std::current_exception(); }
+	};
+
+	/**
+	* 启动后不被等待的协程，结束时自行销毁
+	*/
+	struct Detached {
+		struct promise_type {
+			Detached get_return_object() { return {}; }
+			std::suspend_never initial_suspend() noexcept { return {}; }
+			std::suspend_never final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+	};
+}
+
+template<typename T>
+class Task {
+public:
+	struct promise_type : AsyncDetail::PromiseBase {
+		std::optional<T> value;
+
+		Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		AsyncDetail::FinalAwaiter<promise_type> final_suspend() noexcept { return {}; }
+		void return_value(T v) { value = std::move(v); }
+	};
+
+	Task(Task&& other) noexcept : _handle(std::exchange(other._handle, {})) {}
+	Task& operator=(Task&& other) noexcept {
+		if (this != &other) {
+			if (_handle) _handle.destroy();
+			_handle = std::exchange(other._handle, {});
+		}
+		return *this;
+	}
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+	~Task() { if (_handle) _handle.destroy(); }
+
+	bool await_ready() const noexcept { return !_handle || _handle.done(); }
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+		_handle.promise().continuation = caller;
+		return _handle;
+	}
+	T await_resume() {
+		if (_handle.promise().error) std::rethrow_exception(_handle.promise().error);
+		return std::move(*_handle.promise().value);
+	}
+private:
+	explicit Task(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+	std::coroutine_handle<promise_type> _handle;
+};
+
+template<>
+class Task<void> {
+public:
+	struct promise_type : AsyncDetail::PromiseBase {
+		Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		AsyncDetail::FinalAwaiter<promise_type> final_suspend() noexcept { return {}; }
+		void return_void() {}
+	};
+
+	Task(Task&& other) noexcept : _handle(std::exchange(other._handle, {})) {}
+	Task& operator=(Task&& other) noexcept {
+		if (this != &other) {
+			if (_handle) _handle.destroy();
+			_handle = std::exchange(other._handle, {});
+		}
+		return *this;
+	}
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+	~Task() { if (_handle) _handle.destroy(); }
+
+	bool await_ready() const noexcept { return !_handle || _handle.done(); }
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+		_handle.promise().continuation = caller;
+		return _handle;
+	}
+	void await_resume() {
+		if (_handle.promise().error) std::rethrow_exception(_handle.promise().error);
+	}
+private:
+	explicit Task(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+	std::coroutine_handle<promise_type> _handle;
+};
+
+/****************************************
+ThreadPoolExecutor
+
+最小的线程池执行器：FIFO 队列 + 固定数量的工作线程。
+co_await executor.schedule() 把当前协程切换到线程池中继续执行。
+****************************************/
+class ThreadPoolExecutor {
+public:
+	explicit ThreadPoolExecutor(int threads = 1) {
+		if (threads < 1) threads = 1;
+		for (int i = 0; i < threads; ++i) {
+			_workers.emplace_back([this]() { workerLoop(); });
+		}
+	}
+	~ThreadPoolExecutor() {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stopping = true;
+		}
+		_available.notify_all();
+		for (auto& worker : _workers) worker.join();
+	}
+	ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+	ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+
+	void post(std::function<void()> job) {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_jobs.push_back(std::move(job));
+		}
+		_available.notify_one();
+	}
+	void post(std::coroutine_handle<> handle) {
+		post([handle]() { handle.resume(); });
+	}
+
+	struct ScheduleAwaiter {
+		ThreadPoolExecutor& executor;
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle) { executor.post(handle); }
+		void await_resume() const noexcept {}
+	};
+	ScheduleAwaiter schedule() { return ScheduleAwaiter{ *this }; }
+
+private:
+	void workerLoop() {
+		for (;;) {
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_available.wait(lock, [this]() { return _stopping || !_jobs.empty(); });
+				// 停止时仍把已提交的任务执行完，避免挂起的协程永远不被恢复
+				if (_jobs.empty()) return;
+				job = std::move(_jobs.front());
+				_jobs.pop_front();
+			}
+			job();
+		}
+	}
+
+	std::mutex _mutex;
+	std::condition_variable _available;
+	std::deque<std::function<void()>> _jobs;
+	bool _stopping = false;
+	std::vector<std::thread> _workers;
+};
+
+/**
+* 在当前线程阻塞等待 task 完成并返回结果，用于测试与同步代码的边界
+*/
+template<typename T>
+T syncWait(Task<T> task) {
+	std::mutex mutex;
+	std::condition_variable done;
+	bool finished = false;
+	std::optional<T> result;
+	std::exception_ptr error;
+	auto driver = [&]() -> AsyncDetail::Detached {
+		try {
+			result.emplace(co_await std::move(task));
+		}
+		catch (...) {
+			error = std::current_exception();
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		finished = true;
+		done.notify_one();
+	};
+	driver();
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [&finished]() { return finished; });
+	if (error) std::rethrow_exception(error);
+	return std::move(*result);
+}
+
+/****************************************
+AsyncCache
+
+给任意提供 get(key, value)/put(key, value) 的缓存（LRUCache、HashLRUCache、ARCCache 等）
+加上协程接口 getAsync(key, loader)：
+	命中时 await_ready 直接返回，不挂起协程；
+	未命中时挂起调用者，同一 key 的并发请求合并为一次 loader 调用，
+	加载在执行器上进行，完成后写入缓存并把所有等待者投递回执行器恢复。
+loader 抛出的异常会传给该 key 的所有等待者。
+****************************************/
+template<typename Cache, typename Key, typename Value>
+class AsyncCache {
+public:
+	using Loader = std::function<Task<Value>(Key)>;
+
+	struct Stats {
+		uint64_t hits = 0;
+		uint64_t loads = 0;
+		uint64_t coalesced = 0;
+	};
+
+	AsyncCache(Cache& cache, ThreadPoolExecutor& executor) : _cache(cache), _executor(executor) {}
+	AsyncCache(const AsyncCache&) = delete;
+	AsyncCache& operator=(const AsyncCache&) = delete;
+
+	class GetAwaiter {
+	public:
+		GetAwaiter(AsyncCache& owner, Key key, Loader loader)
+			: _owner(owner), _key(std::move(key)), _loader(std::move(loader)) {}
+
+		bool await_ready() {
+			Value value{};
+			if (_owner._cache.get(_key, value)) {
+				_value = std::move(value);
+				++_owner._hits;
+				return true;
+			}
+			return false;
+		}
+		bool await_suspend(std::coroutine_handle<> caller) {
+			_caller = caller;
+			return _owner.enqueue(this);
+		}
+		Value await_resume() {
+			if (_error) std::rethrow_exception(_error);
+			return std::move(*_value);
+		}
+	private:
+		friend class AsyncCache;
+		AsyncCache& _owner;
+		Key _key;
+		Loader _loader;
+		std::coroutine_handle<> _caller;
+		std::optional<Value> _value;
+		std::exception_ptr _error;
+	};
+
+	/**
+	* co_await cache.getAsync(key, loader) 得到 value
+	*/
+	GetAwaiter getAsync(Key key, Loader loader) {
+		return GetAwaiter(*this, std::move(key), std::move(loader));
+	}
+
+	bool get(Key key, Value& value) { return _cache.get(key, value); }
+	void put(Key key, Value value) { _cache.put(key, value); }
+
+	Stats getStats() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		Stats stats;
+		stats.hits = _hits.load(std::memory_order_relaxed);
+		stats.loads = _loads;
+		stats.coalesced = _coalesced;
+		return stats;
+	}
+
+private:
+	/**
+	* 登记等待者，返回是否需要挂起；该 key 没有进行中的加载时发起一次加载
+	*/
+	bool enqueue(GetAwaiter* waiter) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _inflight.find(waiter->_key);
+		if (it != _inflight.end()) {
+			it->second.push_back(waiter);
+			++_coalesced;
+			return true;
+		}
+		// 上一次加载可能恰好在 await_ready 之后完成，登记前再查一次
+		Value value{};
+		if (_cache.get(waiter->_key, value)) {
+			waiter->_value = std::move(value);
+			++_hits;
+			return false;
+		}
+		_inflight[waiter->_key].push_back(waiter);
+		++_loads;
+		load(waiter->_key, waiter->_loader);
+		return true;
+	}
+
+	AsyncDetail::Detached load(Key key, Loader loader) {
+		co_await _executor.schedule();
+		std::optional<Value> value;
+		std::exception_ptr error;
+		try {
+			value.emplace(co_await loader(key));
+			_cache.put(key, *value);
+		}
+		catch (...) {
+			error = std::current_exception();
+		}
+		std::vector<GetAwaiter*> waiters;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto it = _inflight.find(key);
+			waiters = std::move(it->second);
+			_inflight.erase(it);
+		}
+		// 先填好所有结果再投递，投递之后等待者可能立刻恢复并销毁自己的 awaiter
+		for (GetAwaiter* waiter : waiters) {
+			if (error) waiter->_error = error;
+			else waiter->_value = *value;
+		}
+		error = nullptr;
+		for (GetAwaiter* waiter : waiters) {
+			_executor.post(waiter->_caller);
+		}
+	}
+
+	Cache& _cache;
+	ThreadPoolExecutor& _executor;
+	std::mutex _mutex;
+	std::unordered_map<Key, std::vector<GetAwaiter*>> _inflight;
+	std::atomic<uint64_t> _hits{ 0 };
+	uint64_t _loads = 0;
+	uint64_t _coalesced = 0;
+};
+
+#endif // ASYNCCACHE_H
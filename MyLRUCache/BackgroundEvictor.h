@@ -0,0 +1,81 @@
+#pragma once
+#ifndef BACKGROUNDEVICTOR_H
+#define BACKGROUNDEVICTOR_H
+
+#include "CacheResize.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+* 淘汰统计：put 时因为没有空位而在锁内淘汰的次数，与后台线程为保持空余槽位淘汰的次数
+*/
+struct EvictionStats {
+	uint64_t inlineEvictions = 0;
+	uint64_t backgroundEvictions = 0;
+};
+
+/****************************************
+BackgroundEvictor
+
+后台维护线程：每隔 interval（或被 wake 唤醒时）反复执行 task(kEvictBatch)，
+直到 task 返回 false，表示各分片都已留出配置的空余槽位。
+每批淘汰各自加锁，批次之间让出 CPU，put 在有空位时只需占用空位，不必在锁内淘汰。
+析构时停止并等待线程退出。
+****************************************/
+class BackgroundEvictor {
+public:
+	// 执行一批维护，参数为本批最多淘汰的条目数，返回是否还有剩余工作
+	using Task = std::function<bool(size_t)>;
+
+	explicit BackgroundEvictor(Task task, std::chrono::milliseconds interval = std::chrono::milliseconds(1))
+		: _task(std::move(task)), _interval(interval) {
+		_thread = std::thread([this]() { run(); });
+	}
+	~BackgroundEvictor() {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stopping = true;
+		}
+		_wakeup.notify_one();
+		_thread.join();
+	}
+	BackgroundEvictor(const BackgroundEvictor&) = delete;
+	BackgroundEvictor& operator=(const BackgroundEvictor&) = delete;
+
+	/**
+	* 立即开始一轮维护，不等 interval 到期
+	*/
+	void wake() {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_pending = true;
+		}
+		_wakeup.notify_one();
+	}
+
+private:
+	void run() {
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (!_stopping) {
+			_pending = false;
+			lock.unlock();
+			CacheResize::runInBatches([this](size_t batch) { return _task(batch); });
+			lock.lock();
+			_wakeup.wait_for(lock, _interval, [this]() { return _stopping || _pending; });
+		}
+	}
+
+	Task _task;
+	std::chrono::milliseconds _interval;
+	std::mutex _mutex;
+	std::condition_variable _wakeup;
+	bool _stopping = false;
+	bool _pending = false;
+	std::thread _thread;
+};
+
+#endif // BACKGROUNDEVICTOR_H
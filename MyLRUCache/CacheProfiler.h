@@ -0,0 +1,405 @@
+#pragma once
+#ifndef CACHEPROFILER_H
+#define CACHEPROFILER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CACHE_PROFILER_HAS_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CACHE_PROFILER_HAS_RDTSC 1
+#endif
+
+/****************************************
+Profiling
+
+计时工具：x86 上直接读取 TSC，其他平台退化为 steady_clock 纳秒
+****************************************/
+namespace Profiling
+{
+	inline uint64_t readTicks()
+	{
+#ifdef CACHE_PROFILER_HAS_RDTSC
+		return __rdtsc();
+#else
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+	}
+
+	/**
+	* 每纳秒对应的 tick 数，首次调用时用 steady_clock 标定一次（约 10ms）
+	*/
+	inline double ticksPerNanosecond()
+	{
+#ifdef CACHE_PROFILER_HAS_RDTSC
+		static const double ratio = [] {
+			auto begin = std::chrono::steady_clock::now();
+			uint64_t beginTicks = readTicks();
+			while (std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(10)) {
+			}
+			uint64_t endTicks = readTicks();
+			auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+			return ns > 0 ? static_cast<double>(endTicks - beginTicks) / static_cast<double>(ns) : 1.0;
+		}();
+		return ratio;
+#else
+		return 1.0;
+#endif
+	}
+}
+
+/****************************************
+LatencyHistogram
+
+HDR 风格的对数-线性直方图：每个 2 的幂区间再线性切分成 32 个子桶，相对误差约 3%。
+单线程写入（每个线程一份），其他线程可以随时读取、合并和导出。
+****************************************/
+class LatencyHistogram {
+public:
+	static constexpr int kSubBucketBits = 6;
+	static constexpr uint64_t kSubBucketCount = uint64_t{ 1 } << kSubBucketBits;
+	static constexpr size_t kBucketCount = (64 - kSubBucketBits + 1) * (kSubBucketCount / 2) + kSubBucketCount / 2;
+
+	LatencyHistogram() { reset(); }
+	LatencyHistogram(const LatencyHistogram& other) { reset(); merge(other); }
+	LatencyHistogram& operator=(const LatencyHistogram& other) {
+		if (this != &other) {
+			reset();
+			merge(other);
+		}
+		return *this;
+	}
+
+	static size_t bucketIndex(uint64_t value) {
+		if (value < kSubBucketCount) {
+			return static_cast<size_t>(value);
+		}
+		int msb = 63;
+		while (!(value >> msb)) --msb;
+		int shift = msb - (kSubBucketBits - 1);
+		return static_cast<size_t>(shift) * (kSubBucketCount / 2) + static_cast<size_t>(value >> shift);
+	}
+
+	static uint64_t bucketLowerBound(size_t index) {
+		if (index < kSubBucketCount) {
+			return index;
+		}
+		size_t shift = index / (kSubBucketCount / 2) - 1;
+		uint64_t mantissa = index % (kSubBucketCount / 2) + kSubBucketCount / 2;
+		return mantissa << shift;
+	}
+
+	static uint64_t bucketUpperBound(size_t index) {
+		if (index < kSubBucketCount) {
+			return index;
+		}
+		size_t shift = index / (kSubBucketCount / 2) - 1;
+		return bucketLowerBound(index) + ((uint64_t{ 1 } << shift) - 1);
+	}
+
+	/**
+	* 记录一个样本，只允许所属线程调用
+	*/
+	void record(uint64_t value) {
+		bump(_buckets[bucketIndex(value)], 1);
+		bump(_count, 1);
+		bump(_sum, value);
+		if (value > _max.load(std::memory_order_relaxed)) {
+			_max.store(value, std::memory_order_relaxed);
+		}
+	}
+
+	void merge(const LatencyHistogram& other) {
+		for (size_t i = 0; i < kBucketCount; ++i) {
+			uint64_t n = other._buckets[i].load(std::memory_order_relaxed);
+			if (n) bump(_buckets[i], n);
+		}
+		bump(_count, other._count.load(std::memory_order_relaxed));
+		bump(_sum, other._sum.load(std::memory_order_relaxed));
+		uint64_t otherMax = other._max.load(std::memory_order_relaxed);
+		if (otherMax > _max.load(std::memory_order_relaxed)) {
+			_max.store(otherMax, std::memory_order_relaxed);
+		}
+	}
+
+	void reset() {
+		for (auto& bucket : _buckets) {
+			bucket.store(0, std::memory_order_relaxed);
+		}
+		_count.store(0, std::memory_order_relaxed);
+		_sum.store(0, std::memory_order_relaxed);
+		_max.store(0, std::memory_order_relaxed);
+	}
+
+	uint64_t count() const { return _count.load(std::memory_order_relaxed); }
+	uint64_t max() const { return _max.load(std::memory_order_relaxed); }
+	double mean() const {
+		uint64_t n = count();
+		return n ? static_cast<double>(_sum.load(std::memory_order_relaxed)) / static_cast<double>(n) : 0.0;
+	}
+
+	/**
+	* 返回分位数 p（0~100）所在桶的上界
+	*/
+	uint64_t percentile(double p) const {
+		uint64_t total = count();
+		if (total == 0) return 0;
+		uint64_t target = static_cast<uint64_t>(p / 100.0 * static_cast<double>(total));
+		if (target == 0) target = 1;
+		uint64_t seen = 0;
+		for (size_t i = 0; i < kBucketCount; ++i) {
+			seen += _buckets[i].load(std::memory_order_relaxed);
+			if (seen >= target) {
+				uint64_t upper = bucketUpperBound(i);
+				return upper < max() ? upper : max();
+			}
+		}
+		return max();
+	}
+
+	/**
+	* 以 CSV 导出非空桶：lower_ns,upper_ns,count
+	*/
+	void exportCsv(std::ostream& os, double ticksPerNs = Profiling::ticksPerNanosecond()) const {
+		os << "lower_ns,upper_ns,count\n";
+		for (size_t i = 0; i < kBucketCount; ++i) {
+			uint64_t n = _buckets[i].load(std::memory_order_relaxed);
+			if (!n) continue;
+			os << static_cast<double>(bucketLowerBound(i)) / ticksPerNs << ','
+				<< static_cast<double>(bucketUpperBound(i)) / ticksPerNs << ',' << n << '\n';
+		}
+	}
+
+	void printSummary(std::ostream& os, const char* name, double ticksPerNs = Profiling::ticksPerNanosecond()) const {
+		os << name << ": count=" << count()
+			<< " mean=" << mean() / ticksPerNs << "ns"
+			<< " p50=" << static_cast<double>(percentile(50)) / ticksPerNs << "ns"
+			<< " p99=" << static_cast<double>(percentile(99)) / ticksPerNs << "ns"
+			<< " p999=" << static_cast<double>(percentile(99.9)) / ticksPerNs << "ns"
+			<< " max=" << static_cast<double>(max()) / ticksPerNs << "ns" << '\n';
+	}
+
+private:
+	// 单写者：load + store 即可，不需要 RMW 指令
+	static void bump(std::atomic<uint64_t>& counter, uint64_t n) {
+		counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+
+	std::array<std::atomic<uint64_t>, kBucketCount> _buckets;
+	std::atomic<uint64_t> _count;
+	std::atomic<uint64_t> _sum;
+	std::atomic<uint64_t> _max;
+};
+
+/****************************************
+CacheProfiler
+
+按线程记录 等锁时间 / 持锁时间 / 操作总时间 三个直方图，按 sampleRate 采样控制开销。
+一个 profiler 可以被多个缓存（例如 HashLRUCache 的所有分片）共享。
+****************************************/
+class CacheProfiler {
+public:
+	struct Histograms {
+		LatencyHistogram lockWait;
+		LatencyHistogram lockHold;
+		LatencyHistogram total;
+
+		void merge(const Histograms& other) {
+			lockWait.merge(other.lockWait);
+			lockHold.merge(other.lockHold);
+			total.merge(other.total);
+		}
+	};
+
+	explicit CacheProfiler(uint32_t sampleRate = 64)
+		: _sampleRate(sampleRate == 0 ? 1 : sampleRate), _id(nextId()) {}
+	CacheProfiler(const CacheProfiler&) = delete;
+	CacheProfiler& operator=(const CacheProfiler&) = delete;
+
+	/**
+	* 每 sampleRate 次操作返回一次 true（线程内计数，无共享写）
+	*/
+	bool shouldSample() const {
+		thread_local uint32_t countdown = 0;
+		if (countdown == 0) {
+			countdown = _sampleRate - 1;
+			return true;
+		}
+		--countdown;
+		return false;
+	}
+
+	/**
+	* 当前线程的直方图，首次访问时注册
+	*/
+	Histograms& local() {
+		thread_local uint64_t cachedOwner = 0;
+		thread_local Histograms* cachedSlot = nullptr;
+		if (cachedOwner == _id) {
+			return *cachedSlot;
+		}
+		std::lock_guard<std::mutex> lock(_slotMutex);
+		auto self = std::this_thread::get_id();
+		Histograms* slot = nullptr;
+		for (auto& entry : _slots) {
+			if (entry->owner == self) {
+				slot = &entry->histograms;
+				break;
+			}
+		}
+		if (!slot) {
+			_slots.push_back(std::make_unique<Slot>());
+			_slots.back()->owner = self;
+			slot = &_slots.back()->histograms;
+		}
+		cachedOwner = _id;
+		cachedSlot = slot;
+		return *slot;
+	}
+
+	/**
+	* 合并所有线程的直方图
+	*/
+	Histograms merged() const {
+		Histograms result;
+		std::lock_guard<std::mutex> lock(_slotMutex);
+		for (auto& entry : _slots) {
+			result.merge(entry->histograms);
+		}
+		return result;
+	}
+
+	void exportCsv(std::ostream& os) const {
+		Histograms all = merged();
+		os << "# lock_wait\n";
+		all.lockWait.exportCsv(os);
+		os << "# lock_hold\n";
+		all.lockHold.exportCsv(os);
+		os << "# total\n";
+		all.total.exportCsv(os);
+	}
+
+	void printSummary(std::ostream& os) const {
+		Histograms all = merged();
+		all.lockWait.printSummary(os, "lock_wait");
+		all.lockHold.printSummary(os, "lock_hold");
+		all.total.printSummary(os, "total");
+	}
+
+	uint32_t sampleRate() const { return _sampleRate; }
+
+private:
+	struct Slot {
+		std::thread::id owner;
+		Histograms histograms;
+	};
+
+	static uint64_t nextId() {
+		static std::atomic<uint64_t> counter{ 0 };
+		return ++counter;
+	}
+
+	const uint32_t _sampleRate;
+	const uint64_t _id;
+	mutable std::mutex _slotMutex;
+	std::vector<std::unique_ptr<Slot>> _slots;
+};
+
+/****************************************
+LockStats
+
+单个分片（一把锁）的计数：加锁次数、发生竞争的次数、采样到的持锁时间
+****************************************/
+struct LockStats {
+	uint64_t acquisitions = 0;
+	uint64_t contended = 0;
+	uint64_t sampledHoldTicks = 0;
+	uint64_t samples = 0;
+
+	double contentionRate() const {
+		return acquisitions ? static_cast<double>(contended) / static_cast<double>(acquisitions) : 0.0;
+	}
+	double meanHoldNs() const {
+		return samples ? static_cast<double>(sampledHoldTicks) / static_cast<double>(samples) / Profiling::ticksPerNanosecond() : 0.0;
+	}
+};
+
+struct LockCounters {
+	std::atomic<uint64_t> acquisitions{ 0 };
+	std::atomic<uint64_t> contended{ 0 };
+	std::atomic<uint64_t> sampledHoldTicks{ 0 };
+	std::atomic<uint64_t> samples{ 0 };
+
+	LockStats snapshot() const {
+		LockStats stats;
+		stats.acquisitions = acquisitions.load(std::memory_order_relaxed);
+		stats.contended = contended.load(std::memory_order_relaxed);
+		stats.sampledHoldTicks = sampledHoldTicks.load(std::memory_order_relaxed);
+		stats.samples = samples.load(std::memory_order_relaxed);
+		return stats;
+	}
+};
+
+/****************************************
+ProfiledLockGuard
+
+替代 std::lock_guard。profiler 为空时只做一次判断；否则统计竞争次数，
+并在采样命中时记录 等锁 / 持锁 / 总时间。
+****************************************/
+class ProfiledLockGuard {
+public:
+	ProfiledLockGuard(std::mutex& mutex, CacheProfiler* profiler, LockCounters& counters)
+		: _mutex(mutex), _profiler(profiler), _counters(counters) {
+		if (!_profiler) {
+			_mutex.lock();
+			return;
+		}
+		_sampled = _profiler->shouldSample();
+		if (_sampled) _start = Profiling::readTicks();
+		_counters.acquisitions.fetch_add(1, std::memory_order_relaxed);
+		if (!_mutex.try_lock()) {
+			_counters.contended.fetch_add(1, std::memory_order_relaxed);
+			_mutex.lock();
+		}
+		if (_sampled) _acquired = Profiling::readTicks();
+	}
+
+	~ProfiledLockGuard() {
+		if (!_sampled) {
+			_mutex.unlock();
+			return;
+		}
+		uint64_t released = Profiling::readTicks();
+		_mutex.unlock();
+		uint64_t hold = released - _acquired;
+		_counters.sampledHoldTicks.fetch_add(hold, std::memory_order_relaxed);
+		_counters.samples.fetch_add(1, std::memory_order_relaxed);
+		auto& histograms = _profiler->local();
+		histograms.lockWait.record(_acquired - _start);
+		histograms.lockHold.record(hold);
+		histograms.total.record(Profiling::readTicks() - _start);
+	}
+
+	ProfiledLockGuard(const ProfiledLockGuard&) = delete;
+	ProfiledLockGuard& operator=(const ProfiledLockGuard&) = delete;
+
+private:
+	std::mutex& _mutex;
+	CacheProfiler* _profiler;
+	LockCounters& _counters;
+	bool _sampled = false;
+	uint64_t _start = 0;
+	uint64_t _acquired = 0;
+};
+
+#endif // CACHEPROFILER_H
@@ -0,0 +1,29 @@
+#pragma once
+#ifndef CACHERESIZE_H
+#define CACHERESIZE_H
+
+#include <cstddef>
+#include <thread>
+
+/****************************************
+CacheResize
+
+运行时调整容量的公共工具。缩容时不一次性淘汰所有多出的条目，
+而是分批进行：每批最多淘汰 kEvictBatch 个，批次之间释放锁，
+让并发的 get/put 可以穿插执行，单次持锁时间有上限。
+****************************************/
+namespace CacheResize {
+	constexpr size_t kEvictBatch = 256;
+
+	/**
+	* 反复执行 step(kEvictBatch) 直到返回 false；step 自行加锁，返回是否还有剩余工作
+	*/
+	template<typename Step>
+	void runInBatches(Step step) {
+		while (step(kEvictBatch)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+#endif // CACHERESIZE_H
@@ -0,0 +1,392 @@
+#pragma once
+#ifndef CACHESNAPSHOT_H
+#define CACHESNAPSHOT_H
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/****************************************
+Serializer
+
+Key / Value 的序列化接口，可以为自定义类型特化：
+	static size_t size(const T& v);                                  // 序列化后的字节数
+	static char* write(char* out, const T& v);                       // 写入并返回新的写指针
+	static bool read(const char*& in, const char* end, T& v);        // 读取并推进读指针，越界返回 false
+默认提供 可平凡复制类型（按主机字节序原样拷贝）与 std::string（u32 长度 + 字节）的实现。
+****************************************/
+template<typename T, typename Enable = void>
+struct Serializer;
+
+template<typename T>
+struct Serializer<T, std::enable_if_t<std::is_trivially_copyable_v<T>>> {
+	static size_t size(const T&) { return sizeof(T); }
+	static char* write(char* out, const T& v) {
+		std::memcpy(out, &v, sizeof(T));
+		return out + sizeof(T);
+	}
+	static bool read(const char*& in, const char* end, T& v) {
+		if (static_cast<size_t>(end - in) < sizeof(T)) return false;
+		std::memcpy(&v, in, sizeof(T));
+		in += sizeof(T);
+		return true;
+	}
+};
+
+template<>
+struct Serializer<std::string> {
+	static size_t size(const std::string& v) { return sizeof(uint32_t) + v.size(); }
+	static char* write(char* out, const std::string& v) {
+		uint32_t len = static_cast<uint32_t>(v.size());
+		std::memcpy(out, &len, sizeof(len));
+		std::memcpy(out + sizeof(len), v.data(), v.size());
+		return out + sizeof(len) + v.size();
+	}
+	static bool read(const char*& in, const char* end, std::string& v) {
+		uint32_t len = 0;
+		if (static_cast<size_t>(end - in) < sizeof(len)) return false;
+		std::memcpy(&len, in, sizeof(len));
+		if (static_cast<size_t>(end - in) - sizeof(len) < len) return false;
+		v.assign(in + sizeof(len), len);
+		in += sizeof(len) + len;
+		return true;
+	}
+};
+
+/****************************************
+Crc32
+
+IEEE CRC32，查表实现
+****************************************/
+namespace Crc32
+{
+	inline const std::array<uint32_t, 256>& table()
+	{
+		static const std::array<uint32_t, 256> t = [] {
+			std::array<uint32_t, 256> result{};
+			for (uint32_t i = 0; i < 256; ++i) {
+				uint32_t c = i;
+				for (int k = 0; k < 8; ++k) {
+					c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+				}
+				result[i] = c;
+			}
+			return result;
+		}();
+		return t;
+	}
+
+	// crc 传入上一次的返回值即可增量计算，初始为 0
+	inline uint32_t update(uint32_t crc, const char* data, size_t len)
+	{
+		const auto& t = table();
+		crc = ~crc;
+		for (size_t i = 0; i < len; ++i) {
+			crc = t[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+}
+
+/****************************************
+快照文件格式（主机字节序）
+
+	Header  : magic "MLRCSNAP" | u32 version | u32 byteOrder(0x01020304) | u32 cacheKind | u32 reserved
+	Section : u32 tag | u64 recordCount | records...
+	Footer  : magic "MLRCEND\0" | u64 totalRecords | u32 crc32(Header..最后一个 Section)
+
+写入时边写边算 CRC，先写临时文件再 rename，保证不会留下写了一半的快照。
+****************************************/
+enum class SnapshotKind : uint32_t {
+	LRU = 1,
+	HashLRU = 2,
+	LFU = 3,
+	ARC = 4,
+};
+
+namespace SnapshotSection
+{
+	constexpr uint32_t Meta = 1;
+	constexpr uint32_t Entries = 2;
+	constexpr uint32_t Ghosts = 3;
+}
+
+namespace SnapshotFormat
+{
+	constexpr char kHeaderMagic[8] = { 'M', 'L', 'R', 'C', 'S', 'N', 'A', 'P' };
+	constexpr char kFooterMagic[8] = { 'M', 'L', 'R', 'C', 'E', 'N', 'D', '\0' };
+	constexpr uint32_t kVersion = 1;
+	constexpr uint32_t kByteOrder = 0x01020304;
+	constexpr size_t kHeaderSize = 8 + 4 * 4;
+	constexpr size_t kFooterSize = 8 + 8 + 4;
+}
+
+class SnapshotWriter {
+public:
+	SnapshotWriter(const std::string& path, SnapshotKind kind)
+		: _path(path), _tmpPath(path + ".tmp"), _out(_tmpPath, std::ios::binary | std::ios::trunc) {
+		_buffer.reserve(kBufferSize);
+		append(SnapshotFormat::kHeaderMagic, sizeof(SnapshotFormat::kHeaderMagic));
+		writeU32(SnapshotFormat::kVersion);
+		writeU32(SnapshotFormat::kByteOrder);
+		writeU32(static_cast<uint32_t>(kind));
+		writeU32(0);
+	}
+	~SnapshotWriter() {
+		if (!_finished) {
+			_out.close();
+			std::remove(_tmpPath.c_str());
+		}
+	}
+	SnapshotWriter(const SnapshotWriter&) = delete;
+	SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+	bool good() const { return _out.good(); }
+
+	void beginSection(uint32_t tag, uint64_t recordCount) {
+		writeU32(tag);
+		writeU64(recordCount);
+	}
+
+	void writeU32(uint32_t v) { write(v); }
+	void writeU64(uint64_t v) { write(v); }
+
+	template<typename T>
+	void write(const T& v) {
+		size_t n = Serializer<T>::size(v);
+		if (_buffer.size() + n > kBufferSize) {
+			flush();
+		}
+		size_t offset = _buffer.size();
+		_buffer.resize(offset + n);
+		Serializer<T>::write(_buffer.data() + offset, v);
+	}
+
+	template<typename T>
+	void writeRecord(const T& v) {
+		write(v);
+		++_records;
+	}
+
+	/**
+	* 写入一个 <Key, Value> 数据段，保持 entries 的顺序
+	*/
+	template<typename Key, typename Value>
+	void writeEntries(const std::vector<std::pair<Key, Value>>& entries) {
+		beginSection(SnapshotSection::Entries, entries.size());
+		for (const auto& entry : entries) {
+			write(entry.first);
+			writeRecord(entry.second);
+		}
+	}
+
+	/**
+	* 写入 footer 并原子替换目标文件，失败返回 false
+	*/
+	bool finish() {
+		flush();
+		char footer[SnapshotFormat::kFooterSize];
+		std::memcpy(footer, SnapshotFormat::kFooterMagic, 8);
+		std::memcpy(footer + 8, &_records, 8);
+		std::memcpy(footer + 16, &_crc, 4);
+		_out.write(footer, sizeof(footer));
+		_out.close();
+		if (!_out) {
+			std::remove(_tmpPath.c_str());
+			return false;
+		}
+#ifdef _WIN32
+		bool renamed = MoveFileExA(_tmpPath.c_str(), _path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		bool renamed = std::rename(_tmpPath.c_str(), _path.c_str()) == 0;
+#endif
+		if (!renamed) {
+			std::remove(_tmpPath.c_str());
+			return false;
+		}
+		_finished = true;
+		return true;
+	}
+
+private:
+	static constexpr size_t kBufferSize = 1 << 20;
+
+	void append(const char* data, size_t len) {
+		_buffer.insert(_buffer.end(), data, data + len);
+	}
+
+	void flush() {
+		if (_buffer.empty()) return;
+		_crc = Crc32::update(_crc, _buffer.data(), _buffer.size());
+		_out.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+		_buffer.clear();
+	}
+
+	std::string _path;
+	std::string _tmpPath;
+	std::ofstream _out;
+	std::vector<char> _buffer;
+	uint32_t _crc = 0;
+	uint64_t _records = 0;
+	bool _finished = false;
+};
+
+/****************************************
+MappedFile
+
+只读 mmap 一个文件
+****************************************/
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile() { close(); }
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path) {
+		close();
+#ifdef _WIN32
+		_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (_file == INVALID_HANDLE_VALUE) return false;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0) return false;
+		_size = static_cast<size_t>(size.QuadPart);
+		_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!_mapping) return false;
+		_data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+		return _data != nullptr;
+#else
+		_fd = ::open(path.c_str(), O_RDONLY);
+		if (_fd < 0) return false;
+		struct stat st;
+		if (fstat(_fd, &st) != 0 || st.st_size == 0) return false;
+		_size = static_cast<size_t>(st.st_size);
+		void* addr = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+		if (addr == MAP_FAILED) return false;
+		madvise(addr, _size, MADV_SEQUENTIAL);
+		_data = static_cast<const char*>(addr);
+		return true;
+#endif
+	}
+
+	void close() {
+#ifdef _WIN32
+		if (_data) UnmapViewOfFile(_data);
+		if (_mapping) CloseHandle(_mapping);
+		if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+		_mapping = nullptr;
+		_file = INVALID_HANDLE_VALUE;
+#else
+		if (_data) munmap(const_cast<char*>(_data), _size);
+		if (_fd >= 0) ::close(_fd);
+		_fd = -1;
+#endif
+		_data = nullptr;
+		_size = 0;
+	}
+
+	const char* data() const { return _data; }
+	size_t size() const { return _size; }
+
+private:
+	const char* _data = nullptr;
+	size_t _size = 0;
+#ifdef _WIN32
+	HANDLE _file = INVALID_HANDLE_VALUE;
+	HANDLE _mapping = nullptr;
+#else
+	int _fd = -1;
+#endif
+};
+
+class SnapshotReader {
+public:
+	/**
+	* 映射文件并校验 header / footer / CRC，任何一项不符都返回 false
+	*/
+	bool open(const std::string& path, SnapshotKind kind) {
+		using namespace SnapshotFormat;
+		if (!_file.open(path)) return false;
+		const char* data = _file.data();
+		size_t size = _file.size();
+		if (size < kHeaderSize + kFooterSize) return false;
+		if (std::memcmp(data, kHeaderMagic, 8) != 0) return false;
+		uint32_t version = 0, byteOrder = 0, fileKind = 0;
+		std::memcpy(&version, data + 8, 4);
+		std::memcpy(&byteOrder, data + 12, 4);
+		std::memcpy(&fileKind, data + 16, 4);
+		if (version != kVersion || byteOrder != kByteOrder || fileKind != static_cast<uint32_t>(kind)) return false;
+
+		const char* footer = data + size - kFooterSize;
+		if (std::memcmp(footer, kFooterMagic, 8) != 0) return false;
+		uint32_t crc = 0;
+		std::memcpy(&_totalRecords, footer + 8, 8);
+		std::memcpy(&crc, footer + 16, 4);
+		if (Crc32::update(0, data, size - kFooterSize) != crc) return false;
+
+		_cursor = data + kHeaderSize;
+		_end = footer;
+		return true;
+	}
+
+	uint64_t totalRecords() const { return _totalRecords; }
+
+	/**
+	* 读取 section 头，tag 不匹配返回 false
+	*/
+	bool beginSection(uint32_t tag, uint64_t& recordCount) {
+		uint32_t fileTag = 0;
+		if (!read(fileTag) || fileTag != tag) return false;
+		return read(recordCount);
+	}
+
+	template<typename T>
+	bool read(T& v) {
+		return Serializer<T>::read(_cursor, _end, v);
+	}
+
+	template<typename Key, typename Value>
+	bool readEntries(std::vector<std::pair<Key, Value>>& entries) {
+		uint64_t count = 0;
+		if (!beginSection(SnapshotSection::Entries, count) || count > remaining()) return false;
+		entries.reserve(entries.size() + static_cast<size_t>(count));
+		for (uint64_t i = 0; i < count; ++i) {
+			std::pair<Key, Value> entry;
+			if (!read(entry.first) || !read(entry.second)) return false;
+			entries.push_back(std::move(entry));
+		}
+		return true;
+	}
+
+	// 剩余字节数，用于在 reserve 之前检查 recordCount 是否可信
+	size_t remaining() const { return static_cast<size_t>(_end - _cursor); }
+
+	bool atEnd() const { return _cursor == _end; }
+
+private:
+	MappedFile _file;
+	const char* _cursor = nullptr;
+	const char* _end = nullptr;
+	uint64_t _totalRecords = 0;
+};
+
+#endif // CACHESNAPSHOT_H
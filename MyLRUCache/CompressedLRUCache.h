@@ -0,0 +1,344 @@
+#pragma once
+#ifndef COMPRESSEDLRUCACHE_H
+#define COMPRESSEDLRUCACHE_H
+
+#include "LZCodec.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+/****************************************
+CompressedLRUCache
+
+按字节预算计费的两段式 LRU，value 为 std::string：
+	hot  段：最近访问的条目，始终保存原始数据，命中时不需要解压
+	cold 段：从 hot 段尾部降级下来的条目，由后台线程用 Codec 压缩
+cold 段命中时解压并重新提升到 hot 段。预算按实际存储字节（压缩后大小）计算，
+因此可容纳的条目数随压缩率增长。
+****************************************/
+template<typename Key, typename Codec = LZCodec>
+class CompressedLRUCache {
+public:
+	struct Stats {
+		size_t entries = 0;
+		size_t compressedEntries = 0;
+		uint64_t storedBytes = 0;
+		uint64_t rawBytes = 0;
+		uint64_t hotHits = 0;
+		uint64_t coldHits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+		size_t pendingEntries = 0;
+
+		double compressionRatio() const {
+			return storedBytes ? static_cast<double>(rawBytes) / static_cast<double>(storedBytes) : 1.0;
+		}
+	};
+
+	/**
+	* byteBudget：value 存储字节 + 每条目固定开销 的上限
+	* hotFraction：hot 段最多占预算的比例
+	* backgroundCompression：为 false 时不启动后台线程，cold 段保持原始数据直到调用者执行 compressPending()；
+	*   调用者需要定期调用它，否则 cold 段不被压缩，待压缩队列中失效的项只在队列超过条目数两倍时清理
+	*/
+	CompressedLRUCache(uint64_t byteBudget, double hotFraction = 0.25, bool backgroundCompression = true)
+		: _byteBudget(byteBudget),
+		_hotBudget(static_cast<uint64_t>(static_cast<double>(byteBudget) * hotFraction)) {
+		if (backgroundCompression) {
+			_worker = std::thread([this]() { workerLoop(); });
+		}
+	}
+	~CompressedLRUCache() {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stopping = true;
+		}
+		_workAvailable.notify_all();
+		if (_worker.joinable()) _worker.join();
+	}
+	CompressedLRUCache(const CompressedLRUCache&) = delete;
+	CompressedLRUCache& operator=(const CompressedLRUCache&) = delete;
+
+	bool get(const Key& key, std::string& value) {
+		std::string compressed;
+		uint64_t version = 0;
+		bool demoted = false;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto it = _map.find(key);
+			if (it == _map.end()) {
+				++_misses;
+				return false;
+			}
+			EntryIt entry = it->second;
+			if (!entry->compressed) {
+				if (entry->hot) ++_hotHits;
+				else ++_coldHits;
+				value = entry->data;
+				promote(entry);
+				demoted = rebalance();
+			}
+			else {
+				++_coldHits;
+				compressed = entry->data;
+				version = entry->version;
+			}
+		}
+		if (!compressed.empty()) {
+			// 解压在锁外进行
+			if (!Codec::decompress(compressed, value)) return false;
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto it = _map.find(key);
+			if (it != _map.end() && it->second->version == version) {
+				EntryIt entry = it->second;
+				if (entry->compressed) {
+					replaceData(entry, value, false);
+				}
+				promote(entry);
+				demoted = rebalance();
+			}
+		}
+		if (demoted) _workAvailable.notify_one();
+		return true;
+	}
+	std::string get(const Key& key) {
+		std::string value;
+		get(key, value);
+		return value;
+	}
+
+	void put(const Key& key, std::string value) {
+		bool demoted;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto it = _map.find(key);
+			if (it != _map.end()) {
+				EntryIt entry = it->second;
+				_rawBytes -= entry->rawSize;
+				entry->rawSize = value.size();
+				_rawBytes += entry->rawSize;
+				replaceData(entry, std::move(value), false);
+				++entry->version;
+				promote(entry);
+			}
+			else {
+				_hot.push_front(Entry{ key, std::move(value), 0, 0, false, true });
+				EntryIt entry = _hot.begin();
+				entry->rawSize = entry->data.size();
+				_hotBytes += charge(*entry);
+				_storedBytes += entry->data.size();
+				_rawBytes += entry->rawSize;
+				_map[key] = entry;
+			}
+			demoted = rebalance();
+		}
+		if (demoted) _workAvailable.notify_one();
+	}
+
+	bool remove(const Key& key) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _map.find(key);
+		if (it == _map.end()) return false;
+		erase(it->second);
+		return true;
+	}
+
+	/**
+	* 压缩最多 maxEntries 个待压缩的 cold 条目，返回实际压缩的数量
+	*/
+	size_t compressPending(size_t maxEntries = SIZE_MAX) {
+		size_t done = 0;
+		while (done < maxEntries) {
+			Key key;
+			std::string raw;
+			uint64_t version;
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				if (!nextPending(key, raw, version)) break;
+			}
+			std::string compressed = Codec::compress(raw);
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto it = _map.find(key);
+			if (it == _map.end()) continue;
+			EntryIt entry = it->second;
+			// 压缩期间被修改、被提升或压缩后没有变小，都放弃这次结果
+			if (entry->version != version || entry->hot || entry->compressed || compressed.size() >= entry->data.size()) continue;
+			replaceData(entry, std::move(compressed), true);
+			entry->data.shrink_to_fit();
+			++done;
+		}
+		return done;
+	}
+
+	Stats getStats() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		Stats stats;
+		stats.entries = _map.size();
+		stats.compressedEntries = _compressedEntries;
+		stats.storedBytes = _storedBytes;
+		stats.rawBytes = _rawBytes;
+		stats.hotHits = _hotHits;
+		stats.coldHits = _coldHits;
+		stats.misses = _misses;
+		stats.evictions = _evictions;
+		stats.pendingEntries = _pending.size();
+		return stats;
+	}
+
+private:
+	// 每个条目在 key 与 value 之外的固定开销估计（链表节点、哈希节点等）
+	static constexpr uint64_t kEntryOverhead = 64;
+
+	struct Entry {
+		Key key;
+		std::string data;
+		size_t rawSize;
+		uint64_t version;
+		bool compressed;
+		bool hot;
+	};
+	using EntryList = std::list<Entry>;
+	using EntryIt = typename EntryList::iterator;
+
+	static uint64_t charge(const Entry& entry) { return entry.data.size() + kEntryOverhead; }
+
+	/**
+	* 替换条目的存储数据，同步更新所在段的字节数与压缩计数
+	*/
+	void replaceData(EntryIt entry, std::string data, bool compressed) {
+		uint64_t& segmentBytes = entry->hot ? _hotBytes : _coldBytes;
+		segmentBytes -= charge(*entry);
+		_storedBytes -= entry->data.size();
+		if (entry->compressed) --_compressedEntries;
+		entry->data = std::move(data);
+		entry->compressed = compressed;
+		if (entry->compressed) ++_compressedEntries;
+		_storedBytes += entry->data.size();
+		segmentBytes += charge(*entry);
+	}
+
+	/**
+	* 移到 hot 段头部，调用前条目必须已是原始数据
+	*/
+	void promote(EntryIt entry) {
+		if (entry->hot) {
+			_hot.splice(_hot.begin(), _hot, entry);
+			return;
+		}
+		_coldBytes -= charge(*entry);
+		entry->hot = true;
+		_hot.splice(_hot.begin(), _cold, entry);
+		_hotBytes += charge(*entry);
+	}
+
+	/**
+	* hot 段超出比例时把尾部降级到 cold 段并加入压缩队列；总量超出预算时从 cold 段尾部淘汰。
+	* 返回是否有新的待压缩条目。
+	*/
+	bool rebalance() {
+		bool demoted = false;
+		while (_hotBytes > _hotBudget && _hot.size() > 1) {
+			EntryIt entry = std::prev(_hot.end());
+			_hotBytes -= charge(*entry);
+			entry->hot = false;
+			_cold.splice(_cold.begin(), _hot, entry);
+			_coldBytes += charge(*entry);
+			_pending.emplace_back(entry->key, entry->version);
+			demoted = true;
+		}
+		// 反复降级、提升或淘汰的条目会在队列中留下失效的项，没有人消费队列时它会无限增长
+		if (_pending.size() > 2 * _map.size() + kWorkerBatch) compactPending();
+		while (_hotBytes + _coldBytes > _byteBudget && !_map.empty()) {
+			erase(_cold.empty() ? std::prev(_hot.end()) : std::prev(_cold.end()));
+			++_evictions;
+		}
+		return demoted;
+	}
+
+	void erase(EntryIt entry) {
+		if (entry->hot) _hotBytes -= charge(*entry);
+		else _coldBytes -= charge(*entry);
+		_storedBytes -= entry->data.size();
+		_rawBytes -= entry->rawSize;
+		if (entry->compressed) --_compressedEntries;
+		_map.erase(entry->key);
+		(entry->hot ? _hot : _cold).erase(entry);
+	}
+
+	bool nextPending(Key& key, std::string& raw, uint64_t& version) {
+		while (!_pending.empty()) {
+			auto item = std::move(_pending.front());
+			_pending.pop_front();
+			auto it = _map.find(item.first);
+			if (it == _map.end()) continue;
+			EntryIt entry = it->second;
+			if (entry->hot || entry->compressed || entry->version != item.second) continue;
+			key = item.first;
+			raw = entry->data;
+			version = item.second;
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	* 只保留仍然有效的待压缩项（条目在 cold 段、未压缩、版本一致），同一个 key 只保留一项
+	*/
+	void compactPending() {
+		std::deque<std::pair<Key, uint64_t>> pending;
+		std::unordered_set<Key> queued;
+		for (auto& item : _pending) {
+			auto it = _map.find(item.first);
+			if (it == _map.end()) continue;
+			EntryIt entry = it->second;
+			if (entry->hot || entry->compressed || entry->version != item.second) continue;
+			if (queued.insert(item.first).second) pending.push_back(std::move(item));
+		}
+		_pending = std::move(pending);
+	}
+
+	void workerLoop() {
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_workAvailable.wait(lock, [this]() { return _stopping || !_pending.empty(); });
+				if (_stopping) return;
+			}
+			compressPending(kWorkerBatch);
+		}
+	}
+
+	static constexpr size_t kWorkerBatch = 64;
+
+	std::mutex _mutex;
+	std::condition_variable _workAvailable;
+	bool _stopping = false;
+	std::thread _worker;
+
+	uint64_t _byteBudget;
+	uint64_t _hotBudget;
+	uint64_t _hotBytes = 0;
+	uint64_t _coldBytes = 0;
+	uint64_t _storedBytes = 0;
+	uint64_t _rawBytes = 0;
+	size_t _compressedEntries = 0;
+	uint64_t _hotHits = 0;
+	uint64_t _coldHits = 0;
+	uint64_t _misses = 0;
+	uint64_t _evictions = 0;
+
+	EntryList _hot;
+	EntryList _cold;
+	std::unordered_map<Key, EntryIt> _map;
+	std::deque<std::pair<Key, uint64_t>> _pending;
+};
+
+#endif // COMPRESSEDLRUCACHE_H
@@ -0,0 +1,250 @@
+#pragma once
+#ifndef DECAYLFUCACHE_H
+#define DECAYLFUCACHE_H
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+* DecayLFUCache 的时间来源：Accesses 以 get/put 次数为时间，Seconds 以 steady_clock 秒数为时间
+*/
+enum class DecayClock {
+	Accesses,
+	Seconds
+};
+
+/****************************************
+DecayLFUCache
+
+频次按指数衰减的 LFU：条目的分数每过 halfLife 减半，每次访问加一，淘汰当前分数最小的条目，
+旧的热点随时间平滑地让位给新的热点，不会像 LFUCache 那样长期占据高频链表。
+分数保存在对数域并加上全局偏移：
+	条目只保存 L = log2(分数) + t / halfLife，t 为最近一次访问的时间；
+	所有条目以相同的速率衰减，L 的大小关系不随时间改变，不需要像 AlignLFUCache 那样定期遍历全部条目；
+	访问时按 now = t / halfLife 惰性地计算 L' = now + log2(1 + 2^(L - now))，即衰减后的分数再加一。
+条目按 L 量化后放进环形桶数组，每个对数单位（分数相差一倍）分 kBucketsPerUnit 个桶，
+同一个桶内按最近访问排序。命中与写入 O(1)，淘汰从最小的桶向上找第一个非空桶，均摊 O(1)。
+窗口之外的条目放在窗口两端的桶中，只影响排序精度。
+****************************************/
+template<typename Key, typename Value>
+class DecayLFUCache {
+public:
+	/**
+	* halfLife 为分数减半所需的时间，单位由 clock 决定（访问次数或秒）
+	*/
+	DecayLFUCache(int capacity, double halfLife, DecayClock clock = DecayClock::Accesses)
+		: _capacity(capacity > 0 ? static_cast<size_t>(capacity) : 0),
+		_halfLife(halfLife > 0 ? halfLife : 1.0),
+		_clock(clock),
+		_start(std::chrono::steady_clock::now()),
+		_buckets(kBucketCount) {
+		_map.reserve(_capacity);
+	}
+
+	bool get(Key key, Value& value) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		double now = advance();
+		auto it = _map.find(key);
+		if (it == _map.end()) {
+			return false;
+		}
+		Entry& entry = it->second;
+		value = entry.value;
+		touch(entry, now);
+		return true;
+	}
+	Value get(Key key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+
+	/**
+	* 写入或更新条目；更新视为一次访问
+	*/
+	void put(Key key, Value value) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_capacity == 0) return;
+		double now = advance();
+		auto it = _map.find(key);
+		if (it != _map.end()) {
+			it->second.value = value;
+			touch(it->second, now);
+			return;
+		}
+		if (_map.size() >= _capacity) {
+			evict();
+		}
+		auto& node = *_map.try_emplace(key).first;
+		Entry& entry = node.second;
+		entry.value = value;
+		entry.node = &node;
+		// 新条目分数为 1，log2(1) = 0
+		entry.score = now;
+		link(entry, bucketOf(entry.score));
+	}
+
+	bool remove(Key key) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _map.find(key);
+		if (it == _map.end()) return false;
+		unlink(it->second);
+		_map.erase(it);
+		return true;
+	}
+
+	/**
+	* 当前衰减后的分数，不算作访问；key 不存在时为 0
+	*/
+	double frequency(Key key) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _map.find(key);
+		if (it == _map.end()) return 0.0;
+		return std::exp2(it->second.score - currentTime());
+	}
+
+	size_t size() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _map.size();
+	}
+	int getCapacity() const { return static_cast<int>(_capacity); }
+	uint64_t getEvictions() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _evictions;
+	}
+
+private:
+	// 每个对数单位的桶数，相邻桶的分数相差约 9%
+	static constexpr int kBucketsPerUnit = 8;
+	// 窗口覆盖 128 个对数单位，足以容纳任何实际出现的分数差
+	static constexpr size_t kBucketCount = 1024;
+
+	struct Entry {
+		Value value{};
+		// log2(分数) + 最近访问时间 / halfLife
+		double score = 0;
+		int64_t bucket = 0;
+		Entry* prev = nullptr;
+		Entry* next = nullptr;
+		std::pair<const Key, Entry>* node = nullptr;
+	};
+	struct Bucket {
+		Entry* head = nullptr;		// 最近访问
+		Entry* tail = nullptr;		// 最久访问
+	};
+
+	/**
+	* 推进时间并返回以 halfLife 为单位的当前时间
+	*/
+	double advance() {
+		if (_clock == DecayClock::Accesses) ++_accesses;
+		return currentTime();
+	}
+	double currentTime() const {
+		if (_clock == DecayClock::Accesses) return static_cast<double>(_accesses) / _halfLife;
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count() / _halfLife;
+	}
+
+	/**
+	* 衰减到 now 后加一：log2(2^(L - now) + 1) + now，按 L - now 的符号分别计算，避免 2^x 溢出
+	*/
+	static double bump(double score, double now) {
+		double d = score - now;
+		if (d > 0) return score + std::log1p(std::exp2(-d)) / kLn2;
+		return now + std::log1p(std::exp2(d)) / kLn2;
+	}
+
+	void touch(Entry& entry, double now) {
+		entry.score = bump(entry.score, now);
+		unlink(entry);
+		link(entry, bucketOf(entry.score));
+	}
+
+	static int64_t bucketOf(double score) {
+		return static_cast<int64_t>(std::floor(score * kBucketsPerUnit));
+	}
+
+	static size_t slotOf(int64_t bucket) {
+		return static_cast<size_t>(bucket) & (kBucketCount - 1);
+	}
+
+	/**
+	* 窗口底部跳过空桶，最多移到 limit；调用时至少有一个条目在桶中
+	*/
+	void skipEmptyBuckets(int64_t limit) {
+		while (_base < limit && !_buckets[slotOf(_base)].tail) {
+			++_base;
+		}
+	}
+
+	/**
+	* 放入桶头部；桶号低于窗口时放在最低的桶，窗口底部无法上移时放在最高的桶
+	*/
+	void link(Entry& entry, int64_t bucket) {
+		constexpr int64_t window = static_cast<int64_t>(kBucketCount);
+		if (_linked == 0) {
+			_base = bucket;
+		}
+		else if (bucket < _base) {
+			bucket = _base;
+		}
+		else if (bucket >= _base + window) {
+			skipEmptyBuckets(bucket - window + 1);
+			if (bucket >= _base + window) bucket = _base + window - 1;
+		}
+		entry.bucket = bucket;
+		Bucket& slot = _buckets[slotOf(bucket)];
+		entry.prev = nullptr;
+		entry.next = slot.head;
+		if (slot.head) slot.head->prev = &entry;
+		else slot.tail = &entry;
+		slot.head = &entry;
+		++_linked;
+	}
+
+	void unlink(Entry& entry) {
+		Bucket& slot = _buckets[slotOf(entry.bucket)];
+		if (entry.prev) entry.prev->next = entry.next;
+		else slot.head = entry.next;
+		if (entry.next) entry.next->prev = entry.prev;
+		else slot.tail = entry.prev;
+		entry.prev = entry.next = nullptr;
+		--_linked;
+	}
+
+	/**
+	* 从窗口底部向上找第一个非空桶，淘汰其中最久未访问的条目；窗口底部随之上移
+	*/
+	void evict() {
+		if (_linked == 0) return;
+		skipEmptyBuckets(std::numeric_limits<int64_t>::max());
+		Entry* victim = _buckets[slotOf(_base)].tail;
+		unlink(*victim);
+		_map.erase(_map.find(victim->node->first));
+		++_evictions;
+	}
+
+	static constexpr double kLn2 = 0.69314718055994530942;
+
+	std::mutex _mutex;
+	size_t _capacity;
+	double _halfLife;
+	DecayClock _clock;
+	std::chrono::steady_clock::time_point _start;
+	uint64_t _accesses = 0;
+	uint64_t _evictions = 0;
+	// 窗口底部的桶号，所有条目的桶号都在 [_base, _base + kBucketCount) 内
+	int64_t _base = 0;
+	size_t _linked = 0;
+	std::vector<Bucket> _buckets;
+	// unordered_map 的元素地址在扩容时不变，桶链表直接链接条目
+	std::unordered_map<Key, Entry> _map;
+};
+
+#endif // DECAYLFUCACHE_H
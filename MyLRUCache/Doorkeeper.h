@@ -0,0 +1,110 @@
+#pragma once
+#ifndef DOORKEEPER_H
+#define DOORKEEPER_H
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+/****************************************
+Doorkeeper
+
+写入准入的门卫：一个定期清空的 Bloom 过滤器，key 在同一个窗口内第二次出现时才允许写入缓存，
+只出现一次的 key（long-tail 中的大多数）不会挤掉缓存中的有用条目，也不会分配节点。
+位数组由原子 64 位字组成，多个线程（多个分片）可以共享同一个实例；
+每记录 windowSize 个新 key 清空一次，清空与并发写入之间的竞争只会让个别 key 多或少被记一次。
+****************************************/
+class Doorkeeper {
+public:
+	struct Stats {
+		uint64_t admitted = 0;		// 第二次出现，允许写入
+		uint64_t rejected = 0;		// 第一次出现，只记录不写入
+		uint64_t resets = 0;
+
+		double admitRate() const {
+			uint64_t total = admitted + rejected;
+			return total ? static_cast<double>(admitted) / static_cast<double>(total) : 0.0;
+		}
+	};
+
+	/**
+	* windowSize 为一个窗口内记录的 key 数，falsePositiveRate 为窗口写满时的误判率
+	*/
+	explicit Doorkeeper(size_t windowSize, double falsePositiveRate = 0.01)
+		: _windowSize(windowSize > 0 ? windowSize : 1) {
+		double p = falsePositiveRate > 0 && falsePositiveRate < 1 ? falsePositiveRate : 0.01;
+		double ln2 = std::log(2.0);
+		double bits = -static_cast<double>(_windowSize) * std::log(p) / (ln2 * ln2);
+		size_t words = 1;
+		while (static_cast<double>(words * 64) < bits) words <<= 1;
+		_wordMask = words - 1;
+		_bits = std::make_unique<std::atomic<uint64_t>[]>(words);
+		int hashes = static_cast<int>(std::lround(static_cast<double>(words * 64) / static_cast<double>(_windowSize) * ln2));
+		_hashes = hashes < 1 ? 1 : (hashes > 8 ? 8 : hashes);
+	}
+
+	/**
+	* 记录一次出现：之前在本窗口出现过返回 true（准入），否则记下并返回 false
+	*/
+	template<typename Key>
+	bool admit(const Key& key) {
+		uint64_t h = static_cast<uint64_t>(std::hash<Key>()(key)) * 0x9E3779B97F4A7C15ull;
+		// 双重哈希：第 i 个位置为 h1 + i * h2
+		uint64_t h1 = h ^ (h >> 29);
+		uint64_t h2 = (h >> 32) | 1;
+		bool seen = true;
+		for (int i = 0; i < _hashes; ++i) {
+			uint64_t bit = h1 + static_cast<uint64_t>(i) * h2;
+			std::atomic<uint64_t>& word = _bits[(bit >> 6) & _wordMask];
+			uint64_t mask = 1ull << (bit & 63);
+			// 已置位时只读不写，避免共享的缓存行反复失效
+			if (word.load(std::memory_order_relaxed) & mask) continue;
+			seen = false;
+			word.fetch_or(mask, std::memory_order_relaxed);
+		}
+		if (seen) {
+			_admitted.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+		_rejected.fetch_add(1, std::memory_order_relaxed);
+		if (_recorded.fetch_add(1, std::memory_order_relaxed) + 1 == _windowSize) {
+			reset();
+		}
+		return false;
+	}
+
+	/**
+	* 清空过滤器，开始新窗口
+	*/
+	void reset() {
+		_recorded.store(0, std::memory_order_relaxed);
+		for (size_t i = 0; i <= _wordMask; ++i) {
+			_bits[i].store(0, std::memory_order_relaxed);
+		}
+		_resets.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	Stats getStats() const {
+		Stats stats;
+		stats.admitted = _admitted.load(std::memory_order_relaxed);
+		stats.rejected = _rejected.load(std::memory_order_relaxed);
+		stats.resets = _resets.load(std::memory_order_relaxed);
+		return stats;
+	}
+	size_t bitCount() const { return (_wordMask + 1) * 64; }
+	int hashCount() const { return _hashes; }
+
+private:
+	size_t _windowSize;
+	size_t _wordMask;
+	int _hashes;
+	std::unique_ptr<std::atomic<uint64_t>[]> _bits;
+	std::atomic<size_t> _recorded{ 0 };
+	std::atomic<uint64_t> _admitted{ 0 };
+	std::atomic<uint64_t> _rejected{ 0 };
+	std::atomic<uint64_t> _resets{ 0 };
+};
+
+#endif // DOORKEEPER_H
@@ -0,0 +1,297 @@
+#pragma once
+#ifndef FLATHASHMAP_H
+#define FLATHASHMAP_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLATHASHMAP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/****************************************
+FlatHashMap
+
+Swiss table 风格的开放寻址哈希表，用作缓存分片的索引：
+	控制字节数组：每个槽位 1 字节，空 = 0x80，已删除 = 0xFE，占用 = 哈希低 7 位标签
+	槽位数组：连续存放 std::pair<const Key, T>
+查找时按 16 个槽位一组，用一次 SSE2 比较得到组内所有标签匹配的位置，只有标签相同的槽位才比较 key，
+因此大多数查找只访问一条控制字节缓存行和一个槽位。不支持 SSE2 的平台使用逐字节比较的标量实现。
+负载因子上限 7/8；接口是 LRUCache 用到的 std::unordered_map 子集，扩容后迭代器与引用失效。
+****************************************/
+template<typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap {
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using value_type = std::pair<const Key, T>;
+	using size_type = size_t;
+
+	class iterator {
+	public:
+		iterator() = default;
+		value_type& operator*() const { return _map->_slots[_index]; }
+		value_type* operator->() const { return &_map->_slots[_index]; }
+		iterator& operator++() {
+			++_index;
+			skipEmpty();
+			return *this;
+		}
+		bool operator==(const iterator& other) const { return _index == other._index; }
+		bool operator!=(const iterator& other) const { return _index != other._index; }
+	private:
+		friend class FlatHashMap;
+		iterator(const FlatHashMap* map, size_t index) : _map(const_cast<FlatHashMap*>(map)), _index(index) {}
+		void skipEmpty() {
+			while (_index < _map->_capacity && !isFull(_map->_ctrl[_index])) ++_index;
+		}
+		FlatHashMap* _map = nullptr;
+		size_t _index = 0;
+	};
+
+	FlatHashMap() { allocate(kGroupWidth); }
+	~FlatHashMap() { destroy(); }
+	FlatHashMap(const FlatHashMap&) = delete;
+	FlatHashMap& operator=(const FlatHashMap&) = delete;
+
+	iterator begin() const {
+		iterator it(this, 0);
+		it.skipEmpty();
+		return it;
+	}
+	iterator end() const { return iterator(this, _capacity); }
+
+	size_t size() const { return _size; }
+	bool empty() const { return _size == 0; }
+	size_t capacity() const { return _capacity; }
+
+	iterator find(const Key& key) const {
+		return iterator(this, findIndex(key, hashOf(key)));
+	}
+
+	T& operator[](const Key& key) {
+		size_t hash = hashOf(key);
+		size_t index = findIndex(key, hash);
+		if (index == _capacity) {
+			index = prepareInsert(hash);
+			new (&_slots[index]) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple());
+		}
+		return _slots[index].second;
+	}
+
+	size_t erase(const Key& key) {
+		size_t index = findIndex(key, hashOf(key));
+		if (index == _capacity) return 0;
+		eraseAt(index);
+		return 1;
+	}
+	void erase(iterator it) { eraseAt(it._index); }
+
+	void clear() {
+		destroy();
+		allocate(kGroupWidth);
+	}
+
+	/**
+	* 预留至少能放下 count 个元素的空间
+	*/
+	void reserve(size_t count) {
+		size_t capacity = _capacity;
+		while (count > capacity - capacity / 8) capacity *= 2;
+		if (capacity != _capacity) rehash(capacity);
+	}
+
+private:
+	static constexpr size_t kGroupWidth = 16;
+	static constexpr int8_t kEmpty = -128;
+	static constexpr int8_t kDeleted = -2;
+
+	static bool isFull(int8_t ctrl) { return ctrl >= 0; }
+
+	/**
+	* 16 个控制字节的一次比较，结果为 16 位掩码，第 i 位对应组内第 i 个槽位
+	*/
+	struct Group {
+		explicit Group(const int8_t* ctrl) {
+#ifdef FLATHASHMAP_SSE2
+			_ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+			std::memcpy(_ctrl, ctrl, kGroupWidth);
+#endif
+		}
+		uint32_t match(int8_t tag) const {
+#ifdef FLATHASHMAP_SSE2
+			return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(tag), _ctrl)));
+#else
+			uint32_t mask = 0;
+			for (size_t i = 0; i < kGroupWidth; ++i) {
+				mask |= static_cast<uint32_t>(_ctrl[i] == tag) << i;
+			}
+			return mask;
+#endif
+		}
+		uint32_t matchEmpty() const { return match(kEmpty); }
+		// 空与已删除的最高位都是 1，占用槽位的最高位是 0
+		uint32_t matchEmptyOrDeleted() const {
+#ifdef FLATHASHMAP_SSE2
+			return static_cast<uint32_t>(_mm_movemask_epi8(_ctrl));
+#else
+			uint32_t mask = 0;
+			for (size_t i = 0; i < kGroupWidth; ++i) {
+				mask |= static_cast<uint32_t>(_ctrl[i] < 0) << i;
+			}
+			return mask;
+#endif
+		}
+#ifdef FLATHASHMAP_SSE2
+		__m128i _ctrl;
+#else
+		int8_t _ctrl[kGroupWidth];
+#endif
+	};
+
+	static int lowestBit(uint32_t mask) { return std::countr_zero(mask); }
+	static int leadingZeros16(uint32_t mask) { return std::countl_zero(static_cast<uint16_t>(mask)); }
+	static int trailingZeros16(uint32_t mask) { return std::countr_zero(static_cast<uint16_t>(mask)); }
+
+	/**
+	* 打散哈希值：std::hash 对整数通常是恒等映射，直接取低位会让相邻 key 落在同一组
+	*/
+	size_t hashOf(const Key& key) const {
+		uint64_t h = static_cast<uint64_t>(Hash()(key));
+		h ^= h >> 32;
+		h *= 0x9E3779B97F4A7C15ull;
+		h ^= h >> 29;
+		return static_cast<size_t>(h);
+	}
+	static int8_t tagOf(size_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+	size_t homeOf(size_t hash) const { return (hash >> 7) & (_capacity - 1); }
+
+	/**
+	* 按组做三角探测（步长 16、32、48...），容量为 2 的幂时会访问到每一组
+	*/
+	size_t findIndex(const Key& key, size_t hash) const {
+		size_t mask = _capacity - 1;
+		size_t offset = homeOf(hash);
+		int8_t tag = tagOf(hash);
+		for (size_t step = kGroupWidth;; step += kGroupWidth) {
+			Group group(_ctrl + offset);
+			for (uint32_t bits = group.match(tag); bits; bits &= bits - 1) {
+				size_t index = (offset + static_cast<size_t>(lowestBit(bits))) & mask;
+				if (KeyEqual()(_slots[index].first, key)) return index;
+			}
+			if (group.matchEmpty()) return _capacity;
+			offset = (offset + step) & mask;
+		}
+	}
+
+	size_t findInsertSlot(size_t hash) const {
+		size_t mask = _capacity - 1;
+		size_t offset = homeOf(hash);
+		for (size_t step = kGroupWidth;; step += kGroupWidth) {
+			uint32_t bits = Group(_ctrl + offset).matchEmptyOrDeleted();
+			if (bits) return (offset + static_cast<size_t>(lowestBit(bits))) & mask;
+			offset = (offset + step) & mask;
+		}
+	}
+
+	/**
+	* 为一个新元素找到槽位并写好控制字节，必要时先扩容或原地清理墓碑
+	*/
+	size_t prepareInsert(size_t hash) {
+		size_t index = findInsertSlot(hash);
+		if (_growthLeft == 0 && _ctrl[index] != kDeleted) {
+			// 墓碑多时原地重建即可，否则翻倍
+			rehash(_size * 2 <= maxLoad(_capacity) ? _capacity : _capacity * 2);
+			index = findInsertSlot(hash);
+		}
+		if (_ctrl[index] == kEmpty) --_growthLeft;
+		setCtrl(index, tagOf(hash));
+		++_size;
+		return index;
+	}
+
+	void eraseAt(size_t index) {
+		_slots[index].~value_type();
+		--_size;
+		// 如果该位置前后连续的占用槽位不足一组，任何探测都不会越过它，可以直接置空而不留墓碑
+		size_t before = (index - kGroupWidth) & (_capacity - 1);
+		uint32_t emptyAfter = Group(_ctrl + index).matchEmpty();
+		uint32_t emptyBefore = Group(_ctrl + before).matchEmpty();
+		bool neverFull = emptyBefore && emptyAfter
+			&& static_cast<size_t>(trailingZeros16(emptyAfter) + leadingZeros16(emptyBefore)) < kGroupWidth;
+		if (neverFull) {
+			setCtrl(index, kEmpty);
+			++_growthLeft;
+		}
+		else {
+			setCtrl(index, kDeleted);
+		}
+	}
+
+	/**
+	* 控制字节数组末尾复制了前 16 个字节，跨越末尾的组可以一次读出
+	*/
+	void setCtrl(size_t index, int8_t value) {
+		_ctrl[index] = value;
+		if (index < kGroupWidth) _ctrl[_capacity + index] = value;
+	}
+
+	static size_t maxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+	void allocate(size_t capacity) {
+		_capacity = capacity;
+		_ctrl = new int8_t[capacity + kGroupWidth];
+		std::memset(_ctrl, static_cast<unsigned char>(kEmpty), capacity + kGroupWidth);
+		_slots = std::allocator<value_type>().allocate(capacity);
+		_size = 0;
+		_growthLeft = maxLoad(capacity);
+	}
+
+	void destroy() {
+		for (size_t i = 0; i < _capacity; ++i) {
+			if (isFull(_ctrl[i])) _slots[i].~value_type();
+		}
+		std::allocator<value_type>().deallocate(_slots, _capacity);
+		delete[] _ctrl;
+		_slots = nullptr;
+		_ctrl = nullptr;
+		_capacity = 0;
+		_size = 0;
+	}
+
+	void rehash(size_t newCapacity) {
+		int8_t* oldCtrl = _ctrl;
+		value_type* oldSlots = _slots;
+		size_t oldCapacity = _capacity;
+		allocate(newCapacity);
+		for (size_t i = 0; i < oldCapacity; ++i) {
+			if (!isFull(oldCtrl[i])) continue;
+			size_t hash = hashOf(oldSlots[i].first);
+			size_t index = findInsertSlot(hash);
+			setCtrl(index, tagOf(hash));
+			new (&_slots[index]) value_type(std::move(oldSlots[i]));
+			oldSlots[i].~value_type();
+			++_size;
+			--_growthLeft;
+		}
+		std::allocator<value_type>().deallocate(oldSlots, oldCapacity);
+		delete[] oldCtrl;
+	}
+
+	int8_t* _ctrl = nullptr;
+	value_type* _slots = nullptr;
+	size_t _capacity = 0;
+	size_t _size = 0;
+	size_t _growthLeft = 0;
+};
+
+#endif // FLATHASHMAP_H
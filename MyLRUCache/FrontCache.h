@@ -0,0 +1,166 @@
+#pragma once
+#ifndef FRONTCACHE_H
+#define FRONTCACHE_H
+
+#include "LRUCache.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/****************************************
+FrontCache
+
+HashLRUCache 前面的线程私有 L1：每个线程一张直接映射的小表（默认 256 项），
+命中时不加任何锁，未命中时转发给共享的 HashLRUCache 并填入 L1。
+L1 中每项记录填入时 key 所在条带的版本号，读取时与 HashLRUCache::version 比较，
+不一致说明期间有 put/remove，视为未命中，因此不会读到被改写之前的值。
+容量淘汰不修改版本号，已被后端淘汰但未被改写的值仍可能从 L1 读到，这部分最多为 L1 的大小。
+****************************************/
+template<typename Key, typename Value, template<typename...> class MapT = FlatHashMap>
+class FrontCache {
+public:
+	using Backing = HashLRUCache<Key, Value, MapT>;
+
+	struct Stats {
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t staleRejects = 0;
+
+		double hitRate() const {
+			uint64_t total = hits + misses;
+			return total ? static_cast<double>(hits) / static_cast<double>(total) : 0.0;
+		}
+	};
+
+	/**
+	* entries 为每个线程 L1 的项数，向上取到 2 的幂
+	*/
+	FrontCache(Backing& backing, size_t entries = 256)
+		: _backing(backing), _id(nextId()) {
+		_entries = 1;
+		while (_entries < entries) _entries <<= 1;
+	}
+	FrontCache(const FrontCache&) = delete;
+	FrontCache& operator=(const FrontCache&) = delete;
+
+	bool get(Key key, Value& value) {
+		Table& table = local();
+		Entry& entry = table.entries[indexOf(key)];
+		uint64_t version = _backing.version(key);
+		if (entry.valid && entry.key == key) {
+			if (entry.version == version) {
+				value = entry.value;
+				bump(table.hits);
+				return true;
+			}
+			bump(table.staleRejects);
+		}
+		bump(table.misses);
+		// 版本号在读值之前取得，读值之后若有写入，这一项会在下次读取时被判定为过期
+		if (!_backing.get(key, value)) {
+			entry.valid = false;
+			return false;
+		}
+		entry.key = key;
+		entry.value = value;
+		entry.version = version;
+		entry.valid = true;
+		return true;
+	}
+	Value get(Key key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+	void put(Key key, Value value) {
+		_backing.put(key, value);
+	}
+	void remove(Key key) {
+		_backing.remove(key);
+	}
+
+	/**
+	* 汇总所有线程的命中统计
+	*/
+	Stats getStats() const {
+		Stats stats;
+		std::lock_guard<std::mutex> lock(_tableMutex);
+		for (auto& table : _tables) {
+			stats.hits += table->hits.load(std::memory_order_relaxed);
+			stats.misses += table->misses.load(std::memory_order_relaxed);
+			stats.staleRejects += table->staleRejects.load(std::memory_order_relaxed);
+		}
+		return stats;
+	}
+
+private:
+	struct Entry {
+		Key key{};
+		Value value{};
+		uint64_t version = 0;
+		bool valid = false;
+	};
+	struct Table {
+		std::thread::id owner;
+		std::vector<Entry> entries;
+		// 只由所属线程写，getStats 读
+		std::atomic<uint64_t> hits{ 0 };
+		std::atomic<uint64_t> misses{ 0 };
+		std::atomic<uint64_t> staleRejects{ 0 };
+	};
+
+	static void bump(std::atomic<uint64_t>& counter) {
+		counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	size_t indexOf(const Key& key) const {
+		uint64_t h = static_cast<uint64_t>(std::hash<Key>()(key)) * 0x9E3779B97F4A7C15ull;
+		return static_cast<size_t>(h >> 32) & (_entries - 1);
+	}
+
+	/**
+	* 当前线程的 L1 表，首次访问时注册
+	*/
+	Table& local() {
+		thread_local uint64_t cachedOwner = 0;
+		thread_local Table* cachedTable = nullptr;
+		if (cachedOwner == _id) {
+			return *cachedTable;
+		}
+		std::lock_guard<std::mutex> lock(_tableMutex);
+		auto self = std::this_thread::get_id();
+		Table* table = nullptr;
+		for (auto& entry : _tables) {
+			if (entry->owner == self) {
+				table = entry.get();
+				break;
+			}
+		}
+		if (!table) {
+			_tables.push_back(std::make_unique<Table>());
+			table = _tables.back().get();
+			table->owner = self;
+			table->entries.resize(_entries);
+		}
+		cachedOwner = _id;
+		cachedTable = table;
+		return *table;
+	}
+
+	static uint64_t nextId() {
+		static std::atomic<uint64_t> counter{ 0 };
+		return ++counter;
+	}
+
+	Backing& _backing;
+	size_t _entries;
+	const uint64_t _id;
+	mutable std::mutex _tableMutex;
+	std::vector<std::unique_ptr<Table>> _tables;
+};
+
+#endif // FRONTCACHE_H
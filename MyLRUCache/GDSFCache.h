@@ -0,0 +1,260 @@
+#pragma once
+#ifndef GDSFCACHE_H
+#define GDSFCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/****************************************
+GDSFCache
+
+按 GreedyDual-Size-Frequency 淘汰的缓存，目标是让未命中的总代价最小，而不是未命中次数最少。
+每个条目带有未命中代价 cost（如回源耗时）与大小 size，优先级 H = L + freq * cost / size，
+淘汰 H 最小的条目，并把膨胀值 L 提升到被淘汰条目的 H：
+	之后新写入或被访问的条目都以更高的 L 为起点，长期不被访问的条目相对变老，不会因历史频次常驻；
+	代价高、体积小、访问频繁的条目最晚被淘汰。
+容量按 size 计，条目的 size 之和不超过容量，单个 size 超过容量的条目不写入。
+条目放在索引最小堆里，命中与写入都是 O(log n)；H 相同时先淘汰最久未访问的，cost 全为 0 时退化为按大小计容量的 LRU。
+统计中 put 一个不存在的 key 视为未命中后的回填，按其 cost 计入未命中代价。
+****************************************/
+template<typename Key, typename Value>
+class GDSFCache {
+public:
+	struct Stats {
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+		double hitCost = 0;
+		double missCost = 0;
+
+		double hitRate() const {
+			uint64_t total = hits + misses;
+			return total ? static_cast<double>(hits) / static_cast<double>(total) : 0.0;
+		}
+		/**
+		* 按代价加权的命中率：命中省下的代价占总代价的比例
+		*/
+		double costHitRate() const {
+			double total = hitCost + missCost;
+			return total > 0 ? hitCost / total : 0.0;
+		}
+	};
+
+	explicit GDSFCache(size_t capacity) : _capacity(capacity) {}
+
+	bool get(Key key, Value& value) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _map.find(key);
+		if (it == _map.end()) {
+			++_stats.misses;
+			return false;
+		}
+		Entry& entry = it->second;
+		value = entry.value;
+		++_stats.hits;
+		_stats.hitCost += entry.cost;
+		++entry.freq;
+		touch(entry);
+		return true;
+	}
+	Value get(Key key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+
+	/**
+	* 写入或更新条目；更新视为一次访问，频次加一并使用新的 cost 与 size
+	*/
+	void put(Key key, Value value, double cost, size_t size) {
+		if (size == 0) size = 1;
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _map.find(key);
+		if (it != _map.end()) {
+			Entry& entry = it->second;
+			_used -= entry.size;
+			if (size > _capacity) {
+				removeAt(entry.heapIndex);
+				return;
+			}
+			entry.value = value;
+			entry.cost = cost;
+			entry.size = size;
+			++entry.freq;
+			// 腾出空间时先把自己移出堆，避免淘汰正在更新的条目
+			detach(entry.heapIndex);
+			makeRoom(size);
+			entry.heapIndex = _heap.size();
+			_heap.push_back(&entry);
+			_used += size;
+			touch(entry);
+			return;
+		}
+		_stats.missCost += cost;
+		if (size > _capacity) return;
+		makeRoom(size);
+		auto& node = *_map.try_emplace(key).first;
+		Entry& entry = node.second;
+		entry.value = value;
+		entry.cost = cost;
+		entry.size = size;
+		entry.freq = 1;
+		entry.node = &node;
+		entry.heapIndex = _heap.size();
+		_heap.push_back(&entry);
+		_used += size;
+		touch(entry);
+	}
+	/**
+	* 代价与大小都为 1 时，GDSF 相当于带老化的 LFU
+	*/
+	void put(Key key, Value value) {
+		put(key, value, 1.0, 1);
+	}
+
+	bool remove(Key key) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _map.find(key);
+		if (it == _map.end()) return false;
+		_used -= it->second.size;
+		removeAt(it->second.heapIndex);
+		return true;
+	}
+
+	size_t size() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _map.size();
+	}
+	/**
+	* 当前条目 size 之和
+	*/
+	size_t usedSize() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _used;
+	}
+	size_t getCapacity() const { return _capacity; }
+	/**
+	* 当前的膨胀值 L
+	*/
+	double inflation() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _inflation;
+	}
+	Stats getStats() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _stats;
+	}
+	void resetStats() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stats = Stats();
+	}
+
+private:
+	struct Entry {
+		Value value{};
+		double cost = 0;
+		size_t size = 1;
+		uint64_t freq = 0;
+		double priority = 0;
+		// 最近一次访问的序号，优先级相同时先淘汰更旧的
+		uint64_t stamp = 0;
+		size_t heapIndex = 0;
+		std::pair<const Key, Entry>* node = nullptr;
+	};
+
+	/**
+	* 按当前 L 与频次重新计算优先级并调整堆位置
+	*/
+	void touch(Entry& entry) {
+		entry.priority = _inflation + static_cast<double>(entry.freq) * entry.cost / static_cast<double>(entry.size);
+		entry.stamp = ++_clock;
+		siftUp(entry.heapIndex);
+		siftDown(entry.heapIndex);
+	}
+
+	/**
+	* 淘汰堆顶直到能放下 size，L 提升到最后一个被淘汰条目的优先级
+	*/
+	void makeRoom(size_t size) {
+		while (_used + size > _capacity) {
+			Entry* victim = _heap[0];
+			_inflation = victim->priority;
+			_used -= victim->size;
+			++_stats.evictions;
+			removeAt(0);
+		}
+	}
+
+	/**
+	* 从堆中移除下标 index 处的条目，条目本身仍留在 map 中
+	*/
+	void detach(size_t index) {
+		size_t last = _heap.size() - 1;
+		if (index != last) {
+			Entry* moved = _heap[last];
+			place(moved, index);
+			_heap.pop_back();
+			siftUp(index);
+			siftDown(moved->heapIndex);
+		}
+		else {
+			_heap.pop_back();
+		}
+	}
+
+	void removeAt(size_t index) {
+		Entry* entry = _heap[index];
+		detach(index);
+		_map.erase(_map.find(entry->node->first));
+	}
+
+	static bool less(const Entry* a, const Entry* b) {
+		return a->priority < b->priority || (a->priority == b->priority && a->stamp < b->stamp);
+	}
+
+	void place(Entry* entry, size_t index) {
+		_heap[index] = entry;
+		entry->heapIndex = index;
+	}
+
+	void siftUp(size_t index) {
+		Entry* entry = _heap[index];
+		while (index > 0) {
+			size_t parent = (index - 1) / 2;
+			if (!less(entry, _heap[parent])) break;
+			place(_heap[parent], index);
+			index = parent;
+		}
+		place(entry, index);
+	}
+
+	void siftDown(size_t index) {
+		Entry* entry = _heap[index];
+		size_t count = _heap.size();
+		while (true) {
+			size_t child = index * 2 + 1;
+			if (child >= count) break;
+			if (child + 1 < count && less(_heap[child + 1], _heap[child])) ++child;
+			if (!less(_heap[child], entry)) break;
+			place(_heap[child], index);
+			index = child;
+		}
+		place(entry, index);
+	}
+
+	std::mutex _mutex;
+	size_t _capacity;
+	size_t _used = 0;
+	double _inflation = 0;
+	uint64_t _clock = 0;
+	// unordered_map 的元素地址在扩容时不变，堆中直接存放条目指针
+	std::unordered_map<Key, Entry> _map;
+	std::vector<Entry*> _heap;
+	Stats _stats;
+};
+
+#endif // GDSFCACHE_H
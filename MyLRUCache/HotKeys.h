@@ -0,0 +1,431 @@
+#pragma once
+#ifndef HOTKEYS_H
+#define HOTKEYS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/****************************************
+SpaceSaving
+
+Space-Saving 频繁项统计：固定 k 个计数器，已监视的 key 计数加一；
+未监视的 key 顶替计数最小的计数器，继承其计数并把继承值记为误差上界。
+出现频率超过 1/k 的 key 一定在监视中，count - error 是其真实次数的下界。
+非线程安全。
+****************************************/
+template<typename Key>
+class SpaceSaving {
+public:
+	struct Counter {
+		Key key;
+		uint64_t count;
+		uint64_t error;
+	};
+
+	explicit SpaceSaving(size_t k) : _k(k > 0 ? k : 1) {
+		_counters.reserve(_k);
+		_index.reserve(_k);
+	}
+
+	void offer(const Key& key) {
+		++_total;
+		auto it = _index.find(key);
+		if (it != _index.end()) {
+			++_counters[it->second].count;
+			return;
+		}
+		if (_counters.size() < _k) {
+			_index.emplace(key, _counters.size());
+			_counters.push_back({ key, 1, 0 });
+			return;
+		}
+		// k 很小，线性找最小计数器即可
+		size_t victim = 0;
+		for (size_t i = 1; i < _counters.size(); ++i) {
+			if (_counters[i].count < _counters[victim].count) victim = i;
+		}
+		Counter& counter = _counters[victim];
+		_index.erase(counter.key);
+		_index.emplace(key, victim);
+		counter.error = counter.count;
+		counter.key = key;
+		++counter.count;
+	}
+
+	/**
+	* 按计数从大到小排列的计数器
+	*/
+	std::vector<Counter> top() const {
+		std::vector<Counter> counters = _counters;
+		std::sort(counters.begin(), counters.end(), [](const Counter& a, const Counter& b) { return a.count > b.count; });
+		return counters;
+	}
+	uint64_t total() const { return _total; }
+
+	void reset() {
+		_counters.clear();
+		_index.clear();
+		_total = 0;
+	}
+
+private:
+	size_t _k;
+	uint64_t _total = 0;
+	std::vector<Counter> _counters;
+	std::unordered_map<Key, size_t> _index;
+};
+
+struct HotKeyOptions {
+	// 复制结构中最多容纳的热点 key 数
+	size_t maxKeys = 32;
+	// 在所属分片一个窗口的采样中至少占这个比例（按 Space-Saving 的下界计）才算热点
+	double minShare = 0.02;
+	// 每个线程每 sampleRate 次读取采样一次
+	uint32_t sampleRate = 16;
+	// 每个分片采样满 window 次结算一次候选并刷新复制结构
+	uint64_t window = 1024;
+	// 每个分片的 Space-Saving 计数器数
+	size_t counters = 64;
+};
+
+/****************************************
+HotKeyStats
+
+按采样估计的各分片读负载：samples 为落到分片上的采样读，hotSamples 为其中由热点副本直接返回、没有进入分片锁的部分
+****************************************/
+struct HotKeyStats {
+	std::vector<uint64_t> samples;
+	std::vector<uint64_t> hotSamples;
+	size_t hotKeys = 0;
+	uint64_t refreshes = 0;
+
+	/**
+	* 最忙分片与平均值之比；lockedOnly 为 true 时只计进入分片锁的读
+	*/
+	double skew(bool lockedOnly = false) const {
+		uint64_t total = 0, busiest = 0;
+		for (size_t i = 0; i < samples.size(); ++i) {
+			uint64_t load = lockedOnly ? samples[i] - hotSamples[i] : samples[i];
+			total += load;
+			busiest = std::max(busiest, load);
+		}
+		return total ? static_cast<double>(busiest) * static_cast<double>(samples.size()) / static_cast<double>(total) : 0.0;
+	}
+	double hotShare() const {
+		uint64_t total = 0, hot = 0;
+		for (size_t i = 0; i < samples.size(); ++i) {
+			total += samples[i];
+			hot += hotSamples[i];
+		}
+		return total ? static_cast<double>(hot) / static_cast<double>(total) : 0.0;
+	}
+};
+
+/****************************************
+HotKeyReplica
+
+分片缓存的热点 key 检测与读复制：
+	每个分片一个 Space-Saving，读路径按线程计数采样，采样时对分片的统计锁只 try_lock，忙时放弃这次采样；
+	分片采样满一个窗口后结算候选热点，由所属缓存读出这些 key 的当前值，发布为一个不可变的小哈希表。
+发布用 RCU 的方式：新表整体替换旧表并递增代数，各线程把当前表的 shared_ptr 缓存在 thread_local 中，
+代数不变时直接使用，读路径上没有加锁与引用计数的写；旧表在最后一个线程换到新表后释放。
+每个热点 key 占用一条 lane（独占缓存行的版本号），表项记录发布前读到的 lane 版本号，版本号一致才有效；
+lane 的分配表在读取候选的值之前先发布，写入这些 key 时按分配表递增 lane，
+因此刷新途中发生的写入也会使正在发布的表项失效，其他 key 的写入不影响热点表项。
+key 在保持热点期间 lane 不变，lane 被收回或改派时先递增，旧表中的表项随之失效。
+****************************************/
+template<typename Key, typename Value>
+class HotKeyReplica {
+public:
+	struct Entry {
+		Key key;
+		Value value;
+		size_t lane;
+		uint64_t version;
+	};
+
+	HotKeyReplica(size_t shardNum, const HotKeyOptions& options)
+		: _options(options), _id(nextId()), _shards(std::make_unique<Shard[]>(shardNum)), _shardNum(shardNum) {
+		if (_options.sampleRate == 0) _options.sampleRate = 1;
+		if (_options.window == 0) _options.window = 1;
+		if (_options.maxKeys == 0) _options.maxKeys = 1;
+		for (size_t i = 0; i < _shardNum; ++i) _shards[i].counters = std::make_unique<SpaceSaving<Key>>(_options.counters);
+		_lanes = std::make_unique<Lane[]>(_options.maxKeys);
+		for (size_t i = _options.maxKeys; i > 0; --i) _freeLanes.push_back(i - 1);
+	}
+	HotKeyReplica(const HotKeyReplica&) = delete;
+	HotKeyReplica& operator=(const HotKeyReplica&) = delete;
+
+	const HotKeyOptions& options() const { return _options; }
+
+	/**
+	* 在当前发布的表中查找有效的表项，返回的指针在本线程下一次调用 find 之前有效
+	*/
+	const Entry* find(const Key& key, size_t hash) {
+		const Entry* entry = lookup(key, hash);
+		return entry && _lanes[entry->lane].version.load() == entry->version ? entry : nullptr;
+	}
+
+	/**
+	* key 已被改写：若它分配了 lane，递增该 lane。调用者先改写分片，再调用这里
+	*/
+	void invalidate(const Key& key) {
+		Reader& reader = local();
+		refreshReader(reader);
+		if (!reader.lanes) return;
+		auto it = reader.lanes->find(key);
+		if (it != reader.lanes->end()) invalidateLane(it->second);
+	}
+	void invalidateLane(size_t lane) {
+		_lanes[lane].version.fetch_add(1);
+	}
+	void invalidateAll() {
+		for (size_t i = 0; i < _options.maxKeys; ++i) invalidateLane(i);
+	}
+
+	/**
+	* 记录一次落在 shard 上的读，served 表示由副本返回；返回 true 表示该分片刚结算完一个窗口，应刷新副本
+	*/
+	bool sample(const Key& key, size_t shard, bool served) {
+		thread_local uint32_t tick = 0;
+		if (++tick % _options.sampleRate != 0) return false;
+		Shard& state = _shards[shard];
+		std::unique_lock<std::mutex> lock(state.mutex, std::try_to_lock);
+		if (!lock.owns_lock()) return false;
+		++state.samples;
+		if (served) ++state.hotSamples;
+		state.counters->offer(key);
+		if (state.counters->total() < _options.window) return false;
+		double window = static_cast<double>(state.counters->total());
+		state.candidates.clear();
+		for (const auto& counter : state.counters->top()) {
+			double share = static_cast<double>(counter.count - counter.error) / window;
+			if (share < _options.minShare) break;
+			state.candidates.push_back({ counter.key, share });
+		}
+		state.counters->reset();
+		return true;
+	}
+
+	/**
+	* 串行化刷新：同一时刻只有一个线程读取候选的当前值并发布，下面几个刷新用的函数都需持有它
+	*/
+	std::unique_lock<std::mutex> tryBeginRefresh() {
+		return std::unique_lock<std::mutex>(_refreshMutex, std::try_to_lock);
+	}
+
+	/**
+	* 各分片最近一个窗口的候选，按占比从大到小取前 maxKeys 个
+	*/
+	std::vector<Key> candidates() {
+		std::vector<Candidate> all;
+		for (size_t i = 0; i < _shardNum; ++i) {
+			std::lock_guard<std::mutex> lock(_shards[i].mutex);
+			all.insert(all.end(), _shards[i].candidates.begin(), _shards[i].candidates.end());
+		}
+		std::sort(all.begin(), all.end(), [](const Candidate& a, const Candidate& b) { return a.share > b.share; });
+		if (all.size() > _options.maxKeys) all.resize(_options.maxKeys);
+		std::vector<Key> keys;
+		for (auto& candidate : all) keys.push_back(candidate.key);
+		return keys;
+	}
+
+	/**
+	* 为新的热点集合分配 lane：仍是热点的 key 保留原 lane，不再是热点的 key 的 lane 递增后收回。
+	* 返回前发布新的分配表，之后的写入都会递增对应的 lane，调用者在这之后再读 lane 版本号与值
+	*/
+	std::vector<size_t> assignLanes(const std::vector<Key>& keys) {
+		std::unordered_map<Key, size_t> assigned;
+		for (const Key& key : keys) {
+			auto it = _laneOf.find(key);
+			if (it == _laneOf.end()) continue;
+			assigned.emplace(key, it->second);
+			_laneOf.erase(it);
+		}
+		for (auto& [key, lane] : _laneOf) {
+			invalidateLane(lane);
+			_freeLanes.push_back(lane);
+		}
+		std::vector<size_t> lanes;
+		for (const Key& key : keys) {
+			auto it = assigned.find(key);
+			if (it == assigned.end()) {
+				it = assigned.emplace(key, _freeLanes.back()).first;
+				_freeLanes.pop_back();
+			}
+			lanes.push_back(it->second);
+		}
+		_laneOf = std::move(assigned);
+		auto laneTable = std::make_shared<const LaneTable>(_laneOf);
+		{
+			std::lock_guard<std::mutex> lock(_publishMutex);
+			_laneTable = std::move(laneTable);
+			_generation.fetch_add(1);
+		}
+		return lanes;
+	}
+	uint64_t laneVersion(size_t lane) const {
+		return _lanes[lane].version.load();
+	}
+
+	/**
+	* 发布新的副本表；entries 的 hash 与 find 时传入的一致
+	*/
+	void publish(std::vector<std::pair<size_t, Entry>> entries) {
+		std::shared_ptr<const Table> table = entries.empty() ? nullptr : std::make_shared<const Table>(std::move(entries));
+		std::lock_guard<std::mutex> lock(_publishMutex);
+		_table = std::move(table);
+		++_refreshes;
+		_generation.fetch_add(1);
+	}
+
+	HotKeyStats getStats() {
+		HotKeyStats stats;
+		for (size_t i = 0; i < _shardNum; ++i) {
+			std::lock_guard<std::mutex> lock(_shards[i].mutex);
+			stats.samples.push_back(_shards[i].samples);
+			stats.hotSamples.push_back(_shards[i].hotSamples);
+		}
+		std::lock_guard<std::mutex> lock(_publishMutex);
+		stats.hotKeys = _table ? _table->size() : 0;
+		stats.refreshes = _refreshes;
+		return stats;
+	}
+	std::vector<Key> hotKeys() {
+		std::lock_guard<std::mutex> lock(_publishMutex);
+		return _table ? _table->keys() : std::vector<Key>();
+	}
+
+private:
+	struct Candidate {
+		Key key;
+		double share;
+	};
+
+	/**
+	* 发布后只读的开放寻址表，槽位数为表项数的 2 倍以上取 2 的幂
+	*/
+	class Table {
+	public:
+		explicit Table(std::vector<std::pair<size_t, Entry>> entries) {
+			size_t slots = 2;
+			while (slots < entries.size() * 2) slots <<= 1;
+			_mask = slots - 1;
+			_slots.resize(slots);
+			for (auto& [hash, entry] : entries) {
+				size_t index = mix(hash) & _mask;
+				while (_slots[index].used) index = (index + 1) & _mask;
+				_slots[index].used = true;
+				_slots[index].hash = hash;
+				_slots[index].entry = std::make_unique<Entry>(std::move(entry));
+				++_size;
+			}
+		}
+		const Entry* find(const Key& key, size_t hash) const {
+			size_t index = mix(hash) & _mask;
+			while (_slots[index].used) {
+				if (_slots[index].hash == hash && _slots[index].entry->key == key) return _slots[index].entry.get();
+				index = (index + 1) & _mask;
+			}
+			return nullptr;
+		}
+		size_t size() const { return _size; }
+		std::vector<Key> keys() const {
+			std::vector<Key> keys;
+			for (auto& slot : _slots) {
+				if (slot.used) keys.push_back(slot.entry->key);
+			}
+			return keys;
+		}
+	private:
+		struct Slot {
+			bool used = false;
+			size_t hash = 0;
+			std::unique_ptr<Entry> entry;
+		};
+		static size_t mix(size_t hash) {
+			return static_cast<size_t>((static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull) >> 32);
+		}
+		std::vector<Slot> _slots;
+		size_t _mask = 0;
+		size_t _size = 0;
+	};
+
+	struct alignas(64) Shard {
+		std::mutex mutex;
+		std::unique_ptr<SpaceSaving<Key>> counters;
+		std::vector<Candidate> candidates;
+		uint64_t samples = 0;
+		uint64_t hotSamples = 0;
+	};
+
+	using LaneTable = std::unordered_map<Key, size_t>;
+
+	struct Reader {
+		uint64_t owner = 0;
+		uint64_t generation = 0;
+		std::shared_ptr<const Table> table;
+		std::shared_ptr<const LaneTable> lanes;
+	};
+
+	struct alignas(64) Lane {
+		std::atomic<uint64_t> version{ 0 };
+	};
+
+	/**
+	* 在本线程缓存的表中查找，代数变化时先换到最新的表
+	*/
+	const Entry* lookup(const Key& key, size_t hash) {
+		Reader& reader = local();
+		refreshReader(reader);
+		return reader.table ? reader.table->find(key, hash) : nullptr;
+	}
+	void refreshReader(Reader& reader) {
+		uint64_t generation = _generation.load();
+		if (reader.owner == _id && reader.generation == generation) return;
+		std::lock_guard<std::mutex> lock(_publishMutex);
+		reader.owner = _id;
+		reader.generation = _generation.load();
+		reader.table = _table;
+		reader.lanes = _laneTable;
+	}
+
+	/**
+	* 当前线程缓存的表；同一线程交替访问多个实例时每次切换都会重新取一次
+	*/
+	static Reader& local() {
+		thread_local Reader reader;
+		return reader;
+	}
+
+	static uint64_t nextId() {
+		static std::atomic<uint64_t> counter{ 0 };
+		return ++counter;
+	}
+
+	HotKeyOptions _options;
+	const uint64_t _id;
+	std::unique_ptr<Shard[]> _shards;
+	size_t _shardNum;
+	// 以下 lane 分配由 _refreshMutex 保护
+	std::mutex _refreshMutex;
+	std::unique_ptr<Lane[]> _lanes;
+	std::unordered_map<Key, size_t> _laneOf;
+	std::vector<size_t> _freeLanes;
+	// 保护 _table、_laneTable 本身的替换与读取，读路径只在代数变化时进入
+	std::mutex _publishMutex;
+	std::shared_ptr<const Table> _table;
+	// 最近一次分配的 lane，写路径按它递增 lane；比 _table 先发布
+	std::shared_ptr<const LaneTable> _laneTable;
+	std::atomic<uint64_t> _generation{ 0 };
+	uint64_t _refreshes = 0;
+};
+
+#endif // HOTKEYS_H
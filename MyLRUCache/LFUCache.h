@@ -2,9 +2,17 @@
 #ifndef LFUCACHE_H
 #define LFUCACHE_H
 
+#include "CacheResize.h"
+#include "CacheSnapshot.h"
+#include "TagIndex.h"
+#include <algorithm>
 #include <mutex>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
 #include <unordered_map>
+#include <vector>
 
 template<typename Key, typename Value>
 class LFUCache;
@@ -26,11 +34,12 @@ public:
 
 	FreqList() = delete;
 	explicit FreqList(int freqCount) : _freqCount(freqCount) {
-		_head = std::make_shared<LFUNode>(-1, -1);
-		_tail = std::make_shared<LFUNode>(-1, -1);
+		_head = std::make_shared<LFUNode>();
+		_tail = std::make_shared<LFUNode>();
 		_head->_next = _tail;
 		_tail->_prev = _head;
 	}
+	~FreqList() { clear(); }
 
 	bool empty() const {
 		return _head->_next == _tail;
@@ -40,6 +49,18 @@ public:
 		return _tail->_prev;
 	}
 
+	// 逐个断开节点，避免长链表在析构时递归释放
+	void clear() {
+		NodePtr node = _head->_next;
+		while (node && node != _tail) {
+			NodePtr next = node->_next;
+			node->_next = nullptr;
+			node = next;
+		}
+		_head->_next = _tail;
+		_tail->_prev = _head;
+	}
+
 	friend class LFUCache<Key, Value>;
 
 public:
@@ -60,6 +81,8 @@ private:
 	std::mutex _mutex;
 	std::unordered_map<Key, NodePtr> _nodeMap;
 	std::unordered_map<int, FreqListPtr> _freqListMap;
+	// tag 与 key 前缀的二级索引，由 _mutex 保护
+	TagIndex<Key> _tagIndex;
 
 	void insert(Key key, Value value, int freqCount) {
 		NodePtr node = std::make_shared<LFUNode>(key, value, freqCount);
@@ -68,13 +91,16 @@ private:
 			_freqListMap[freqCount] = std::make_unique<FreqList<Key, Value>>(freqCount);
 		}
 		auto head = _freqListMap[freqCount]->_head;
-		head->_next->_prev.lock() = node;
+		head->_next->_prev = node;
 		node->_next = head->_next;
 		head->_next = node;
 		node->_prev = head;
 	}
 
-	void remove(Key key) {
+	/**
+	* 把节点从频数链表与 _nodeMap 中摘下；get/put 提升频数时也用它，不影响标签
+	*/
+	void detach(Key key) {
 		auto it = _nodeMap.find(key);
 		if (it != _nodeMap.end()) {
 			NodePtr node = it->second;
@@ -85,9 +111,98 @@ private:
 			_nodeMap.erase(it);
 		}
 	}
+
+	/**
+	* 淘汰最小频数链表中最久未访问的节点；最小频数链表已空时重新计算最小频数
+	*/
+	void evictLeastFrequent() {
+		if (_nodeMap.empty()) return;
+		auto list = _freqListMap.find(_minFreqCount);
+		if (list == _freqListMap.end() || list->second->empty()) {
+			_minFreqCount = 0;
+			for (auto& pair : _freqListMap) {
+				if (!pair.second->empty() && (_minFreqCount == 0 || pair.first < _minFreqCount)) {
+					_minFreqCount = pair.first;
+				}
+			}
+			list = _freqListMap.find(_minFreqCount);
+		}
+		auto node = list->second->getUnfrequentNode().lock();
+		detach(node->_key);
+		_tagIndex.erase(node->_key);
+	}
+
+	// 反复用 take(batch) 从索引中取出一批 key 并在同一次加锁内删除，直到取完
+	template<typename Take>
+	size_t invalidateBatches(Take take) {
+		size_t removed = 0;
+		CacheResize::runInBatches([&](size_t batch) {
+			std::lock_guard<std::mutex> lock(_mutex);
+			std::vector<Key> keys = take(batch);
+			for (const Key& key : keys) {
+				detach(key);
+			}
+			removed += keys.size();
+			return keys.size() == batch;
+		});
+		return removed;
+	}
+	/**
+	* put 的主体，调用者持锁；返回写入后 key 是否在缓存中
+	*/
+	bool putEntry(const Key& key, const Value& value) {
+		auto it = _nodeMap.find(key);
+		if (it != _nodeMap.end()) {
+			// found
+			NodePtr node = it->second;
+			node->_value = value;
+			int freqCount = node->_freqCount;
+			detach(key);
+			++freqCount;
+			insert(key, value, freqCount);
+		}
+		else {
+			// not found
+			if (_capacity <= 0) return false;
+			if (_nodeMap.size() >= _capacity) {
+				// cache is full, remove the unfrequently node
+				evictLeastFrequent();
+			}
+			// insert new node
+			insert(key, value, 1);
+			_tagIndex.track(key);
+			_minFreqCount = 1;
+		}
+		return true;
+	}
 public:
 	LFUCache(int capacity) : _capacity(capacity), _minFreqCount(0) {}
 
+	/**
+	* 运行时调整容量；缩容时分批淘汰低频条目，批次之间释放锁
+	*/
+	void setCapacity(int capacity) {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_capacity = capacity > 0 ? capacity : 0;
+		}
+		CacheResize::runInBatches([this](size_t batch) {
+			std::lock_guard<std::mutex> lock(_mutex);
+			for (size_t i = 0; i < batch && _nodeMap.size() > static_cast<size_t>(_capacity); ++i) {
+				evictLeastFrequent();
+			}
+			return _nodeMap.size() > static_cast<size_t>(_capacity);
+		});
+	}
+	int getCapacity() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _capacity;
+	}
+	size_t size() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _nodeMap.size();
+	}
+
 	Value get(Key key) {
 		std::lock_guard<std::mutex> lock(_mutex);
 		auto it = _nodeMap.find(key);
@@ -97,8 +212,8 @@ public:
 		NodePtr node = it->second;
 		int freqCount = node->_freqCount;
 		// Remove node from current frequency list
-		remove(key);
-		if (_freqListMap[freqCount]->empty()) {
+		detach(key);
+		if (freqCount == _minFreqCount && _freqListMap[freqCount]->empty()) {
 			++_minFreqCount;
 		}
 		++freqCount;
@@ -116,27 +231,125 @@ public:
 
 	void put(Key key, Value value) {
 		std::lock_guard<std::mutex> lock(_mutex);
-		auto it = _nodeMap.find(key);
-		if (it != _nodeMap.end()) {
-			// found
-			NodePtr node = it->second;
-			node->_value = value;
-			int freqCount = node->_freqCount;
-			remove(key);
-			++freqCount;
-			insert(key, value, freqCount);
+		putEntry(key, value);
+	}
+	/**
+	* 写入并用 tags 替换 key 原有的标签；不带 tags 的 put 保留原有标签
+	*/
+	void put(Key key, Value value, const std::vector<std::string>& tags) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (putEntry(key, value)) {
+			_tagIndex.setTags(key, tags);
 		}
-		else {
-			// not found
-			if (_nodeMap.size() >= _capacity) {
-				// cache is full, remove the unfrequently node
-				auto node = _freqListMap[_minFreqCount]->getUnfrequentNode().lock();
-				remove(node->_key);
+	}
+
+	/**
+	* 删除 key 对应的条目，返回是否存在
+	*/
+	bool remove(Key key) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_nodeMap.find(key) == _nodeMap.end()) return false;
+		detach(key);
+		_tagIndex.erase(key);
+		return true;
+	}
+
+	/**
+	* 删除所有带 tag 的条目，返回删除数量；每批最多 kEvictBatch 个，批次之间释放锁
+	*/
+	size_t invalidateTag(const std::string& tag) {
+		return invalidateBatches([this, &tag](size_t batch) { return _tagIndex.takeTag(tag, batch); });
+	}
+	/**
+	* 删除所有 key 以 prefix 开头的条目（仅 std::string key）；首次调用时在锁内建立前缀索引
+	*/
+	size_t invalidatePrefix(std::string_view prefix) {
+		enablePrefixIndex();
+		return invalidateBatches([this, prefix](size_t batch) { return _tagIndex.takePrefix(prefix, batch); });
+	}
+	void enablePrefixIndex() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_tagIndex.prefixEnabled()) return;
+		std::vector<Key> keys;
+		keys.reserve(_nodeMap.size());
+		for (auto& pair : _nodeMap) keys.push_back(pair.first);
+		_tagIndex.enablePrefix(keys);
+	}
+
+	/**
+	* 导出 <key, value, freq>：按频数从高到低，同一频数内从最久未访问到最近访问
+	*/
+	std::vector<std::tuple<Key, Value, int>> exportEntries() {
+		std::vector<std::tuple<Key, Value, int>> entries;
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::vector<int> freqs;
+		for (auto& pair : _freqListMap) {
+			freqs.push_back(pair.first);
+		}
+		std::sort(freqs.begin(), freqs.end(), std::greater<int>());
+		entries.reserve(_nodeMap.size());
+		for (int freq : freqs) {
+			auto& list = _freqListMap[freq];
+			for (NodePtr node = list->_tail->_prev.lock(); node != list->_head; node = node->_prev.lock()) {
+				entries.emplace_back(node->_key, node->_value, node->_freqCount);
 			}
-			// insert new node
-			insert(key, value, 1);
-			_minFreqCount = 1;
 		}
+		return entries;
+	}
+
+	/**
+	* 清空后导入，超出容量时丢弃频数最低的部分
+	*/
+	void importEntries(const std::vector<std::tuple<Key, Value, int>>& entries) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_nodeMap.clear();
+		_freqListMap.clear();
+		_tagIndex.clear();
+		_minFreqCount = 0;
+		size_t capacity = _capacity > 0 ? static_cast<size_t>(_capacity) : 0;
+		size_t count = std::min(entries.size(), capacity);
+		_nodeMap.reserve(count);
+		for (size_t i = 0; i < count; ++i) {
+			const auto& [key, value, freq] = entries[i];
+			if (_nodeMap.find(key) != _nodeMap.end()) continue;
+			int freqCount = freq < 1 ? 1 : freq;
+			insert(key, value, freqCount);
+			_tagIndex.track(key);
+			if (_minFreqCount == 0 || freqCount < _minFreqCount) {
+				_minFreqCount = freqCount;
+			}
+		}
+	}
+
+	bool saveSnapshot(const std::string& path) {
+		auto entries = exportEntries();
+		SnapshotWriter writer(path, SnapshotKind::LFU);
+		writer.beginSection(SnapshotSection::Entries, entries.size());
+		for (const auto& [key, value, freq] : entries) {
+			writer.write(key);
+			writer.write(value);
+			writer.writeRecord(static_cast<int32_t>(freq));
+		}
+		return writer.finish();
+	}
+
+	bool loadSnapshot(const std::string& path) {
+		SnapshotReader reader;
+		if (!reader.open(path, SnapshotKind::LFU)) return false;
+		uint64_t count = 0;
+		if (!reader.beginSection(SnapshotSection::Entries, count) || count > reader.remaining()) return false;
+		std::vector<std::tuple<Key, Value, int>> entries;
+		entries.reserve(static_cast<size_t>(count));
+		for (uint64_t i = 0; i < count; ++i) {
+			Key key{};
+			Value value{};
+			int32_t freq = 0;
+			if (!reader.read(key) || !reader.read(value) || !reader.read(freq)) return false;
+			entries.emplace_back(std::move(key), std::move(value), freq);
+		}
+		if (!reader.atEnd()) return false;
+		importEntries(entries);
+		return true;
 	}
 };
 
@@ -178,6 +391,11 @@ public:
 	Value get(Key key);
 	bool get(Key key, Value& value);
 	void put(Key key, Value value);
+
+	/**
+	* 运行时调整容量；缩容时分批淘汰低频条目，批次之间释放锁
+	*/
+	void setCapacity(int capacity);
 };
 
 template<typename Key, typename Value>
@@ -216,9 +434,9 @@ bool AlignLFUCache<Key, Value>::get(Key key, Value& value)
 template<typename Key, typename Value>
 void AlignLFUCache<Key, Value>::put(Key key, Value value)
 {
-	if (_capacity == 0) return;
 	// 0. 加锁，线程安全
 	std::lock_guard<std::mutex> lock(_mutex);
+	if (_capacity == 0) return;
 	// 1. 判断key是否存在
 	auto it = _nodeMap.find(key);
 	// 2. 如果存在，更新节点的值
@@ -248,6 +466,24 @@ void AlignLFUCache<Key, Value>::put(Key key, Value value)
 }
 
 
+template<typename Key, typename Value>
+void AlignLFUCache<Key, Value>::setCapacity(int capacity)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_capacity = capacity > 0 ? capacity : 0;
+	}
+	CacheResize::runInBatches([this](size_t batch) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (size_t i = 0; i < batch && _nodeMap.size() > static_cast<size_t>(_capacity); ++i) {
+			// kickOut 不维护最小频数，连续淘汰时先重新计算
+			updateMinFreq();
+			kickOut();
+		}
+		return _nodeMap.size() > static_cast<size_t>(_capacity);
+	});
+}
+
 template<typename Key, typename Value>
 void AlignLFUCache<Key, Value>::insert(NodePtr node)
 {
@@ -2,12 +2,27 @@
 #ifndef LRUCACHE_H
 #define LRUCACHE_H
 
+#include "BackgroundEvictor.h"
+#include "CacheProfiler.h"
+#include "CacheResize.h"
+#include "CacheSnapshot.h"
+#include "Doorkeeper.h"
+#include "FlatHashMap.h"
+#include "HotKeys.h"
+#include "PinnedHandle.h"
+#include "TagIndex.h"
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 #include <mutex>
+#include <shared_mutex>
+#include <vector>
 
-// 前向声明
-template<typename Key, typename Value>
+// 前向声明；MapT 为分片索引的哈希表模板，默认 std::unordered_map，也可以用 FlatHashMap
+template<typename Key, typename Value, template<typename...> class MapT = std::unordered_map>
 class LRUCache;
 
 /****************************************
@@ -22,6 +37,8 @@ protected:
 	Value _value;
 	std::weak_ptr<LRUNode> _prev;
 	std::shared_ptr<LRUNode> _next;
+	// 被 handle pin 住时不参与容量淘汰
+	PinState _pin;
 public:
 	LRUNode() = delete;
 	LRUNode(Key key, Value value) : _key(key), _value(value) {}
@@ -30,7 +47,8 @@ public:
 	inline Value getValue() { return _value; }
 	inline void setValue(Value value) { _value = value; }
 
-	friend class LRUCache<Key, Value>;
+	template<typename, typename, template<typename...> class>
+	friend class LRUCache;
 };
 
 /****************************************
@@ -39,11 +57,11 @@ LRUCache
 基于LRU算法的缓存算法
 ****************************************/
 
-template<typename Key, typename Value>
+template<typename Key, typename Value, template<typename...> class MapT>
 class LRUCache{
 protected:
 	using NodePtr = std::shared_ptr<LRUNode<Key, Value>>;
-	using NodeMap = std::unordered_map<int, NodePtr>;
+	using NodeMap = MapT<Key, NodePtr>;
 	// mutex 互斥量 TODO
 	std::mutex _mutex;
 	// Cache 容量
@@ -51,77 +69,241 @@ protected:
 	// linked list 哨兵节点，linked list按照最近访问记录节点，head指向最久未使用的节点，tail指向最近使用的节点
 	std::shared_ptr<LRUNode<Key, Value>> _head = nullptr;
 	std::shared_ptr<LRUNode<Key, Value>> _tail = nullptr;
-	// hashmap，hashmap的 <int,Node *> 结构是为了方便与双向链表进行交互
+	// hashmap，hashmap的 <Key,Node *> 结构是为了方便与双向链表进行交互
 	NodeMap _map;
+	// 可选的锁耗时统计，为空时不做任何计时
+	std::shared_ptr<CacheProfiler> _profiler;
+	LockCounters _lockCounters;
+	// 容量淘汰回调，默认在释放锁之后调用
+	std::function<void(const Key&, const Value&)> _onEvict;
+	bool _evictUnderLock = false;
+	// 后台淘汰保持的空余槽位数，为 0 时不保留
+	size_t _headroom = 0;
+	EvictionStats _evictionStats;
+	// 可选的写入门卫，为空时所有 put 都写入
+	std::shared_ptr<Doorkeeper> _doorkeeper;
+	// tag 与 key 前缀的二级索引，与链表一起由 _mutex 保护
+	TagIndex<Key> _tagIndex;
+	// pin 的字节预算与条目大小的计算方式，为空时按 sizeof(Value) 计
+	std::shared_ptr<PinBudget> _pinBudget = std::make_shared<PinBudget>();
+	std::function<size_t(const Value&)> _pinSizeOf;
 public:
+	using Handle = CacheHandle<Key, Value>;
+
 	LRUCache(int capacity) : _capacity(capacity) {
 		_head = std::make_shared<LRUNode<Key, Value>>(Key(), Value());
 		_tail = std::make_shared<LRUNode<Key, Value>>(Key(), Value());
 		_head->_next = _tail;
 		_tail->_prev = _head;
 	}
-	~LRUCache()=default;
+	~LRUCache() { clear(); }
 
 	Value get(Key key);
 	bool get(Key key, Value& value);
+	/**
+	* 不拷贝值的 get：返回 pin 住条目的 handle，未命中时 handle 为空
+	*/
+	Handle getHandle(Key key);
 	void put(Key key, Value value);
+	/**
+	* 写入并用 tags 替换 key 原有的标签；不带 tags 的 put 保留原有标签
+	*/
+	void put(Key key, Value value, const std::vector<std::string>& tags);
 
 	void remove(NodePtr node);
 	void remove(Key key);
 	void insert(Key key, Value value);
+
+	/**
+	* 运行时调整容量；缩容时分批淘汰最久未使用的条目，批次之间释放锁
+	*/
+	void setCapacity(int capacity);
+	int getCapacity();
+	size_t size();
+	/**
+	* 仅在 key 不存在时写入，返回是否写入；带 tags 时同时设置标签
+	*/
+	bool putIfAbsent(Key key, Value value);
+	bool putIfAbsent(Key key, Value value, const std::vector<std::string>& tags);
+	/**
+	* 取出并删除 key 对应的条目；tags 不为空时同时取出它的标签
+	*/
+	bool take(Key key, Value& value, std::vector<std::string>* tags = nullptr);
+	/**
+	* 最多 count 个最久未使用的 key，按 最久 -> 最近 排列，不改变缓存内容
+	*/
+	std::vector<Key> oldestKeys(size_t count);
+
+	/**
+	* 设置锁耗时统计，需在并发访问开始前调用
+	*/
+	void setProfiler(std::shared_ptr<CacheProfiler> profiler) { _profiler = std::move(profiler); }
+	LockStats getLockStats() const { return _lockCounters.snapshot(); }
+	/**
+	* 设置容量淘汰回调（例如写入下一级缓存），需在并发访问开始前调用。
+	* underLock 为 true 时在淘汰的同一临界区内调用，回调与之后对同一 key 的写入、删除严格有序，
+	* 代价是回调耗时计入锁内；回调中不能再访问本缓存
+	*/
+	void setEvictionCallback(std::function<void(const Key&, const Value&)> onEvict, bool underLock = false) {
+		_onEvict = std::move(onEvict);
+		_evictUnderLock = underLock;
+	}
+
+	/**
+	* 按 最久未使用 -> 最近使用 的顺序导出所有数据，只在拷贝期间持锁
+	*/
+	std::vector<std::pair<Key, Value>> exportEntries();
+	/**
+	* 清空缓存后按顺序导入，超出容量时保留最近使用的部分
+	*/
+	void importEntries(const std::vector<std::pair<Key, Value>>& entries);
+	/**
+	* 保存/加载快照，保留访问顺序；加载会替换当前内容
+	*/
+	bool saveSnapshot(const std::string& path);
+	bool loadSnapshot(const std::string& path);
+	/**
+	* 设置空余槽位数；配合 evictToHeadroom 由后台线程提前淘汰，put 在有空位时不必在锁内淘汰
+	*/
+	void setHeadroom(size_t headroom);
+	/**
+	* 最多淘汰 maxEvictions 个最久未使用的条目，使空余槽位不少于 headroom，返回是否仍然不足
+	*/
+	bool evictToHeadroom(size_t maxEvictions);
+	EvictionStats getEvictionStats();
+	/**
+	* 设置写入门卫：新 key 在门卫的窗口内第二次 put 时才写入，可以在多个缓存之间共享；传空关闭。
+	* 只影响 put，putIfAbsent 与快照导入不经过门卫
+	*/
+	void setDoorkeeper(std::shared_ptr<Doorkeeper> doorkeeper);
+	/**
+	* 开启门卫，windowSize 为 0 时取容量的 4 倍
+	*/
+	void enableDoorkeeper(size_t windowSize = 0, double falsePositiveRate = 0.01);
+	Doorkeeper::Stats getDoorkeeperStats();
+	/**
+	* 删除所有带 tag 的条目，返回删除数量。每批最多 kEvictBatch 个、批次之间释放锁，
+	* 耗时与删除数量成正比；onRemoved 在锁外对每个被删除的 key 调用。失效不触发淘汰回调
+	*/
+	size_t invalidateTag(const std::string& tag, const std::function<void(const Key&)>& onRemoved = nullptr);
+	/**
+	* 删除所有 key 以 prefix 开头的条目（仅 std::string key），分批方式同 invalidateTag。
+	* 首次调用时在锁内建立前缀索引，之后每次写入新 key 多一次有序插入；也可以提前调用 enablePrefixIndex
+	*/
+	size_t invalidatePrefix(std::string_view prefix, const std::function<void(const Key&)>& onRemoved = nullptr);
+	void enablePrefixIndex();
+	/**
+	* 限制被 pin 条目的总字节数，sizeOf 为空时每个条目按 sizeof(Value) 计；需在并发访问开始前调用
+	*/
+	void setPinLimit(size_t maxBytes, std::function<size_t(const Value&)> sizeOf = nullptr);
+	/**
+	* 与其他缓存共享 pin 预算（例如 HashLRUCache 的各个分片）
+	*/
+	void setPinBudget(std::shared_ptr<PinBudget> budget, std::function<size_t(const Value&)> sizeOf);
+	PinBudget::Stats getPinStats();
+protected:
+	// 逐个断开链表节点，避免 shared_ptr 链在析构时递归过深
+	void clear();
+	// 淘汰最多 maxEvictions 个超出容量的条目，返回是否仍超出容量
+	bool trimToCapacity(size_t maxEvictions);
+	// 淘汰最多 maxEvictions 个条目直到条目数不超过 容量 - reserve，返回是否仍然超出
+	bool evictDownTo(size_t reserve, size_t maxEvictions, bool background);
+	void putEntry(Key key, Value value, const std::vector<std::string>* tags);
+	// 反复用 take(batch) 从索引中取出一批 key 并在同一次加锁内删除，直到取完
+	template<typename Take>
+	size_t invalidateBatches(Take take, const std::function<void(const Key&)>& onRemoved);
+	// 把节点移到最近使用的一端，不重建节点
+	void moveToTail(NodePtr node);
+	// 从最久未使用的一端取第一个没有被 pin 的节点，途经的被 pin 节点移到最近使用的一端；全部被 pin 时返回空
+	NodePtr evictionCandidate();
+	// 为插入新条目腾出一个位置；全部被 pin 时不淘汰，暂时超出容量，之后的写入再逐步淘汰回来
+	void evictForInsert(std::vector<NodePtr>& evicted);
 };
 
 
-template<typename Key, typename Value>
-Value LRUCache<Key, Value>::get(Key key)
+template<typename Key, typename Value, template<typename...> class MapT>
+Value LRUCache<Key, Value, MapT>::get(Key key)
 {
-	std::lock_guard<std::mutex> lock(_mutex);
-	if (_map.find(key) != _map.end()) {
-		NodePtr node = _map[key];
-		// 下面完成的是删除双向链表及 hash 中原有的点，并将该节点加入最近使用的表尾 R 的前驱操作
-		remove(node);
-		insert(node->_key, node->_value);
-		return node->_value;
-	}
-	else return Value{};
+	Value value{};
+	get(key, value);
+	return value;
 }
 
-template<typename Key, typename Value>
-bool LRUCache<Key, Value>::get(Key key, Value& value) {
-	value = get(key);
-	if (value == -1) {
+template<typename Key, typename Value, template<typename...> class MapT>
+bool LRUCache<Key, Value, MapT>::get(Key key, Value& value) {
+	ProfiledLockGuard lock(_mutex, _profiler.get(), _lockCounters);
+	auto it = _map.find(key);
+	if (it == _map.end()) {
 		return false;
 	}
+	NodePtr node = it->second;
+	// 节点移到最近使用的表尾 R 的前驱；节点中的值创建后不再修改，被 handle 引用的节点可以直接移动
+	moveToTail(node);
+	value = node->_value;
 	return true;
 }
 
-template<typename Key, typename Value>
-void LRUCache<Key, Value>::put(Key key, Value value)
-{
-	std::lock_guard<std::mutex> lock(_mutex);
-	if (_map.find(key) != _map.end()) {
-		// key exists, update value
-		NodePtr node = _map[key];
-		// 下面完成的是删除双向链表及 hash 中原有的点，并将该节点更新 value 值后加入最近使用的表尾 R 的前驱操作
-		remove(node);
-		insert(node->_key, node->_value);
+template<typename Key, typename Value, template<typename...> class MapT>
+typename LRUCache<Key, Value, MapT>::Handle LRUCache<Key, Value, MapT>::getHandle(Key key) {
+	ProfiledLockGuard lock(_mutex, _profiler.get(), _lockCounters);
+	auto it = _map.find(key);
+	if (it == _map.end()) {
+		return Handle();
 	}
-	else {
-		// key does not exist, create new node
-		if (_map.size() > _capacity) {
-			// remove least recently used node
-			NodePtr node = _head->_next;
+	NodePtr node = it->second;
+	moveToTail(node);
+	bool pinned = _pinBudget->pin(node->_pin, [this, &node]() { return _pinSizeOf ? _pinSizeOf(node->_value) : sizeof(Value); });
+	return Handle(node, node->_key, node->_value, pinned ? &node->_pin : nullptr, _pinBudget);
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::put(Key key, Value value)
+{
+	putEntry(std::move(key), std::move(value), nullptr);
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::put(Key key, Value value, const std::vector<std::string>& tags)
+{
+	putEntry(std::move(key), std::move(value), &tags);
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::putEntry(Key key, Value value, const std::vector<std::string>* tags)
+{
+	std::vector<NodePtr> evicted;
+	{
+		ProfiledLockGuard lock(_mutex, _profiler.get(), _lockCounters);
+		// 容量可能被 setCapacity 修改，需要在锁内读取
+		if (_capacity <= 0) return;
+		if (_map.find(key) != _map.end()) {
+			// key exists, update value
+			NodePtr node = _map[key];
+			// 下面完成的是删除双向链表及 hash 中原有的点，再以新值建立节点加入最近使用的表尾 R 的前驱；
+			// 旧节点若被 handle 引用则由 handle 保留，不在原地修改值
 			remove(node);
-			insert(key, value);
+			insert(node->_key, value);
 		}
 		else {
+			// 门卫：窗口内第一次出现的 key 只记录，不分配节点也不淘汰
+			if (_doorkeeper && !_doorkeeper->admit(key)) return;
+			// key does not exist, evict least recently used unpinned node if full, then create new node
+			evictForInsert(evicted);
 			insert(key, value);
+			_tagIndex.track(key);
+		}
+		if (tags) _tagIndex.setTags(key, *tags);
+	}
+	// 淘汰回调放在锁外，避免下一级缓存的 IO 拉长临界区
+	if (_onEvict) {
+		for (auto& node : evicted) {
+			_onEvict(node->_key, node->_value);
 		}
 	}
 }
 
-template<typename Key, typename Value>
-void LRUCache<Key, Value>::remove(NodePtr node)
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::remove(NodePtr node)
 {
 	auto prev = node->_prev.lock(); // 不能直接使用weak_ptr，要用lock()先转换为shared_ptr
 	prev->_next = node->_next;
@@ -130,15 +312,19 @@ void LRUCache<Key, Value>::remove(NodePtr node)
 	_map.erase(node->_key);
 }
 
-template<typename Key, typename Value>
-void LRUCache<Key, Value>::remove(Key key)
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::remove(Key key)
 {
-	auto node = _map[key];
-	remove(node);
+	ProfiledLockGuard lock(_mutex, _profiler.get(), _lockCounters);
+	auto it = _map.find(key);
+	if (it != _map.end()) {
+		remove(it->second);
+		_tagIndex.erase(key);
+	}
 }
 
-template<typename Key, typename Value>
-void LRUCache<Key, Value>::insert(Key key, Value value)
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::insert(Key key, Value value)
 {
 	NodePtr node = std::make_shared<LRUNode<Key, Value>>(key, value);
 
@@ -150,6 +336,351 @@ void LRUCache<Key, Value>::insert(Key key, Value value)
 	_map[key] = node;
 }
 
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::moveToTail(NodePtr node)
+{
+	auto prev = node->_prev.lock();
+	prev->_next = node->_next;
+	node->_next->_prev = prev;
+	node->_next = _tail;
+	node->_prev = _tail->_prev;
+	_tail->_prev.lock()->_next = node;
+	_tail->_prev = node;
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+typename LRUCache<Key, Value, MapT>::NodePtr LRUCache<Key, Value, MapT>::evictionCandidate()
+{
+	for (size_t i = 0, count = _map.size(); i < count; ++i) {
+		NodePtr node = _head->_next;
+		if (!node->_pin.pinned()) return node;
+		// 被 pin 的条目正在使用，视为最近访问
+		moveToTail(node);
+	}
+	return nullptr;
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::evictForInsert(std::vector<NodePtr>& evicted)
+{
+	while (_map.size() >= static_cast<size_t>(_capacity)) {
+		NodePtr node = evictionCandidate();
+		if (!node) break;
+		remove(node);
+		_tagIndex.erase(node->_key);
+		++_evictionStats.inlineEvictions;
+		if (_evictUnderLock) {
+			if (_onEvict) _onEvict(node->_key, node->_value);
+		}
+		else {
+			evicted.push_back(std::move(node));
+		}
+	}
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::clear()
+{
+	NodePtr node = _head->_next;
+	while (node && node != _tail) {
+		NodePtr next = node->_next;
+		node->_next = nullptr;
+		node = next;
+	}
+	_head->_next = _tail;
+	_tail->_prev = _head;
+	_map.clear();
+	_tagIndex.clear();
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::setCapacity(int capacity)
+{
+	{
+		ProfiledLockGuard lock(_mutex, _profiler.get(), _lockCounters);
+		_capacity = capacity > 0 ? capacity : 0;
+	}
+	CacheResize::runInBatches([this](size_t batch) { return trimToCapacity(batch); });
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+int LRUCache<Key, Value, MapT>::getCapacity()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _capacity;
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+size_t LRUCache<Key, Value, MapT>::size()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _map.size();
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+bool LRUCache<Key, Value, MapT>::trimToCapacity(size_t maxEvictions)
+{
+	return evictDownTo(0, maxEvictions, false);
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::setHeadroom(size_t headroom)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_headroom = headroom;
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+bool LRUCache<Key, Value, MapT>::evictToHeadroom(size_t maxEvictions)
+{
+	size_t headroom;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		headroom = _headroom;
+	}
+	return evictDownTo(headroom, maxEvictions, true);
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+EvictionStats LRUCache<Key, Value, MapT>::getEvictionStats()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _evictionStats;
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::setDoorkeeper(std::shared_ptr<Doorkeeper> doorkeeper)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_doorkeeper = std::move(doorkeeper);
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::enableDoorkeeper(size_t windowSize, double falsePositiveRate)
+{
+	if (windowSize == 0) windowSize = static_cast<size_t>(getCapacity() > 0 ? getCapacity() : 1) * 4;
+	setDoorkeeper(std::make_shared<Doorkeeper>(windowSize, falsePositiveRate));
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+Doorkeeper::Stats LRUCache<Key, Value, MapT>::getDoorkeeperStats()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _doorkeeper ? _doorkeeper->getStats() : Doorkeeper::Stats();
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::setPinLimit(size_t maxBytes, std::function<size_t(const Value&)> sizeOf)
+{
+	setPinBudget(std::make_shared<PinBudget>(maxBytes), std::move(sizeOf));
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::setPinBudget(std::shared_ptr<PinBudget> budget, std::function<size_t(const Value&)> sizeOf)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	// 已发出的 handle 仍向原来的预算归还
+	_pinBudget = budget ? std::move(budget) : std::make_shared<PinBudget>();
+	_pinSizeOf = std::move(sizeOf);
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+PinBudget::Stats LRUCache<Key, Value, MapT>::getPinStats()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _pinBudget->getStats();
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+size_t LRUCache<Key, Value, MapT>::invalidateTag(const std::string& tag, const std::function<void(const Key&)>& onRemoved)
+{
+	return invalidateBatches([this, &tag](size_t batch) { return _tagIndex.takeTag(tag, batch); }, onRemoved);
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+size_t LRUCache<Key, Value, MapT>::invalidatePrefix(std::string_view prefix, const std::function<void(const Key&)>& onRemoved)
+{
+	enablePrefixIndex();
+	return invalidateBatches([this, prefix](size_t batch) { return _tagIndex.takePrefix(prefix, batch); }, onRemoved);
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::enablePrefixIndex()
+{
+	ProfiledLockGuard lock(_mutex, _profiler.get(), _lockCounters);
+	if (_tagIndex.prefixEnabled()) return;
+	std::vector<Key> keys;
+	keys.reserve(_map.size());
+	for (NodePtr node = _head->_next; node != _tail; node = node->_next) {
+		keys.push_back(node->_key);
+	}
+	_tagIndex.enablePrefix(keys);
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+template<typename Take>
+size_t LRUCache<Key, Value, MapT>::invalidateBatches(Take take, const std::function<void(const Key&)>& onRemoved)
+{
+	size_t removed = 0;
+	CacheResize::runInBatches([&](size_t batch) {
+		std::vector<Key> keys;
+		{
+			ProfiledLockGuard lock(_mutex, _profiler.get(), _lockCounters);
+			// 索引与缓存在同一把锁下维护，取出的 key 一定还在缓存中
+			keys = take(batch);
+			for (const Key& key : keys) {
+				auto it = _map.find(key);
+				if (it != _map.end()) remove(it->second);
+			}
+		}
+		removed += keys.size();
+		if (onRemoved) {
+			for (const Key& key : keys) onRemoved(key);
+		}
+		return keys.size() == batch;
+	});
+	return removed;
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+bool LRUCache<Key, Value, MapT>::evictDownTo(size_t reserve, size_t maxEvictions, bool background)
+{
+	std::vector<NodePtr> evicted;
+	bool remaining;
+	{
+		ProfiledLockGuard lock(_mutex, _profiler.get(), _lockCounters);
+		size_t capacity = _capacity > 0 ? static_cast<size_t>(_capacity) : 0;
+		size_t limit = capacity > reserve ? capacity - reserve : 0;
+		bool blocked = false;
+		size_t count = 0;
+		for (; count < maxEvictions && _map.size() > limit; ++count) {
+			NodePtr node = evictionCandidate();
+			if (!node) {
+				// 剩下的条目都被 pin，等 handle 释放后再淘汰
+				blocked = true;
+				break;
+			}
+			remove(node);
+			_tagIndex.erase(node->_key);
+			if (_evictUnderLock) {
+				if (_onEvict) _onEvict(node->_key, node->_value);
+			}
+			else {
+				evicted.push_back(std::move(node));
+			}
+		}
+		if (background) _evictionStats.backgroundEvictions += count;
+		remaining = !blocked && _map.size() > limit;
+	}
+	if (_onEvict) {
+		for (auto& node : evicted) {
+			_onEvict(node->_key, node->_value);
+		}
+	}
+	return remaining;
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+bool LRUCache<Key, Value, MapT>::putIfAbsent(Key key, Value value)
+{
+	return putIfAbsent(key, value, {});
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+bool LRUCache<Key, Value, MapT>::putIfAbsent(Key key, Value value, const std::vector<std::string>& tags)
+{
+	std::vector<NodePtr> evicted;
+	{
+		ProfiledLockGuard lock(_mutex, _profiler.get(), _lockCounters);
+		if (_capacity <= 0 || _map.find(key) != _map.end()) return false;
+		evictForInsert(evicted);
+		insert(key, value);
+		_tagIndex.track(key);
+		if (!tags.empty()) _tagIndex.setTags(key, tags);
+	}
+	if (_onEvict) {
+		for (auto& node : evicted) {
+			_onEvict(node->_key, node->_value);
+		}
+	}
+	return true;
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+bool LRUCache<Key, Value, MapT>::take(Key key, Value& value, std::vector<std::string>* tags)
+{
+	ProfiledLockGuard lock(_mutex, _profiler.get(), _lockCounters);
+	auto it = _map.find(key);
+	if (it == _map.end()) return false;
+	NodePtr node = it->second;
+	remove(node);
+	if (tags) *tags = _tagIndex.tagsOf(key);
+	_tagIndex.erase(key);
+	value = node->_value;
+	return true;
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+std::vector<Key> LRUCache<Key, Value, MapT>::oldestKeys(size_t count)
+{
+	std::vector<Key> keys;
+	ProfiledLockGuard lock(_mutex, _profiler.get(), _lockCounters);
+	for (NodePtr node = _head->_next; keys.size() < count && node != _tail; node = node->_next) {
+		keys.push_back(node->_key);
+	}
+	return keys;
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+std::vector<std::pair<Key, Value>> LRUCache<Key, Value, MapT>::exportEntries()
+{
+	std::vector<std::pair<Key, Value>> entries;
+	std::lock_guard<std::mutex> lock(_mutex);
+	entries.reserve(_map.size());
+	for (NodePtr node = _head->_next; node != _tail; node = node->_next) {
+		entries.emplace_back(node->_key, node->_value);
+	}
+	return entries;
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+void LRUCache<Key, Value, MapT>::importEntries(const std::vector<std::pair<Key, Value>>& entries)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	clear();
+	size_t capacity = _capacity > 0 ? static_cast<size_t>(_capacity) : 0;
+	size_t begin = entries.size() > capacity ? entries.size() - capacity : 0;
+	_map.reserve(entries.size() - begin);
+	for (size_t i = begin; i < entries.size(); ++i) {
+		auto it = _map.find(entries[i].first);
+		if (it != _map.end()) {
+			remove(it->second);
+		}
+		insert(entries[i].first, entries[i].second);
+		_tagIndex.track(entries[i].first);
+	}
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+bool LRUCache<Key, Value, MapT>::saveSnapshot(const std::string& path)
+{
+	auto entries = exportEntries();
+	SnapshotWriter writer(path, SnapshotKind::LRU);
+	writer.writeEntries(entries);
+	return writer.finish();
+}
+
+template<typename Key, typename Value, template<typename...> class MapT>
+bool LRUCache<Key, Value, MapT>::loadSnapshot(const std::string& path)
+{
+	SnapshotReader reader;
+	if (!reader.open(path, SnapshotKind::LRU)) return false;
+	std::vector<std::pair<Key, Value>> entries;
+	if (!reader.readEntries(entries) || !reader.atEnd()) return false;
+	importEntries(entries);
+	return true;
+}
+
 /****************************************
 LRUKCache
 
@@ -235,31 +766,533 @@ void LRUKCache<Key, Value>::put(Key key, Value value)
 }
 
 
-template<typename Key, typename Value>
+/****************************************
+HashLRUCache
+
+按 key 哈希分片的 LRUCache，分片索引默认使用 FlatHashMap。
+分片表发布后不再修改，读写路径只读一次表指针，不经过全局锁；分片数调整等操作整体换上新表。
+容量与分片数都可以在运行时调整：修改分片数时先换上新的分片表，旧表进入迁移状态，
+查找先查新表、未命中再到旧表中取出并搬到新表，同时按批把旧表剩余条目迁移完，再换上不含旧表的分片表。
+迁移期间新表中的条目与从旧表搬来的条目之间的访问顺序是近似的，从旧表搬来的条目连同标签一起搬动。
+可选开启热点 key 检测（enableHotKeys），少数 key 集中落在同一分片时，对它们的读由无锁的副本返回。
+****************************************/
+template<typename Key, typename Value, template<typename...> class MapT = FlatHashMap>
 class HashLRUCache {
 private:
-	int _capacity;
-	int _sliceNum;
-	std::vector<std::unique_ptr<LRUCache<Key, Value>>> _slices;
+	using Slice = LRUCache<Key, Value, MapT>;
+	using SliceTable = std::vector<std::shared_ptr<Slice>>;
+	using HotEntry = typename HotKeyReplica<Key, Value>::Entry;
+
+	/**
+	* 发布后不再修改的分片表。分片数调整、迁移完成、开关热点检测时整体换上新表，
+	* get/put/remove 只对 _table 做一次 acquire 读，不进入任何全局锁
+	*/
+	struct Table {
+		SliceTable slices;
+		// 分片数调整期间的旧分片，为空表示没有迁移
+		SliceTable retiring;
+		// 热点 key 检测与读复制，为空时不采样
+		std::shared_ptr<HotKeyReplica<Key, Value>> hot;
+	};
+
+	std::atomic<int> _capacity;
+	std::atomic<const Table*> _table{ nullptr };
+	// 发布过的所有表。读写路径不持锁地使用表，旧表保留到析构；迁移完成后其中的旧分片都已为空
+	std::vector<std::unique_ptr<const Table>> _tables;
+	// 发布新表时独占；批量失效持共享锁，期间分片表不变。也保护下面的分片配置
+	std::shared_mutex _tableMutex;
+	// 串行化 setCapacity/setSliceNum/快照 这类全表操作
+	std::mutex _resizeMutex;
+	// 按 key 哈希分条的锁：put/remove 与迁移中“从旧表取出、放入新表”的两步对同一个 key 串行，
+	// 写入者在锁内读取分片表，换表后依次获取一遍所有 key 锁，之后不再有写入落到旧表上。
+	// 加锁顺序为 _tableMutex -> key 锁 -> 分片锁
+	static constexpr size_t kKeyLocks = 64;
+	std::mutex _keyLocks[kKeyLocks];
+	std::shared_ptr<CacheProfiler> _profiler;
+	// 按 key 哈希分条的版本号，put/remove 后递增，供 FrontCache 等上层副本判断是否过期
+	static constexpr size_t kVersionStripes = 256;
+	struct alignas(64) VersionStripe {
+		std::atomic<uint64_t> value{ 0 };
+	};
+	std::unique_ptr<VersionStripe[]> _versions = std::make_unique<VersionStripe[]>(kVersionStripes);
+	// 每个分片保持的空余槽位数，以及维护它的后台线程；_evictor 最后声明，析构时最先停止
+	size_t _headroom = 0;
+	// 所有分片共享的写入门卫
+	std::shared_ptr<Doorkeeper> _doorkeeper;
+	// 是否为 key 前缀失效维护有序索引，新建的分片跟随该设置
+	bool _prefixIndex = false;
+	// 所有分片共享的 pin 预算
+	std::shared_ptr<PinBudget> _pinBudget = std::make_shared<PinBudget>();
+	std::function<size_t(const Value&)> _pinSizeOf;
+	std::unique_ptr<BackgroundEvictor> _evictor;
+
+	const Table& current() const {
+		return *_table.load(std::memory_order_acquire);
+	}
+	/**
+	* 换上新表；调用者持有 _resizeMutex。返回后新开始的 get/put/remove 都使用新表，
+	* 已经拿到旧表的写入要等 drainKeyLocks 之后才确定结束
+	*/
+	void publish(std::unique_ptr<const Table> table) {
+		std::unique_lock<std::shared_mutex> lock(_tableMutex);
+		_table.store(table.get(), std::memory_order_seq_cst);
+		_tables.push_back(std::move(table));
+	}
+
+	VersionStripe& stripeFor(const Key& key) const {
+		return stripeAt(std::hash<Key>()(key));
+	}
+	VersionStripe& stripeAt(size_t hash) const {
+		uint64_t h = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+		return _versions[h >> 56];
+	}
+	void bumpVersion(const Key& key) {
+		size_t hash = std::hash<Key>()(key);
+		stripeAt(hash).value.fetch_add(1);
+		// 热点 key 被改写后只使副本失效，由下一个窗口重新发布。写入分片之后重新读一次表：
+		// 若读到的还是旧副本，新副本的发布在这之后，它从分片读到的已是新值
+		const Table& table = *_table.load(std::memory_order_seq_cst);
+		if (table.hot) table.hot->invalidate(key);
+	}
+
+	static size_t sliceIndex(const Key& key, size_t sliceNum) {
+		return std::hash<Key>()(key) % sliceNum;
+	}
+	static Slice& sliceFor(const SliceTable& slices, const Key& key) {
+		return *slices[sliceIndex(key, slices.size())];
+	}
+
+	SliceTable makeSlices(int capacity, int sliceNum) {
+		SliceTable slices;
+		for (int i = 0; i < sliceNum; ++i) {
+			slices.push_back(std::make_shared<Slice>(capacity / sliceNum));
+			if (_profiler) slices.back()->setProfiler(_profiler);
+			if (_headroom) slices.back()->setHeadroom(_headroom);
+			if (_doorkeeper) slices.back()->setDoorkeeper(_doorkeeper);
+			if (_prefixIndex) slices.back()->enablePrefixIndex();
+			slices.back()->setPinBudget(_pinBudget, _pinSizeOf);
+		}
+		return slices;
+	}
+
+	/**
+	* 把旧分片表中剩余的条目分批搬到新表，完成后换上不含旧分片的表；调用者持有 _resizeMutex
+	*/
+	void finishMigration() {
+		const Table& table = current();
+		for (auto& old : table.retiring) {
+			CacheResize::runInBatches([this, &old](size_t batch) {
+				auto keys = old->oldestKeys(batch);
+				for (const Key& key : keys) {
+					Value value{};
+					migrateKey(*old, key, value);
+				}
+				return keys.size() == batch;
+			});
+		}
+		publish(std::make_unique<const Table>(Table{ table.slices, {}, table.hot }));
+	}
+
+	/**
+	* 在分片中查找，迁移中会到旧表里取
+	*/
+	bool getFromSlices(const Table& table, const Key& key, Value& value) {
+		if (sliceFor(table.slices, key).get(key, value)) return true;
+		if (table.retiring.empty()) return false;
+		// 迁移中：从旧表取出并搬到新表
+		return migrateKey(sliceFor(table.retiring, key), key, value);
+	}
+	/**
+	* 在 key 锁内把 key 从旧分片取出并放入当前表，返回是否搬过来。
+	* 取出与放入之间 key 不在任何一张表里，put/remove/失效都要持同一把 key 锁，否则被删除的旧值会被放回
+	*/
+	bool migrateKey(Slice& old, const Key& key, Value& value) {
+		std::lock_guard<std::mutex> guard(keyLock(key));
+		std::vector<std::string> tags;
+		if (!old.take(key, value, &tags)) return false;
+		// 旧表中有值时新表中不会有：put 写新表的同时删除旧表中的 key
+		sliceFor(current().slices, key).putIfAbsent(key, value, tags);
+		return true;
+	}
+	std::mutex& keyLock(const Key& key) {
+		return _keyLocks[std::hash<Key>()(key) % kKeyLocks];
+	}
+	/**
+	* 依次获取并释放所有 key 锁：返回时，在此之前开始的单 key 写入与迁移都已完成
+	*/
+	void drainKeyLocks() {
+		for (auto& mutex : _keyLocks) {
+			mutex.lock();
+			mutex.unlock();
+		}
+	}
+
+	/**
+	* 先查热点副本，版本号与发布时一致才直接返回，否则进入分片
+	*/
+	bool getWithHotKeys(const Table& table, const Key& key, Value& value) {
+		size_t hash = std::hash<Key>()(key);
+		const auto* entry = table.hot->find(key, hash);
+		bool served = entry != nullptr;
+		if (served) value = entry->value;
+		if (table.hot->sample(key, hash % table.slices.size(), served)) refreshHotKeys(table);
+		return served || getFromSlices(table, key, value);
+	}
+
+	/**
+	* 读出候选热点的当前值并发布新的副本表；同时只有一个线程刷新，其余直接返回
+	*/
+	void refreshHotKeys(const Table& table) {
+		auto& hot = *table.hot;
+		auto refresh = hot.tryBeginRefresh();
+		if (!refresh.owns_lock()) return;
+		std::vector<Key> keys = hot.candidates();
+		std::vector<size_t> lanes = hot.assignLanes(keys);
+		std::vector<std::pair<size_t, HotEntry>> entries;
+		for (size_t i = 0; i < keys.size(); ++i) {
+			entries.push_back({ std::hash<Key>()(keys[i]), HotEntry{ keys[i], Value{}, lanes[i], 0 } });
+		}
+		publishHotEntries(table, std::move(entries));
+	}
+	/**
+	* 读取各表项的当前值后发布，读不到的表项（已被淘汰）不再发布；调用者持有刷新锁
+	*/
+	void publishHotEntries(const Table& table, std::vector<std::pair<size_t, HotEntry>> entries) {
+		for (size_t i = 0; i < entries.size();) {
+			HotEntry& entry = entries[i].second;
+			// lane 分配表已在 assignLanes 中发布，之后的写入都会递增 lane。先读 lane 版本号再读值：
+			// 读值之前完成的写入已被读到，之后的写入使版本号不一致，表项随之失效
+			entry.version = table.hot->laneVersion(entry.lane);
+			// 经由分片读取同时刷新它在分片 LRU 中的位置，避免只被副本读到的热点 key 被淘汰
+			if (getFromSlices(table, entry.key, entry.value)) {
+				++i;
+			}
+			else {
+				std::swap(entries[i], entries.back());
+				entries.pop_back();
+			}
+		}
+		table.hot->publish(std::move(entries));
+	}
+	/**
+	* 换上只有热点副本不同的新表，旧副本的表项全部失效；调用者持有 _resizeMutex
+	*/
+	void replaceHot(std::shared_ptr<HotKeyReplica<Key, Value>> hot) {
+		const Table& table = current();
+		publish(std::make_unique<const Table>(Table{ table.slices, table.retiring, std::move(hot) }));
+		if (table.hot) table.hot->invalidateAll();
+	}
 public:
-	HashLRUCache(int capacity, int sliceNum) : _capacity(capacity), _sliceNum(sliceNum) {
+	HashLRUCache(int capacity, int sliceNum) : _capacity(capacity) {
 		// 初始化每个slice的LRU缓存
-		for (int i = 0; i < _sliceNum; ++i) {
-			_slices.push_back(std::make_unique<LRUCache<Key, Value>>(_capacity / _sliceNum));
-		}
+		publish(std::make_unique<const Table>(Table{ makeSlices(capacity, sliceNum), {}, nullptr }));
 	}
 	bool get(Key key, Value& value) {
-		int index = std::hash<Key>()(key) % _sliceNum;
-		return _slices[index]->get(key);
+		const Table& table = current();
+		if (table.hot) return getWithHotKeys(table, key, value);
+		return getFromSlices(table, key, value);
 	}
 	Value get(Key key) {
-		Value value;
+		Value value{};
 		get(key, value);
 		return value;
 	}
+	/**
+	* 不拷贝值的 get，见 LRUCache::getHandle；不经过热点副本
+	*/
+	typename Slice::Handle getHandle(Key key) {
+		const Table& table = current();
+		auto handle = sliceFor(table.slices, key).getHandle(key);
+		if (handle || table.retiring.empty()) return handle;
+		Value value{};
+		if (!migrateKey(sliceFor(table.retiring, key), key, value)) return handle;
+		return sliceFor(current().slices, key).getHandle(key);
+	}
 	void put(Key key, Value value) {
-		int index = std::hash<Key>()(key) % _sliceNum;
-		_slices[index]->put(key, value);
+		std::lock_guard<std::mutex> guard(keyLock(key));
+		const Table& table = current();
+		sliceFor(table.slices, key).put(key, value);
+		if (!table.retiring.empty()) sliceFor(table.retiring, key).remove(key);
+		bumpVersion(key);
+	}
+	void put(Key key, Value value, const std::vector<std::string>& tags) {
+		std::lock_guard<std::mutex> guard(keyLock(key));
+		const Table& table = current();
+		sliceFor(table.slices, key).put(key, value, tags);
+		if (!table.retiring.empty()) sliceFor(table.retiring, key).remove(key);
+		bumpVersion(key);
+	}
+	void remove(Key key) {
+		std::lock_guard<std::mutex> guard(keyLock(key));
+		const Table& table = current();
+		sliceFor(table.slices, key).remove(key);
+		if (!table.retiring.empty()) sliceFor(table.retiring, key).remove(key);
+		bumpVersion(key);
+	}
+
+	/**
+	* 删除所有带 tag 的条目，逐个分片分批进行，返回删除数量；被删除的 key 的版本号随之递增。
+	* 迁移中先处理旧表，等正在搬动的 key 落入新表后再处理新表，条目不会在两张表之间漏掉
+	*/
+	size_t invalidateTag(const std::string& tag) {
+		std::shared_lock<std::shared_mutex> lock(_tableMutex);
+		const Table& table = current();
+		size_t removed = 0;
+		auto bump = [this](const Key& key) { bumpVersion(key); };
+		if (!table.retiring.empty()) {
+			for (auto& slice : table.retiring) removed += slice->invalidateTag(tag, bump);
+			drainKeyLocks();
+		}
+		for (auto& slice : table.slices) removed += slice->invalidateTag(tag, bump);
+		return removed;
+	}
+	/**
+	* 删除所有 key 以 prefix 开头的条目（仅 std::string key），方式同 invalidateTag
+	*/
+	size_t invalidatePrefix(std::string_view prefix) {
+		enablePrefixIndex();
+		std::shared_lock<std::shared_mutex> lock(_tableMutex);
+		const Table& table = current();
+		size_t removed = 0;
+		auto bump = [this](const Key& key) { bumpVersion(key); };
+		if (!table.retiring.empty()) {
+			for (auto& slice : table.retiring) removed += slice->invalidatePrefix(prefix, bump);
+			drainKeyLocks();
+		}
+		for (auto& slice : table.slices) removed += slice->invalidatePrefix(prefix, bump);
+		return removed;
+	}
+	void enablePrefixIndex() {
+		{
+			std::shared_lock<std::shared_mutex> lock(_tableMutex);
+			if (_prefixIndex) return;
+		}
+		std::lock_guard<std::mutex> resize(_resizeMutex);
+		std::unique_lock<std::shared_mutex> lock(_tableMutex);
+		_prefixIndex = true;
+		const Table& table = current();
+		for (auto& slice : table.slices) slice->enablePrefixIndex();
+		for (auto& slice : table.retiring) slice->enablePrefixIndex();
+	}
+
+	/**
+	* key 所在条带的版本号。先读版本号再读值，之后版本号不变就说明值没有被 put/remove 改写过
+	*/
+	uint64_t version(const Key& key) const {
+		return stripeFor(key).value.load(std::memory_order_acquire);
+	}
+
+	/**
+	* 调整总容量，各分片按新容量分批淘汰；可与读写并发执行
+	*/
+	void setCapacity(int capacity) {
+		std::lock_guard<std::mutex> resize(_resizeMutex);
+		_capacity = capacity > 0 ? capacity : 0;
+		const SliceTable& slices = current().slices;
+		int perSlice = _capacity / static_cast<int>(slices.size());
+		for (auto& slice : slices) {
+			slice->setCapacity(perSlice);
+		}
+	}
+	/**
+	* 调整分片数，不重建缓存：新表立即生效，旧表中的条目按批迁移，可与读写并发执行
+	*/
+	void setSliceNum(int sliceNum) {
+		if (sliceNum <= 0) return;
+		std::lock_guard<std::mutex> resize(_resizeMutex);
+		const Table& table = current();
+		// 检测状态按分片记录，分片数变化后重新开始
+		auto hot = table.hot ? std::make_shared<HotKeyReplica<Key, Value>>(static_cast<size_t>(sliceNum), table.hot->options()) : nullptr;
+		publish(std::make_unique<const Table>(Table{ makeSlices(_capacity, sliceNum), table.slices, std::move(hot) }));
+		if (table.hot) table.hot->invalidateAll();
+		// 等已经拿到旧表的写入结束，之后旧分片只会被取出，不会再写入
+		drainKeyLocks();
+		finishMigration();
+	}
+	int getCapacity() {
+		return _capacity;
+	}
+	int getSliceNum() {
+		return static_cast<int>(current().slices.size());
+	}
+	size_t size() {
+		const Table& table = current();
+		size_t total = 0;
+		for (auto& slice : table.slices) total += slice->size();
+		for (auto& slice : table.retiring) total += slice->size();
+		return total;
+	}
+
+	/**
+	* 开启后台淘汰：后台线程让每个分片保持 headroomPerSlice 个空余槽位，put 通常只需占用空位；
+	* 写入速度超过后台淘汰速度、空位用完时 put 仍在锁内淘汰
+	*/
+	void enableBackgroundEviction(size_t headroomPerSlice, std::chrono::milliseconds interval = std::chrono::milliseconds(1)) {
+		disableBackgroundEviction();
+		std::lock_guard<std::mutex> resize(_resizeMutex);
+		{
+			std::unique_lock<std::shared_mutex> lock(_tableMutex);
+			_headroom = headroomPerSlice;
+			for (auto& slice : current().slices) slice->setHeadroom(_headroom);
+		}
+		_evictor = std::make_unique<BackgroundEvictor>([this](size_t batch) { return maintain(batch); }, interval);
+	}
+	void disableBackgroundEviction() {
+		std::lock_guard<std::mutex> resize(_resizeMutex);
+		_evictor.reset();
+		std::unique_lock<std::shared_mutex> lock(_tableMutex);
+		_headroom = 0;
+		for (auto& slice : current().slices) slice->setHeadroom(0);
+	}
+	/**
+	* 执行一批维护：每个分片最多淘汰 maxEvictionsPerSlice 个条目以恢复空余槽位，返回是否还有分片不足。
+	* 后台线程调用它，没有开启后台线程时也可以由调用者在空闲时主动调用
+	*/
+	bool maintain(size_t maxEvictionsPerSlice) {
+		bool remaining = false;
+		for (auto& slice : current().slices) {
+			remaining |= slice->evictToHeadroom(maxEvictionsPerSlice);
+		}
+		return remaining;
+	}
+	EvictionStats getEvictionStats() {
+		EvictionStats total;
+		for (auto& slice : current().slices) {
+			EvictionStats stats = slice->getEvictionStats();
+			total.inlineEvictions += stats.inlineEvictions;
+			total.backgroundEvictions += stats.backgroundEvictions;
+		}
+		return total;
+	}
+
+	/**
+	* 开启写入门卫，所有分片共享一个过滤器；windowSize 为 0 时取总容量的 4 倍
+	*/
+	void enableDoorkeeper(size_t windowSize = 0, double falsePositiveRate = 0.01) {
+		std::lock_guard<std::mutex> resize(_resizeMutex);
+		std::unique_lock<std::shared_mutex> lock(_tableMutex);
+		if (windowSize == 0) windowSize = static_cast<size_t>(_capacity > 0 ? _capacity.load() : 1) * 4;
+		_doorkeeper = std::make_shared<Doorkeeper>(windowSize, falsePositiveRate);
+		for (auto& slice : current().slices) slice->setDoorkeeper(_doorkeeper);
+	}
+	void disableDoorkeeper() {
+		std::lock_guard<std::mutex> resize(_resizeMutex);
+		std::unique_lock<std::shared_mutex> lock(_tableMutex);
+		_doorkeeper.reset();
+		for (auto& slice : current().slices) slice->setDoorkeeper(nullptr);
+	}
+	Doorkeeper::Stats getDoorkeeperStats() {
+		std::shared_lock<std::shared_mutex> lock(_tableMutex);
+		return _doorkeeper ? _doorkeeper->getStats() : Doorkeeper::Stats();
+	}
+
+	/**
+	* 限制所有分片被 pin 条目的总字节数，sizeOf 为空时每个条目按 sizeof(Value) 计；需在并发访问开始前调用
+	*/
+	void setPinLimit(size_t maxBytes, std::function<size_t(const Value&)> sizeOf = nullptr) {
+		std::lock_guard<std::mutex> resize(_resizeMutex);
+		std::unique_lock<std::shared_mutex> lock(_tableMutex);
+		_pinBudget = std::make_shared<PinBudget>(maxBytes);
+		_pinSizeOf = std::move(sizeOf);
+		const Table& table = current();
+		for (auto& slice : table.slices) slice->setPinBudget(_pinBudget, _pinSizeOf);
+		for (auto& slice : table.retiring) slice->setPinBudget(_pinBudget, _pinSizeOf);
+	}
+	PinBudget::Stats getPinStats() {
+		std::shared_lock<std::shared_mutex> lock(_tableMutex);
+		return _pinBudget->getStats();
+	}
+
+	/**
+	* 开启热点 key 检测：每个分片用 Space-Saving 统计采样到的读，占比超过 minShare 的 key
+	* 被复制到一个不可变的小表中，之后对它们的读不再进入分片锁。put/remove 按 lane 分配表递增该 key 的 lane，
+	* 副本中的旧值随即失效，直到下一个窗口刷新读出新值；与 FrontCache 一样，容量淘汰不使副本失效，
+	* 但每次刷新都会重新从分片读取，已被淘汰的 key 随之移出副本
+	*/
+	void enableHotKeys(const HotKeyOptions& options = HotKeyOptions()) {
+		std::lock_guard<std::mutex> resize(_resizeMutex);
+		replaceHot(std::make_shared<HotKeyReplica<Key, Value>>(current().slices.size(), options));
+	}
+	void disableHotKeys() {
+		std::lock_guard<std::mutex> resize(_resizeMutex);
+		replaceHot(nullptr);
+	}
+	/**
+	* 按采样估计的各分片读负载与热点副本的命中比例，用于比较开启前后的分片倾斜
+	*/
+	HotKeyStats getHotKeyStats() {
+		const Table& table = current();
+		return table.hot ? table.hot->getStats() : HotKeyStats();
+	}
+	std::vector<Key> getHotKeys() {
+		const Table& table = current();
+		return table.hot ? table.hot->hotKeys() : std::vector<Key>();
+	}
+
+	/**
+	* 所有分片共享同一个 profiler，需在并发访问开始前调用
+	*/
+	void setProfiler(std::shared_ptr<CacheProfiler> profiler) {
+		std::lock_guard<std::mutex> resize(_resizeMutex);
+		std::unique_lock<std::shared_mutex> lock(_tableMutex);
+		_profiler = profiler;
+		for (auto& slice : current().slices) {
+			slice->setProfiler(profiler);
+		}
+	}
+	/**
+	* 每个分片的加锁次数、竞争次数与持锁时间，用于定位热点分片
+	*/
+	std::vector<LockStats> getShardLockStats() {
+		std::vector<LockStats> stats;
+		for (auto& slice : current().slices) {
+			stats.push_back(slice->getLockStats());
+		}
+		return stats;
+	}
+
+	/**
+	* 逐个分片导出并写盘，同一时刻最多只锁住一个分片
+	*/
+	bool saveSnapshot(const std::string& path) {
+		std::lock_guard<std::mutex> resize(_resizeMutex);
+		const SliceTable& slices = current().slices;
+		SnapshotWriter writer(path, SnapshotKind::HashLRU);
+		writer.beginSection(SnapshotSection::Meta, 1);
+		writer.writeRecord(static_cast<uint32_t>(slices.size()));
+		for (auto& slice : slices) {
+			writer.writeEntries(slice->exportEntries());
+		}
+		return writer.finish();
+	}
+	/**
+	* 加载快照，分片数可以与保存时不同，数据按当前分片数重新分配
+	*/
+	bool loadSnapshot(const std::string& path) {
+		std::lock_guard<std::mutex> resize(_resizeMutex);
+		SnapshotReader reader;
+		if (!reader.open(path, SnapshotKind::HashLRU)) return false;
+		uint64_t metaCount = 0;
+		uint32_t savedSliceNum = 0;
+		if (!reader.beginSection(SnapshotSection::Meta, metaCount) || metaCount != 1 || !reader.read(savedSliceNum)) return false;
+		const Table& table = current();
+		std::vector<std::vector<std::pair<Key, Value>>> perSlice(table.slices.size());
+		for (uint32_t i = 0; i < savedSliceNum; ++i) {
+			std::vector<std::pair<Key, Value>> entries;
+			if (!reader.readEntries(entries)) return false;
+			for (auto& entry : entries) {
+				perSlice[sliceIndex(entry.first, table.slices.size())].push_back(std::move(entry));
+			}
+		}
+		if (!reader.atEnd()) return false;
+		for (size_t i = 0; i < table.slices.size(); ++i) {
+			table.slices[i]->importEntries(perSlice[i]);
+		}
+		for (size_t i = 0; i < kVersionStripes; ++i) {
+			_versions[i].value.fetch_add(1, std::memory_order_release);
+		}
+		if (table.hot) table.hot->invalidateAll();
+		return true;
 	}
 };
 
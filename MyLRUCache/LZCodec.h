@@ -0,0 +1,146 @@
+#pragma once
+#ifndef LZCODEC_H
+#define LZCODEC_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+/****************************************
+LZCodec
+
+LZ4 风格的快速 LZ77 块压缩，无外部依赖：
+	u32 原始长度 | 序列...
+	序列 = token(高 4 位字面量长度, 低 4 位匹配长度-4) | [扩展长度] | 字面量 | u16 偏移 | [扩展长度]
+最后一个序列只有字面量。解码时检查所有越界情况，损坏的数据返回 false。
+可以替换为任何提供相同静态接口的编解码器。
+****************************************/
+struct LZCodec {
+	static std::string compress(std::string_view in) {
+		std::string out;
+		out.reserve(in.size() + in.size() / 255 + 16);
+		uint32_t rawSize = static_cast<uint32_t>(in.size());
+		out.append(reinterpret_cast<const char*>(&rawSize), sizeof(rawSize));
+
+		const uint8_t* src = reinterpret_cast<const uint8_t*>(in.data());
+		const size_t n = in.size();
+		size_t anchor = 0;
+		if (n >= kMinInput) {
+			std::array<uint32_t, kHashSize> table{};   // 存 位置+1，0 表示空
+			const size_t matchLimit = n - kLastLiterals;
+			const size_t searchLimit = n - kMinInput + 1;
+			size_t ip = 0;
+			while (ip < searchLimit) {
+				uint32_t seq = read32(src + ip);
+				uint32_t h = hash(seq);
+				size_t candidate = table[h];
+				table[h] = static_cast<uint32_t>(ip + 1);
+				if (candidate != 0 && ip - (candidate - 1) <= kMaxOffset && read32(src + candidate - 1) == seq) {
+					size_t match = candidate - 1;
+					size_t length = kMinMatch;
+					while (ip + length < matchLimit && src[match + length] == src[ip + length]) ++length;
+					emitSequence(out, src + anchor, ip - anchor, ip - match, length);
+					ip += length;
+					anchor = ip;
+					continue;
+				}
+				// 连续未命中时逐渐加大步长，不可压缩的数据也能保持高吞吐
+				ip += 1 + ((ip - anchor) >> 6);
+			}
+		}
+		emitLastLiterals(out, src + anchor, n - anchor);
+		return out;
+	}
+
+	static bool decompress(std::string_view in, std::string& out) {
+		const uint8_t* ip = reinterpret_cast<const uint8_t*>(in.data());
+		const uint8_t* end = ip + in.size();
+		uint32_t rawSize = 0;
+		if (in.size() < sizeof(rawSize)) return false;
+		std::memcpy(&rawSize, ip, sizeof(rawSize));
+		ip += sizeof(rawSize);
+		out.resize(rawSize);
+		char* dst = out.data();
+		size_t op = 0;
+		while (ip < end) {
+			uint8_t token = *ip++;
+			size_t literals = token >> 4;
+			if (literals == 15 && !readLength(ip, end, literals)) return false;
+			if (static_cast<size_t>(end - ip) < literals || rawSize - op < literals) return false;
+			std::memcpy(dst + op, ip, literals);
+			ip += literals;
+			op += literals;
+			if (ip == end) break;
+
+			if (end - ip < 2) return false;
+			size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+			ip += 2;
+			if (offset == 0 || offset > op) return false;
+			size_t length = token & 0x0F;
+			if (length == 15 && !readLength(ip, end, length)) return false;
+			length += kMinMatch;
+			if (rawSize - op < length) return false;
+			// 偏移可能小于长度（重复模式），逐字节复制
+			const char* from = dst + op - offset;
+			for (size_t i = 0; i < length; ++i) dst[op + i] = from[i];
+			op += length;
+		}
+		return op == rawSize;
+	}
+
+private:
+	static constexpr size_t kMinMatch = 4;
+	static constexpr size_t kLastLiterals = 5;
+	static constexpr size_t kMinInput = 13;
+	static constexpr size_t kMaxOffset = 65535;
+	static constexpr int kHashBits = 12;
+	static constexpr size_t kHashSize = size_t{ 1 } << kHashBits;
+
+	static uint32_t read32(const uint8_t* p) {
+		uint32_t v;
+		std::memcpy(&v, p, sizeof(v));
+		return v;
+	}
+	static uint32_t hash(uint32_t v) {
+		return (v * 2654435761u) >> (32 - kHashBits);
+	}
+
+	static void writeLength(std::string& out, size_t length) {
+		while (length >= 255) {
+			out.push_back(static_cast<char>(255));
+			length -= 255;
+		}
+		out.push_back(static_cast<char>(length));
+	}
+	static bool readLength(const uint8_t*& ip, const uint8_t* end, size_t& length) {
+		uint8_t b;
+		do {
+			if (ip >= end) return false;
+			b = *ip++;
+			length += b;
+		} while (b == 255);
+		return true;
+	}
+
+	static void emitSequence(std::string& out, const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength) {
+		size_t ml = matchLength - kMinMatch;
+		uint8_t token = static_cast<uint8_t>(((literalCount < 15 ? literalCount : 15) << 4) | (ml < 15 ? ml : 15));
+		out.push_back(static_cast<char>(token));
+		if (literalCount >= 15) writeLength(out, literalCount - 15);
+		out.append(reinterpret_cast<const char*>(literals), literalCount);
+		out.push_back(static_cast<char>(offset & 0xFF));
+		out.push_back(static_cast<char>(offset >> 8));
+		if (ml >= 15) writeLength(out, ml - 15);
+	}
+
+	static void emitLastLiterals(std::string& out, const uint8_t* literals, size_t literalCount) {
+		uint8_t token = static_cast<uint8_t>((literalCount < 15 ? literalCount : 15) << 4);
+		out.push_back(static_cast<char>(token));
+		if (literalCount >= 15) writeLength(out, literalCount - 15);
+		out.append(reinterpret_cast<const char*>(literals), literalCount);
+	}
+};
+
+#endif // LZCODEC_H
@@ -0,0 +1,1020 @@
+/****************************************
+MemcachedServer
+
+把 HashLRUCache 作为独立 sidecar 运行的服务端，兼容 memcached 文本协议与 meta 协议：
+	文本协议：get/gets（多 key）、set/add/replace、delete、touch、version、stats、quit
+	meta 协议：mg/ms/md/mn，支持 v k f s t c q O 标志
+网络层是基于 epoll 的多 reactor：每个核一个事件循环线程，监听 socket（TCP 与 Unix socket）
+以 EPOLLEXCLUSIVE 加入所有循环，连接由接受它的循环独占处理，不跨线程。
+同一次读到的多条请求（pipeline）全部处理完后只 writev 一次；缓存中的条目保存完整的
+"VALUE <key> <flags> <bytes>\r\n<data>\r\n" 缓冲区，响应直接引用它，不拷贝数据。
+同一个程序也是压测工具：--loadgen 连接已有服务，--bench 在进程内启动服务并对回环地址压测，
+输出请求数/秒与延迟分位数。
+
+只支持 Linux，不在 Windows 工程中编译：
+	g++ -std=c++20 -O2 -pthread -I. MemcachedServer.cpp -o memcached-lru
+****************************************/
+#if !defined(__linux__)
+#error "MemcachedServer requires Linux (epoll)"
+#endif
+
+#include "LRUCache.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kMaxKeyLength = 250;
+constexpr size_t kMaxValueLength = 1 << 20;
+constexpr size_t kMaxLineLength = 2048;
+constexpr size_t kReadChunk = 16 * 1024;
+// 待发送数据超过该值时暂停读取，等客户端收走响应
+constexpr size_t kMaxPendingOutput = 4 << 20;
+constexpr int kMaxIov = 1024;
+constexpr uint32_t kRelativeExptimeLimit = 60 * 60 * 24 * 30;
+
+std::atomic<bool> g_stopping{ false };
+
+int64_t nowMs() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+* memcached 的过期时间：0 不过期，不超过 30 天为相对秒数，否则为 Unix 时间戳；负数表示立即过期
+*/
+int64_t expireAtFor(int64_t exptime) {
+	if (exptime == 0) return 0;
+	if (exptime < 0) return -1;
+	if (exptime <= kRelativeExptimeLimit) return nowMs() + exptime * 1000;
+	int64_t delta = exptime - static_cast<int64_t>(std::time(nullptr));
+	return delta > 0 ? nowMs() + delta * 1000 : -1;
+}
+
+/****************************************
+Item
+
+缓存中的一个值。buffer 为完整的文本协议响应块，data 与末尾的 \r\n 是它的后缀，
+meta 协议只引用后缀部分；条目不可变，更新时整体替换
+****************************************/
+struct Item {
+	std::string buffer;
+	uint32_t headerLength = 0;
+	uint32_t dataLength = 0;
+	uint32_t flags = 0;
+	uint64_t cas = 0;
+	int64_t expireAt = 0;
+
+	std::string_view header() const { return std::string_view(buffer.data(), headerLength); }
+	// data 后面紧跟 \r\n
+	std::string_view dataWithCrlf() const { return std::string_view(buffer.data() + headerLength, dataLength + 2); }
+	bool expired(int64_t now) const { return expireAt != 0 && now >= expireAt; }
+};
+using ItemPtr = std::shared_ptr<const Item>;
+
+std::atomic<uint64_t> g_casCounter{ 0 };
+
+ItemPtr makeItem(std::string_view key, uint32_t flags, std::string_view data, int64_t expireAt) {
+	auto item = std::make_shared<Item>();
+	item->buffer.reserve(key.size() + data.size() + 48);
+	item->buffer.append("VALUE ").append(key).append(" ").append(std::to_string(flags))
+		.append(" ").append(std::to_string(data.size())).append("\r\n");
+	item->headerLength = static_cast<uint32_t>(item->buffer.size());
+	item->buffer.append(data).append("\r\n");
+	item->dataLength = static_cast<uint32_t>(data.size());
+	item->flags = flags;
+	item->cas = g_casCounter.fetch_add(1, std::memory_order_relaxed) + 1;
+	item->expireAt = expireAt;
+	return item;
+}
+
+template<typename T>
+bool parseNumber(std::string_view text, T& value) {
+	auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+	return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+bool validKey(std::string_view key) {
+	if (key.empty() || key.size() > kMaxKeyLength) return false;
+	for (char c : key) {
+		if (static_cast<unsigned char>(c) <= ' ' || c == 0x7F) return false;
+	}
+	return true;
+}
+
+/****************************************
+Store
+
+HashLRUCache 之上的 memcached 语义：惰性过期、add/replace、统计。
+add/replace 先查后写，与同一 key 的并发写入之间不是原子的
+****************************************/
+class Store {
+public:
+	struct Stats {
+		std::atomic<uint64_t> getHits{ 0 };
+		std::atomic<uint64_t> getMisses{ 0 };
+		std::atomic<uint64_t> sets{ 0 };
+		std::atomic<uint64_t> deletes{ 0 };
+		std::atomic<uint64_t> connections{ 0 };
+	};
+
+	Store(int capacity, int shards) : _cache(capacity, shards) {}
+
+	ItemPtr get(std::string_view key) {
+		ItemPtr item;
+		std::string k(key);
+		if (!_cache.get(k, item) || !item) {
+			_stats.getMisses.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		if (item->expired(nowMs())) {
+			_cache.remove(k);
+			_stats.getMisses.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		_stats.getHits.fetch_add(1, std::memory_order_relaxed);
+		return item;
+	}
+	void set(std::string_view key, ItemPtr item) {
+		_stats.sets.fetch_add(1, std::memory_order_relaxed);
+		if (item->expireAt < 0) {
+			_cache.remove(std::string(key));
+			return;
+		}
+		_cache.put(std::string(key), std::move(item));
+	}
+	bool remove(std::string_view key) {
+		std::string k(key);
+		ItemPtr item;
+		bool found = _cache.get(k, item) && item && !item->expired(nowMs());
+		_cache.remove(k);
+		if (found) _stats.deletes.fetch_add(1, std::memory_order_relaxed);
+		return found;
+	}
+	size_t size() { return _cache.size(); }
+	int capacity() { return _cache.getCapacity(); }
+	Stats& stats() { return _stats; }
+
+private:
+	HashLRUCache<std::string, ItemPtr> _cache;
+	Stats _stats;
+};
+
+/****************************************
+Connection
+
+一个客户端连接的读缓冲与待发送队列。待发送数据按段记录：
+引用缓存条目的段直接指向条目内存（同时持有 ItemPtr 保证发送完之前不被释放），
+生成的短文本写入 _text，按偏移记录，发送前才换算成 iovec
+****************************************/
+class Connection {
+public:
+	explicit Connection(int fd) : fd(fd) {}
+	~Connection() { ::close(fd); }
+
+	int fd;
+	std::string in;
+	size_t inPos = 0;
+	bool closing = false;
+	bool wantWrite = false;
+
+	void appendStatic(std::string_view text) { _segments.push_back({ text.data(), 0, text.size() }); _pending += text.size(); }
+	void appendText(std::string_view text) {
+		_segments.push_back({ nullptr, _text.size(), text.size() });
+		_text.append(text);
+		_pending += text.size();
+	}
+	void appendItem(const ItemPtr& item, std::string_view part) {
+		_segments.push_back({ part.data(), 0, part.size() });
+		_pinned.push_back(item);
+		_pending += part.size();
+	}
+	size_t pending() const { return _pending; }
+
+	/**
+	* 用 writev 尽量发送，返回 false 表示连接出错
+	*/
+	bool flush() {
+		while (_head < _segments.size()) {
+			iovec iov[kMaxIov];
+			int count = 0;
+			for (size_t i = _head; i < _segments.size() && count < kMaxIov; ++i, ++count) {
+				const Segment& segment = _segments[i];
+				const char* base = segment.ptr ? segment.ptr : _text.data() + segment.offset;
+				size_t skip = i == _head ? _headSent : 0;
+				iov[count].iov_base = const_cast<char*>(base + skip);
+				iov[count].iov_len = segment.length - skip;
+			}
+			ssize_t written = ::writev(fd, iov, count);
+			if (written < 0) {
+				if (errno == EINTR) continue;
+				if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+				return false;
+			}
+			_pending -= static_cast<size_t>(written);
+			size_t left = static_cast<size_t>(written);
+			while (left > 0) {
+				size_t rest = _segments[_head].length - _headSent;
+				if (left < rest) {
+					_headSent += left;
+					break;
+				}
+				left -= rest;
+				_headSent = 0;
+				++_head;
+			}
+		}
+		_segments.clear();
+		_pinned.clear();
+		_text.clear();
+		_head = 0;
+		_headSent = 0;
+		return true;
+	}
+
+private:
+	struct Segment {
+		const char* ptr;	// 为空表示位于 _text 的 offset 处
+		size_t offset;
+		size_t length;
+	};
+	std::vector<Segment> _segments;
+	std::vector<ItemPtr> _pinned;
+	std::string _text;
+	size_t _head = 0;
+	size_t _headSent = 0;
+	size_t _pending = 0;
+};
+
+/****************************************
+Protocol
+
+解析一个连接读缓冲中所有完整的请求，把响应追加到连接的发送队列
+****************************************/
+class Protocol {
+public:
+	explicit Protocol(Store& store) : _store(store) {}
+
+	/**
+	* 返回是否因为发送队列积压而提前停止，此时缓冲中可能还有完整的请求
+	*/
+	bool process(Connection& conn) {
+		while (!conn.closing && conn.pending() < kMaxPendingOutput) {
+			size_t lineEnd = conn.in.find('\n', conn.inPos);
+			if (lineEnd == std::string::npos) {
+				if (conn.in.size() - conn.inPos > kMaxLineLength) {
+					conn.appendStatic("CLIENT_ERROR line too long\r\n");
+					conn.closing = true;
+				}
+				break;
+			}
+			std::string_view line(conn.in.data() + conn.inPos, lineEnd - conn.inPos);
+			if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+			size_t consumed = lineEnd + 1 - conn.inPos;
+			size_t extra = 0;
+			if (!handleLine(conn, line, consumed, extra)) break;	// 数据块还没收全
+			conn.inPos += consumed + extra;
+		}
+		// 已处理的部分从缓冲区移除
+		if (conn.inPos > 0 && (conn.inPos == conn.in.size() || conn.inPos > kReadChunk)) {
+			conn.in.erase(0, conn.inPos);
+			conn.inPos = 0;
+		}
+		return !conn.closing && conn.pending() >= kMaxPendingOutput;
+	}
+
+private:
+	static constexpr size_t kMaxTokens = 24;
+
+	static size_t tokenize(std::string_view line, std::string_view* tokens) {
+		size_t count = 0;
+		size_t pos = 0;
+		while (pos < line.size() && count < kMaxTokens) {
+			while (pos < line.size() && line[pos] == ' ') ++pos;
+			if (pos >= line.size()) break;
+			size_t end = line.find(' ', pos);
+			if (end == std::string_view::npos) end = line.size();
+			tokens[count++] = line.substr(pos, end - pos);
+			pos = end;
+		}
+		return count;
+	}
+
+	/**
+	* 处理一行请求；存储命令的数据块不完整时返回 false，extra 为该命令额外消耗的数据块字节数
+	*/
+	bool handleLine(Connection& conn, std::string_view line, size_t consumed, size_t& extra) {
+		std::string_view tokens[kMaxTokens];
+		size_t count = tokenize(line, tokens);
+		if (count == 0) {
+			conn.appendStatic("ERROR\r\n");
+			return true;
+		}
+		std::string_view cmd = tokens[0];
+		if (cmd == "get" || cmd == "gets") {
+			// 多 key 的 get 可能超过 kMaxTokens 个 token，key 直接从整行中逐个取出
+			handleGet(conn, line.substr(cmd.data() + cmd.size() - line.data()), cmd == "gets");
+			return true;
+		}
+		if (cmd == "set" || cmd == "add" || cmd == "replace") {
+			return handleStore(conn, cmd, tokens, count, consumed, extra);
+		}
+		if (cmd == "delete") {
+			bool noreply = count >= 3 && tokens[count - 1] == "noreply";
+			if (count < 2 || !validKey(tokens[1])) {
+				conn.appendStatic("CLIENT_ERROR bad command line format\r\n");
+				return true;
+			}
+			bool found = _store.remove(tokens[1]);
+			if (!noreply) conn.appendStatic(found ? "DELETED\r\n" : "NOT_FOUND\r\n");
+			return true;
+		}
+		if (cmd == "touch") {
+			handleTouch(conn, tokens, count);
+			return true;
+		}
+		if (cmd == "mg") {
+			handleMetaGet(conn, tokens, count);
+			return true;
+		}
+		if (cmd == "ms") {
+			return handleMetaSet(conn, tokens, count, consumed, extra);
+		}
+		if (cmd == "md") {
+			handleMetaDelete(conn, tokens, count);
+			return true;
+		}
+		if (cmd == "mn") {
+			conn.appendStatic("MN\r\n");
+			return true;
+		}
+		if (cmd == "version") {
+			conn.appendStatic("VERSION 1.6.0-lru\r\n");
+			return true;
+		}
+		if (cmd == "stats") {
+			handleStats(conn);
+			return true;
+		}
+		if (cmd == "quit") {
+			conn.closing = true;
+			return true;
+		}
+		conn.appendStatic("ERROR\r\n");
+		return true;
+	}
+
+	/**
+	* keys 为命令之后的部分，以空格分隔，个数不限
+	*/
+	void handleGet(Connection& conn, std::string_view keys, bool withCas) {
+		size_t pos = 0;
+		while (pos < keys.size()) {
+			while (pos < keys.size() && keys[pos] == ' ') ++pos;
+			if (pos >= keys.size()) break;
+			size_t end = keys.find(' ', pos);
+			if (end == std::string_view::npos) end = keys.size();
+			std::string_view key = keys.substr(pos, end - pos);
+			pos = end;
+			if (!validKey(key)) continue;
+			ItemPtr item = _store.get(key);
+			if (!item) continue;
+			if (withCas) {
+				// gets 需要在头部带 cas，不能直接用缓存的头部
+				std::string_view header = item->header();
+				header.remove_suffix(2);
+				conn.appendText(header);
+				conn.appendText(" " + std::to_string(item->cas) + "\r\n");
+			}
+			else {
+				conn.appendItem(item, item->header());
+			}
+			conn.appendItem(item, item->dataWithCrlf());
+		}
+		conn.appendStatic("END\r\n");
+	}
+
+	bool handleStore(Connection& conn, std::string_view cmd, const std::string_view* tokens, size_t count, size_t consumed, size_t& extra) {
+		uint32_t flags = 0;
+		int64_t exptime = 0;
+		size_t bytes = 0;
+		if (count < 5 || !validKey(tokens[1]) || !parseNumber(tokens[2], flags) || !parseNumber(tokens[3], exptime)
+			|| !parseNumber(tokens[4], bytes) || bytes > kMaxValueLength) {
+			conn.appendStatic("CLIENT_ERROR bad command line format\r\n");
+			conn.closing = true;
+			return true;
+		}
+		bool noreply = count >= 6 && tokens[5] == "noreply";
+		size_t dataStart = conn.inPos + consumed;
+		if (conn.in.size() < dataStart + bytes + 2) return false;
+		std::string_view data(conn.in.data() + dataStart, bytes);
+		extra = bytes + 2;
+		if (conn.in.compare(dataStart + bytes, 2, "\r\n") != 0) {
+			// 数据长度与声明不符时无法确定下一条命令从哪里开始，与 memcached 一样回复错误后关闭连接
+			conn.appendStatic("CLIENT_ERROR bad data chunk\r\n");
+			conn.closing = true;
+			return true;
+		}
+		if (cmd != "set") {
+			bool exists = _store.get(tokens[1]) != nullptr;
+			if ((cmd == "add") == exists) {
+				if (!noreply) conn.appendStatic("NOT_STORED\r\n");
+				return true;
+			}
+		}
+		_store.set(tokens[1], makeItem(tokens[1], flags, data, expireAtFor(exptime)));
+		if (!noreply) conn.appendStatic("STORED\r\n");
+		return true;
+	}
+
+	void handleTouch(Connection& conn, const std::string_view* tokens, size_t count) {
+		int64_t exptime = 0;
+		if (count < 3 || !validKey(tokens[1]) || !parseNumber(tokens[2], exptime)) {
+			conn.appendStatic("CLIENT_ERROR bad command line format\r\n");
+			return;
+		}
+		bool noreply = count >= 4 && tokens[3] == "noreply";
+		ItemPtr item = _store.get(tokens[1]);
+		if (item) {
+			// 条目不可变，改过期时间需要换一个新条目
+			auto touched = std::make_shared<Item>(*item);
+			touched->expireAt = expireAtFor(exptime);
+			_store.set(tokens[1], std::move(touched));
+		}
+		if (!noreply) conn.appendStatic(item ? "TOUCHED\r\n" : "NOT_FOUND\r\n");
+	}
+
+	/**
+	* meta 标志中需要回显的部分：O(opaque) 与 k(key)
+	*/
+	static void appendEcho(std::string& out, std::string_view key, const std::string_view* tokens, size_t count, size_t first) {
+		for (size_t i = first; i < count; ++i) {
+			if (tokens[i][0] == 'O') out.append(" ").append(tokens[i]);
+			else if (tokens[i] == "k") out.append(" k").append(key);
+		}
+	}
+	static bool hasFlag(const std::string_view* tokens, size_t count, size_t first, char flag) {
+		for (size_t i = first; i < count; ++i) {
+			if (tokens[i][0] == flag) return true;
+		}
+		return false;
+	}
+
+	void handleMetaGet(Connection& conn, const std::string_view* tokens, size_t count) {
+		if (count < 2 || !validKey(tokens[1])) {
+			conn.appendStatic("CLIENT_ERROR bad command line format\r\n");
+			return;
+		}
+		std::string_view key = tokens[1];
+		ItemPtr item = _store.get(key);
+		if (!item) {
+			if (hasFlag(tokens, count, 2, 'q')) return;
+			std::string out = "EN";
+			appendEcho(out, key, tokens, count, 2);
+			conn.appendText(out.append("\r\n"));
+			return;
+		}
+		bool withValue = false;
+		std::string flags;
+		for (size_t i = 2; i < count; ++i) {
+			switch (tokens[i][0]) {
+			case 'v': withValue = true; break;
+			case 'f': flags.append(" f").append(std::to_string(item->flags)); break;
+			case 's': flags.append(" s").append(std::to_string(item->dataLength)); break;
+			case 'c': flags.append(" c").append(std::to_string(item->cas)); break;
+			case 't': {
+				int64_t ttl = item->expireAt == 0 ? -1 : std::max<int64_t>(0, (item->expireAt - nowMs()) / 1000);
+				flags.append(" t").append(std::to_string(ttl));
+				break;
+			}
+			default: break;
+			}
+		}
+		appendEcho(flags, key, tokens, count, 2);
+		if (withValue) {
+			conn.appendText("VA " + std::to_string(item->dataLength) + flags + "\r\n");
+			conn.appendItem(item, item->dataWithCrlf());
+		}
+		else {
+			conn.appendText("HD" + flags + "\r\n");
+		}
+	}
+
+	bool handleMetaSet(Connection& conn, const std::string_view* tokens, size_t count, size_t consumed, size_t& extra) {
+		size_t bytes = 0;
+		if (count < 3 || !validKey(tokens[1]) || !parseNumber(tokens[2], bytes) || bytes > kMaxValueLength) {
+			conn.appendStatic("CLIENT_ERROR bad command line format\r\n");
+			conn.closing = true;
+			return true;
+		}
+		size_t dataStart = conn.inPos + consumed;
+		if (conn.in.size() < dataStart + bytes + 2) return false;
+		extra = bytes + 2;
+		if (conn.in.compare(dataStart + bytes, 2, "\r\n") != 0) {
+			// 数据长度与声明不符时无法确定下一条命令从哪里开始，与 memcached 一样回复错误后关闭连接
+			conn.appendStatic("CLIENT_ERROR bad data chunk\r\n");
+			conn.closing = true;
+			return true;
+		}
+		uint32_t flags = 0;
+		int64_t exptime = 0;
+		for (size_t i = 3; i < count; ++i) {
+			std::string_view arg = tokens[i].substr(1);
+			if (tokens[i][0] == 'F' && !parseNumber(arg, flags)) flags = 0;
+			if (tokens[i][0] == 'T' && !parseNumber(arg, exptime)) exptime = 0;
+		}
+		std::string_view key = tokens[1];
+		_store.set(key, makeItem(key, flags, std::string_view(conn.in.data() + dataStart, bytes), expireAtFor(exptime)));
+		if (hasFlag(tokens, count, 3, 'q')) return true;
+		std::string out = "HD";
+		appendEcho(out, key, tokens, count, 3);
+		conn.appendText(out.append("\r\n"));
+		return true;
+	}
+
+	void handleMetaDelete(Connection& conn, const std::string_view* tokens, size_t count) {
+		if (count < 2 || !validKey(tokens[1])) {
+			conn.appendStatic("CLIENT_ERROR bad command line format\r\n");
+			return;
+		}
+		bool found = _store.remove(tokens[1]);
+		// q 模式下 HD 与 NF 都不回复
+		if (hasFlag(tokens, count, 2, 'q')) return;
+		std::string out = found ? "HD" : "NF";
+		appendEcho(out, tokens[1], tokens, count, 2);
+		conn.appendText(out.append("\r\n"));
+	}
+
+	void handleStats(Connection& conn) {
+		Store::Stats& stats = _store.stats();
+		uint64_t hits = stats.getHits.load();
+		uint64_t misses = stats.getMisses.load();
+		std::string out;
+		out.append("STAT curr_items ").append(std::to_string(_store.size())).append("\r\n");
+		out.append("STAT limit_items ").append(std::to_string(_store.capacity())).append("\r\n");
+		out.append("STAT cmd_get ").append(std::to_string(hits + misses)).append("\r\n");
+		out.append("STAT get_hits ").append(std::to_string(hits)).append("\r\n");
+		out.append("STAT get_misses ").append(std::to_string(misses)).append("\r\n");
+		out.append("STAT cmd_set ").append(std::to_string(stats.sets.load())).append("\r\n");
+		out.append("STAT delete_hits ").append(std::to_string(stats.deletes.load())).append("\r\n");
+		out.append("STAT total_connections ").append(std::to_string(stats.connections.load())).append("\r\n");
+		out.append("END\r\n");
+		conn.appendText(out);
+	}
+
+	Store& _store;
+};
+
+/****************************************
+Server
+
+多 reactor：每个线程一个 epoll，监听 socket 以 EPOLLEXCLUSIVE 加入每个 epoll，
+新连接只注册到接受它的线程
+****************************************/
+class Server {
+public:
+	Server(Store& store, int threads) : _store(store), _threads(threads > 0 ? threads : 1) {}
+	~Server() {
+		stop();
+		for (int fd : _listeners) ::close(fd);
+	}
+
+	/**
+	* 监听 TCP 地址，port 为 0 时由系统分配，返回实际端口；失败返回 -1
+	*/
+	int listenTcp(const std::string& host, int port) {
+		int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (fd < 0) return -1;
+		int one = 1;
+		::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(static_cast<uint16_t>(port));
+		if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1
+			|| ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 1024) != 0) {
+			::close(fd);
+			return -1;
+		}
+		socklen_t len = sizeof(addr);
+		::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+		_listeners.push_back(fd);
+		return ntohs(addr.sin_port);
+	}
+	bool listenUnix(const std::string& path) {
+		int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (fd < 0) return false;
+		sockaddr_un addr{};
+		addr.sun_family = AF_UNIX;
+		if (path.size() >= sizeof(addr.sun_path)) {
+			::close(fd);
+			return false;
+		}
+		std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+		::unlink(path.c_str());
+		if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 1024) != 0) {
+			::close(fd);
+			return false;
+		}
+		_listeners.push_back(fd);
+		return true;
+	}
+
+	void start() {
+		for (int i = 0; i < _threads; ++i) {
+			_loops.push_back(std::thread([this]() { runLoop(); }));
+		}
+	}
+	void stop() {
+		_stopping = true;
+		for (auto& loop : _loops) loop.join();
+		_loops.clear();
+	}
+
+private:
+	void runLoop() {
+		int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+		if (epfd < 0) return;
+		for (int fd : _listeners) {
+			epoll_event ev{};
+			ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+			ev.data.u64 = static_cast<uint64_t>(fd);
+			::epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+		}
+		Protocol protocol(_store);
+		std::unordered_map<int, std::unique_ptr<Connection>> connections;
+		std::vector<epoll_event> events(256);
+		std::vector<char> readBuffer(kReadChunk);
+		auto isListener = [this](int fd) { return std::find(_listeners.begin(), _listeners.end(), fd) != _listeners.end(); };
+		auto update = [epfd](Connection& conn, bool wantWrite) {
+			if (conn.wantWrite == wantWrite) return;
+			conn.wantWrite = wantWrite;
+			epoll_event ev{};
+			// 发送队列积压时不再读，等可写后再恢复
+			ev.events = wantWrite ? EPOLLOUT : EPOLLIN;
+			ev.data.u64 = static_cast<uint64_t>(conn.fd);
+			::epoll_ctl(epfd, EPOLL_CTL_MOD, conn.fd, &ev);
+		};
+		while (!_stopping && !g_stopping.load(std::memory_order_relaxed)) {
+			int n = ::epoll_wait(epfd, events.data(), static_cast<int>(events.size()), 100);
+			for (int i = 0; i < n; ++i) {
+				int fd = static_cast<int>(events[i].data.u64);
+				if (isListener(fd)) {
+					while (true) {
+						int client = ::accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+						if (client < 0) break;
+						int one = 1;
+						::setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+						epoll_event ev{};
+						ev.events = EPOLLIN;
+						ev.data.u64 = static_cast<uint64_t>(client);
+						::epoll_ctl(epfd, EPOLL_CTL_ADD, client, &ev);
+						connections[client] = std::make_unique<Connection>(client);
+						_store.stats().connections.fetch_add(1, std::memory_order_relaxed);
+					}
+					continue;
+				}
+				auto it = connections.find(fd);
+				if (it == connections.end()) continue;
+				Connection& conn = *it->second;
+				bool alive = !(events[i].events & (EPOLLERR | EPOLLHUP)) || (events[i].events & EPOLLIN);
+				if (alive && (events[i].events & EPOLLIN)) {
+					while (true) {
+						ssize_t got = ::read(fd, readBuffer.data(), readBuffer.size());
+						if (got > 0) {
+							conn.in.append(readBuffer.data(), static_cast<size_t>(got));
+							if (static_cast<size_t>(got) < readBuffer.size()) break;
+							continue;
+						}
+						if (got < 0 && errno == EINTR) continue;
+						if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+						alive = false;	// 对端关闭或出错
+						break;
+					}
+				}
+				// 处理本次读到的所有请求后统一发送一次；因积压暂停处理时，发送完再继续处理剩余请求
+				bool more = alive;
+				while (alive && more) {
+					more = protocol.process(conn);
+					alive = conn.flush();
+					if (conn.pending() > 0) break;
+				}
+				if (!alive || (conn.closing && conn.pending() == 0)) {
+					::epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+					connections.erase(it);
+					continue;
+				}
+				update(conn, conn.pending() > 0);
+			}
+		}
+		connections.clear();
+		::close(epfd);
+	}
+
+	Store& _store;
+	int _threads;
+	std::vector<int> _listeners;
+	std::vector<std::thread> _loops;
+	std::atomic<bool> _stopping{ false };
+};
+
+/****************************************
+LoadGenerator
+
+回环压测：每个连接一个线程，每轮 pipeline 发送 depth 个请求（按 setRatio 混合 get 与 set），
+收齐响应后记录每个请求从发送到收到响应的耗时
+****************************************/
+struct LoadOptions {
+	std::string host = "127.0.0.1";
+	int port = 11211;
+	std::string unixPath;
+	int connections = 8;
+	int depth = 16;
+	int seconds = 5;
+	int keys = 100000;
+	int valueSize = 100;
+	double setRatio = 0.1;
+};
+
+class LoadGenerator {
+public:
+	explicit LoadGenerator(const LoadOptions& options) : _options(options) {}
+
+	bool run() {
+		if (!prefill()) {
+			std::cerr << "loadgen: cannot connect" << std::endl;
+			return false;
+		}
+		std::vector<std::vector<uint32_t>> latencies(_options.connections);
+		std::vector<std::thread> threads;
+		std::atomic<int> failed{ 0 };
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(_options.seconds);
+		auto start = std::chrono::steady_clock::now();
+		for (int c = 0; c < _options.connections; ++c) {
+			threads.emplace_back([this, c, deadline, &latencies, &failed]() {
+				if (!worker(c, deadline, latencies[c])) failed.fetch_add(1);
+			});
+		}
+		for (auto& thread : threads) thread.join();
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::vector<uint32_t> all;
+		for (auto& part : latencies) all.insert(all.end(), part.begin(), part.end());
+		std::sort(all.begin(), all.end());
+		auto percentile = [&all](double p) -> uint32_t {
+			return all.empty() ? 0 : all[std::min(all.size() - 1, static_cast<size_t>(p * static_cast<double>(all.size())))];
+		};
+		std::printf("loadgen: %d connections x depth %d, %.1f s, %zu requests, %.0f req/s, failed connections %d\n",
+			_options.connections, _options.depth, elapsed, all.size(), static_cast<double>(all.size()) / elapsed, failed.load());
+		std::printf("latency us: p50 %u, p90 %u, p99 %u, p99.9 %u, max %u\n",
+			percentile(0.5), percentile(0.9), percentile(0.99), percentile(0.999), all.empty() ? 0 : all.back());
+		return failed.load() == 0;
+	}
+
+private:
+	int connect() const {
+		int fd;
+		if (!_options.unixPath.empty()) {
+			fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+			sockaddr_un addr{};
+			addr.sun_family = AF_UNIX;
+			std::strncpy(addr.sun_path, _options.unixPath.c_str(), sizeof(addr.sun_path) - 1);
+			if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+		}
+		else {
+			fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+			sockaddr_in addr{};
+			addr.sin_family = AF_INET;
+			addr.sin_port = htons(static_cast<uint16_t>(_options.port));
+			::inet_pton(AF_INET, _options.host.c_str(), &addr.sin_addr);
+			if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+				int one = 1;
+				::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+				return fd;
+			}
+		}
+		if (fd >= 0) ::close(fd);
+		return -1;
+	}
+
+	static bool sendAll(int fd, const std::string& data) {
+		size_t sent = 0;
+		while (sent < data.size()) {
+			ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) return false;
+			sent += static_cast<size_t>(n);
+		}
+		return true;
+	}
+
+	/**
+	* 从 buffer 中解析一个完整响应（STORED 或 VALUE... END），返回消耗的字节数，不完整返回 0
+	*/
+	static size_t parseResponse(const std::string& buffer, size_t pos) {
+		size_t cursor = pos;
+		while (true) {
+			size_t end = buffer.find("\r\n", cursor);
+			if (end == std::string::npos) return 0;
+			std::string_view line(buffer.data() + cursor, end - cursor);
+			cursor = end + 2;
+			if (line.substr(0, 6) == "VALUE ") {
+				size_t lastSpace = line.rfind(' ');
+				size_t bytes = 0;
+				parseNumber(line.substr(lastSpace + 1), bytes);
+				if (buffer.size() < cursor + bytes + 2) return 0;
+				cursor += bytes + 2;
+				continue;
+			}
+			return cursor - pos;
+		}
+	}
+
+	void appendRequest(std::string& out, std::mt19937& rng, const std::string& value) const {
+		int key = static_cast<int>(rng() % static_cast<uint32_t>(_options.keys));
+		bool isSet = std::uniform_real_distribution<double>(0, 1)(rng) < _options.setRatio;
+		if (isSet) {
+			out.append("set key:").append(std::to_string(key)).append(" 0 0 ").append(std::to_string(value.size()))
+				.append("\r\n").append(value).append("\r\n");
+		}
+		else {
+			out.append("get key:").append(std::to_string(key)).append("\r\n");
+		}
+	}
+
+	bool prefill() {
+		int fd = connect();
+		if (fd < 0) return false;
+		std::string value(static_cast<size_t>(_options.valueSize), 'x');
+		std::string batch;
+		std::string response;
+		char buffer[16 * 1024];
+		bool ok = true;
+		for (int key = 0; key < _options.keys && ok; ++key) {
+			batch.append("set key:").append(std::to_string(key)).append(" 0 0 ").append(std::to_string(value.size()))
+				.append(" noreply\r\n").append(value).append("\r\n");
+			if (batch.size() > 64 * 1024 || key + 1 == _options.keys) {
+				ok = sendAll(fd, batch);
+				batch.clear();
+			}
+		}
+		// 用 mn 确认前面的 noreply 写入都已处理
+		ok = ok && sendAll(fd, "mn\r\n");
+		while (ok && response.find("MN\r\n") == std::string::npos) {
+			ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+			if (n <= 0) ok = false;
+			else response.append(buffer, static_cast<size_t>(n));
+		}
+		::close(fd);
+		return ok;
+	}
+
+	bool worker(int index, std::chrono::steady_clock::time_point deadline, std::vector<uint32_t>& latencies) {
+		int fd = connect();
+		if (fd < 0) return false;
+		std::mt19937 rng(static_cast<uint32_t>(index) * 7919u + 1);
+		std::string value(static_cast<size_t>(_options.valueSize), 'v');
+		std::string request;
+		std::string response;
+		char buffer[64 * 1024];
+		bool ok = true;
+		while (ok && std::chrono::steady_clock::now() < deadline) {
+			request.clear();
+			for (int i = 0; i < _options.depth; ++i) appendRequest(request, rng, value);
+			auto sentAt = std::chrono::steady_clock::now();
+			ok = sendAll(fd, request);
+			int received = 0;
+			size_t pos = 0;
+			response.clear();
+			while (ok && received < _options.depth) {
+				size_t used = parseResponse(response, pos);
+				if (used > 0) {
+					pos += used;
+					++received;
+					latencies.push_back(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+						std::chrono::steady_clock::now() - sentAt).count()));
+					continue;
+				}
+				ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+				if (n <= 0) ok = false;
+				else response.append(buffer, static_cast<size_t>(n));
+			}
+		}
+		::close(fd);
+		return ok;
+	}
+
+	LoadOptions _options;
+};
+
+void usage() {
+	std::cout <<
+		"usage:\n"
+		"  memcached-lru [--host H] [--port P] [--unix PATH] [--threads N] [--capacity ITEMS] [--shards N]\n"
+		"  memcached-lru --loadgen [--host H] [--port P | --unix PATH] [--connections N] [--depth N]\n"
+		"                [--seconds N] [--keys N] [--value-size N] [--set-ratio R]\n"
+		"  memcached-lru --bench   (server on an ephemeral loopback port plus --loadgen options)\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	std::string host = "127.0.0.1";
+	int port = 11211;
+	std::string unixPath;
+	int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+	int capacity = 1000000;
+	int shards = 64;
+	bool loadgen = false;
+	bool bench = false;
+	LoadOptions load;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : std::string(); };
+		if (arg == "--host") host = load.host = next();
+		else if (arg == "--port") port = load.port = std::atoi(next().c_str());
+		else if (arg == "--unix") unixPath = load.unixPath = next();
+		else if (arg == "--threads") threads = std::atoi(next().c_str());
+		else if (arg == "--capacity") capacity = std::atoi(next().c_str());
+		else if (arg == "--shards") shards = std::atoi(next().c_str());
+		else if (arg == "--loadgen") loadgen = true;
+		else if (arg == "--bench") bench = true;
+		else if (arg == "--connections") load.connections = std::atoi(next().c_str());
+		else if (arg == "--depth") load.depth = std::atoi(next().c_str());
+		else if (arg == "--seconds") load.seconds = std::atoi(next().c_str());
+		else if (arg == "--keys") load.keys = std::atoi(next().c_str());
+		else if (arg == "--value-size") load.valueSize = std::atoi(next().c_str());
+		else if (arg == "--set-ratio") load.setRatio = std::atof(next().c_str());
+		else {
+			usage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+	if (load.connections <= 0 || load.depth <= 0 || load.keys <= 0 || capacity <= 0 || shards <= 0) {
+		usage();
+		return 1;
+	}
+	if (loadgen) {
+		return LoadGenerator(load).run() ? 0 : 1;
+	}
+
+	std::signal(SIGPIPE, SIG_IGN);
+	Store store(capacity, shards);
+	Server server(store, threads);
+	if (bench) {
+		load.unixPath.clear();
+		load.host = "127.0.0.1";
+		load.port = server.listenTcp(load.host, 0);
+		if (load.port < 0) {
+			std::cerr << "cannot listen on loopback" << std::endl;
+			return 1;
+		}
+		server.start();
+		bool ok = LoadGenerator(load).run();
+		server.stop();
+		std::printf("server: %zu items, %llu hits, %llu misses\n", store.size(),
+			static_cast<unsigned long long>(store.stats().getHits.load()), static_cast<unsigned long long>(store.stats().getMisses.load()));
+		return ok ? 0 : 1;
+	}
+
+	if (!unixPath.empty() && !server.listenUnix(unixPath)) {
+		std::cerr << "cannot listen on " << unixPath << std::endl;
+		return 1;
+	}
+	if (port > 0 && server.listenTcp(host, port) < 0) {
+		std::cerr << "cannot listen on " << host << ":" << port << std::endl;
+		return 1;
+	}
+	std::signal(SIGINT, [](int) { g_stopping = true; });
+	std::signal(SIGTERM, [](int) { g_stopping = true; });
+	server.start();
+	std::cout << "listening with " << threads << " event loops, capacity " << capacity << " items" << std::endl;
+	while (!g_stopping.load()) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	server.stop();
+	return 0;
+}
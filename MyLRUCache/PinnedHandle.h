@@ -0,0 +1,174 @@
+#pragma once
+#ifndef PINNEDHANDLE_H
+#define PINNEDHANDLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+
+/**
+* 节点上的 pin 计数与 pin 时记入预算的字节数；计数只在缓存锁内增加，可在锁外减少
+*/
+struct PinState {
+	std::atomic<uint32_t> pins{ 0 };
+	std::atomic<size_t> bytes{ 0 };
+
+	bool pinned() const { return pins.load(std::memory_order_acquire) != 0; }
+};
+
+/****************************************
+PinBudget
+
+被 pin 的条目占用的字节预算，可在多个缓存（多个分片）之间共享。
+同一个条目被多个 handle pin 时只记一次，最后一个 handle 释放时归还。
+****************************************/
+class PinBudget {
+public:
+	struct Stats {
+		size_t limit = 0;
+		size_t pinnedBytes = 0;
+		size_t pinnedEntries = 0;
+		uint64_t pins = 0;
+		uint64_t rejects = 0;		// 超出预算，handle 改为持有值的拷贝
+	};
+
+	explicit PinBudget(size_t maxBytes = std::numeric_limits<size_t>::max()) : _limit(maxBytes) {}
+
+	/**
+	* 在缓存锁内调用：条目已被 pin 时计数加一；否则用 sizeOf() 计算字节数，预算足够才 pin。返回是否 pin 成功
+	*/
+	template<typename SizeOf>
+	bool pin(PinState& state, SizeOf sizeOf) {
+		uint32_t pins = state.pins.load(std::memory_order_acquire);
+		while (true) {
+			if (pins > 0) {
+				if (state.pins.compare_exchange_weak(pins, pins + 1, std::memory_order_acq_rel)) break;
+				continue;
+			}
+			size_t bytes = sizeOf();
+			if (!charge(bytes)) {
+				_rejects.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			state.bytes.store(bytes, std::memory_order_relaxed);
+			// 锁外的释放可能恰好把计数减到 0，这时重新判断
+			if (state.pins.compare_exchange_strong(pins, 1, std::memory_order_acq_rel)) {
+				_entries.fetch_add(1, std::memory_order_relaxed);
+				break;
+			}
+			_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+		}
+		_pins.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/**
+	* 释放一次 pin，不需要持有缓存锁
+	*/
+	void unpin(PinState& state) {
+		if (state.pins.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			_bytes.fetch_sub(state.bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			_entries.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+
+	Stats getStats() const {
+		Stats stats;
+		stats.limit = _limit;
+		stats.pinnedBytes = _bytes.load(std::memory_order_relaxed);
+		stats.pinnedEntries = _entries.load(std::memory_order_relaxed);
+		stats.pins = _pins.load(std::memory_order_relaxed);
+		stats.rejects = _rejects.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+private:
+	bool charge(size_t bytes) {
+		size_t used = _bytes.load(std::memory_order_relaxed);
+		do {
+			if (bytes > _limit || used > _limit - bytes) return false;
+		} while (!_bytes.compare_exchange_weak(used, used + bytes, std::memory_order_relaxed));
+		return true;
+	}
+
+	const size_t _limit;
+	std::atomic<size_t> _bytes{ 0 };
+	std::atomic<size_t> _entries{ 0 };
+	std::atomic<uint64_t> _pins{ 0 };
+	std::atomic<uint64_t> _rejects{ 0 };
+};
+
+/****************************************
+CacheHandle
+
+get 的零拷贝结果：持有缓存节点的引用，通过 value() 直接访问节点中的值。
+pin 成功时条目在 handle 释放之前不会被容量淘汰；put 覆盖或 remove 仍然生效，
+但 handle 看到的始终是取出时的值，节点在最后一个 handle 释放后才析构。
+超出 pin 预算时 handle 改为持有值的拷贝，pinned() 为 false，条目照常参与淘汰。
+handle 只引用节点与预算，可以比缓存活得更久。只能移动，不能拷贝。
+****************************************/
+template<typename Key, typename Value>
+class CacheHandle {
+public:
+	CacheHandle() = default;
+	/**
+	* pin 为空表示没有 pin 成功，这时拷贝一份值
+	*/
+	template<typename Node>
+	CacheHandle(std::shared_ptr<Node> node, const Key& key, const Value& value, PinState* pin, std::shared_ptr<PinBudget> budget)
+		: _key(key), _pin(pin) {
+		if (_pin) {
+			_value = std::shared_ptr<const Value>(std::move(node), &value);
+			_budget = std::move(budget);
+		}
+		else {
+			_value = std::make_shared<const Value>(value);
+		}
+	}
+	~CacheHandle() { release(); }
+
+	CacheHandle(CacheHandle&& other) noexcept
+		: _key(std::move(other._key)), _value(std::move(other._value)), _pin(std::exchange(other._pin, nullptr)), _budget(std::move(other._budget)) {}
+	CacheHandle& operator=(CacheHandle&& other) noexcept {
+		if (this != &other) {
+			release();
+			_key = std::move(other._key);
+			_value = std::move(other._value);
+			_pin = std::exchange(other._pin, nullptr);
+			_budget = std::move(other._budget);
+		}
+		return *this;
+	}
+	CacheHandle(const CacheHandle&) = delete;
+	CacheHandle& operator=(const CacheHandle&) = delete;
+
+	explicit operator bool() const { return _value != nullptr; }
+	bool pinned() const { return _pin != nullptr; }
+	const Key& key() const { return _key; }
+	const Value& value() const { return *_value; }
+	const Value& operator*() const { return *_value; }
+	const Value* operator->() const { return _value.get(); }
+
+	/**
+	* 提前释放，之后 handle 为空
+	*/
+	void release() {
+		if (_pin) {
+			_budget->unpin(*_pin);
+			_pin = nullptr;
+		}
+		_budget.reset();
+		_value.reset();
+	}
+
+private:
+	Key _key{};
+	std::shared_ptr<const Value> _value;
+	PinState* _pin = nullptr;
+	std::shared_ptr<PinBudget> _budget;
+};
+
+#endif // PINNEDHANDLE_H
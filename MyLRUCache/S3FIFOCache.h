@@ -0,0 +1,259 @@
+#pragma once
+#ifndef S3FIFOCACHE_H
+#define S3FIFOCACHE_H
+
+#include "FlatHashMap.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+/****************************************
+FifoRing
+
+定长环形 FIFO，S3FIFOCache 的三个队列都用它实现。非线程安全。
+****************************************/
+template<typename T>
+class FifoRing {
+public:
+	explicit FifoRing(size_t capacity) : _buffer(capacity > 0 ? capacity : 1) {}
+
+	bool empty() const { return _size == 0; }
+	bool full() const { return _size == _buffer.size(); }
+	size_t size() const { return _size; }
+
+	void push(const T& value) {
+		_buffer[(_head + _size) % _buffer.size()] = value;
+		++_size;
+	}
+	T pop() {
+		T value = _buffer[_head];
+		_head = (_head + 1) % _buffer.size();
+		--_size;
+		return value;
+	}
+private:
+	std::vector<T> _buffer;
+	size_t _head = 0;
+	size_t _size = 0;
+};
+
+/****************************************
+S3FIFOCache
+
+S3-FIFO：只用 FIFO 队列的淘汰算法，适合有大量只访问一次的 key 的负载
+	small 队列：约 10% 容量，新 key 先进入这里
+	main  队列：约 90% 容量，条目带 2 位访问计数
+	ghost 队列：只保存从 small 淘汰的 key 的 64 位指纹，数量与 main 相同
+small 出队时，期间被访问过的条目转入 main，否则丢弃并记入 ghost；
+未命中的 key 如果在 ghost 中，说明它很快被再次访问，直接进入 main。
+main 出队时，计数不为 0 的条目计数减 1 后重新入队，否则淘汰。
+命中只对计数做原子加 1，不移动节点，get 只需要共享锁；插入与淘汰持独占锁。
+****************************************/
+template<typename Key, typename Value>
+class S3FIFOCache {
+public:
+	/**
+	* smallRatio 为 small 队列占总容量的比例
+	*/
+	explicit S3FIFOCache(int capacity, double smallRatio = 0.1)
+		: _capacity(capacity > 0 ? static_cast<uint32_t>(capacity) : 0),
+		_smallCapacity(std::max<uint32_t>(1, static_cast<uint32_t>(_capacity * smallRatio))),
+		_slots(std::make_unique<Slot[]>(_capacity)),
+		_small(_capacity),
+		_main(_capacity),
+		_ghost(_capacity > _smallCapacity ? _capacity - _smallCapacity : 1) {
+		_map.reserve(_capacity);
+		_ghost.reserve(_capacity);
+		for (uint32_t i = _capacity; i > 0; --i) _free.push_back(i - 1);
+	}
+
+	bool get(Key key, Value& value) {
+		std::shared_lock<std::shared_mutex> lock(_mutex);
+		auto it = _map.find(key);
+		if (it == _map.end()) {
+			return false;
+		}
+		Slot& slot = _slots[it->second];
+		value = slot.value;
+		// 计数饱和于 3，已饱和时不写，减少热点缓存行的失效
+		uint8_t freq = slot.freq.load(std::memory_order_relaxed);
+		while (freq < kMaxFreq && !slot.freq.compare_exchange_weak(freq, static_cast<uint8_t>(freq + 1), std::memory_order_relaxed)) {
+		}
+		return true;
+	}
+	Value get(Key key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+
+	void put(Key key, Value value) {
+		if (_capacity == 0) return;
+		std::unique_lock<std::shared_mutex> lock(_mutex);
+		auto it = _map.find(key);
+		if (it != _map.end()) {
+			Slot& slot = _slots[it->second];
+			slot.value = value;
+			uint8_t freq = slot.freq.load(std::memory_order_relaxed);
+			if (freq < kMaxFreq) slot.freq.store(static_cast<uint8_t>(freq + 1), std::memory_order_relaxed);
+			return;
+		}
+		while (_map.size() >= _capacity) {
+			evict();
+		}
+		uint32_t index = _free.back();
+		_free.pop_back();
+		Slot& slot = _slots[index];
+		slot.key = key;
+		slot.value = value;
+		slot.freq.store(0, std::memory_order_relaxed);
+		if (_ghost.contains(fingerprint(key))) {
+			_main.push(index);
+		}
+		else {
+			_small.push(index);
+		}
+		_map[key] = index;
+	}
+
+	size_t size() {
+		std::shared_lock<std::shared_mutex> lock(_mutex);
+		return _map.size();
+	}
+
+private:
+	static constexpr uint8_t kMaxFreq = 3;
+
+	struct Slot {
+		Key key{};
+		Value value{};
+		std::atomic<uint8_t> freq{ 0 };
+	};
+
+	/**
+	* ghost 队列：指纹环形队列 + 指纹出现次数表，同一指纹可以在队列中出现多次
+	*/
+	class GhostQueue {
+	public:
+		explicit GhostQueue(size_t capacity) : _ring(capacity) {}
+		bool contains(uint64_t fp) const { return _counts.find(fp) != _counts.end(); }
+		void push(uint64_t fp) {
+			if (_ring.full()) {
+				uint64_t old = _ring.pop();
+				auto it = _counts.find(old);
+				if (it != _counts.end() && --it->second == 0) _counts.erase(it);
+			}
+			_ring.push(fp);
+			++_counts[fp];
+		}
+		void reserve(size_t count) { _counts.reserve(count); }
+	private:
+		FifoRing<uint64_t> _ring;
+		FlatHashMap<uint64_t, uint32_t> _counts;
+	};
+
+	static uint64_t fingerprint(const Key& key) {
+		uint64_t h = static_cast<uint64_t>(std::hash<Key>()(key));
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDull;
+		h ^= h >> 33;
+		return h;
+	}
+
+	/**
+	* small 队列达到比例时从 small 淘汰，否则从 main 淘汰
+	*/
+	void evict() {
+		if (_small.size() >= _smallCapacity || _main.empty()) {
+			evictSmall();
+		}
+		else {
+			evictMain();
+		}
+	}
+
+	void evictSmall() {
+		while (!_small.empty()) {
+			uint32_t index = _small.pop();
+			Slot& slot = _slots[index];
+			if (slot.freq.load(std::memory_order_relaxed) > 0) {
+				// 在 small 中被访问过，转入 main，计数重新开始
+				slot.freq.store(0, std::memory_order_relaxed);
+				_main.push(index);
+				continue;
+			}
+			_ghost.push(fingerprint(slot.key));
+			release(index);
+			return;
+		}
+		// small 中的条目全部转入了 main，此时从 main 淘汰
+		evictMain();
+	}
+
+	void evictMain() {
+		while (!_main.empty()) {
+			uint32_t index = _main.pop();
+			Slot& slot = _slots[index];
+			uint8_t freq = slot.freq.load(std::memory_order_relaxed);
+			if (freq > 0) {
+				slot.freq.store(static_cast<uint8_t>(freq - 1), std::memory_order_relaxed);
+				_main.push(index);
+				continue;
+			}
+			release(index);
+			return;
+		}
+	}
+
+	void release(uint32_t index) {
+		_map.erase(_slots[index].key);
+		_free.push_back(index);
+	}
+
+	std::shared_mutex _mutex;
+	uint32_t _capacity;
+	uint32_t _smallCapacity;
+	std::unique_ptr<Slot[]> _slots;
+	std::vector<uint32_t> _free;
+	FifoRing<uint32_t> _small;
+	FifoRing<uint32_t> _main;
+	GhostQueue _ghost;
+	FlatHashMap<Key, uint32_t> _map;
+};
+
+/****************************************
+HashS3FIFOCache
+
+按 key 哈希分片的 S3FIFOCache
+****************************************/
+template<typename Key, typename Value>
+class HashS3FIFOCache {
+private:
+	int _capacity;
+	int _sliceNum;
+	std::vector<std::unique_ptr<S3FIFOCache<Key, Value>>> _slices;
+public:
+	HashS3FIFOCache(int capacity, int sliceNum) : _capacity(capacity), _sliceNum(sliceNum) {
+		for (int i = 0; i < _sliceNum; ++i) {
+			_slices.push_back(std::make_unique<S3FIFOCache<Key, Value>>(_capacity / _sliceNum));
+		}
+	}
+	bool get(Key key, Value& value) {
+		return _slices[std::hash<Key>()(key) % _sliceNum]->get(key, value);
+	}
+	Value get(Key key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+	void put(Key key, Value value) {
+		_slices[std::hash<Key>()(key) % _sliceNum]->put(key, value);
+	}
+};
+
+#endif // S3FIFOCACHE_H
@@ -0,0 +1,249 @@
+#pragma once
+#ifndef SAMPLEDLRUCACHE_H
+#define SAMPLEDLRUCACHE_H
+
+#include "FlatHashMap.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+/****************************************
+SampledLRUCache
+
+Redis 风格的近似 LRU，面向上亿条目的缓存：
+	条目紧凑地存放在预先分配的数组里，没有链表指针，删除时把最后一个条目搬进空洞；
+	每个条目带一个 24 位的粗粒度访问时钟，命中时只在共享锁下写入当前时钟，不移动任何节点；
+	淘汰时随机抽取 samples 个条目，按空闲时间放入一个小的候选池，淘汰池中空闲最久的条目。
+	候选池跨轮次保留，之前抽到的好候选下一轮仍可被选中，少量样本也能接近精确 LRU 的命中率。
+时钟按写入新 key 的次数推进，每 tickInterval 次加一，tickInterval 随容量增大，
+使一个容量周期内有约 2^20 个刻度，24 位时钟大约 16 个容量周期才回绕一次。
+****************************************/
+template<typename Key, typename Value>
+class SampledLRUCache {
+public:
+	/**
+	* samples 为每轮抽样数，poolSize 为候选池大小，为 0 时每轮只在本次样本中选
+	*/
+	explicit SampledLRUCache(int capacity, int samples = 5, int poolSize = 16)
+		: _capacity(capacity > 0 ? static_cast<uint32_t>(capacity) : 0),
+		_samples(samples > 0 ? samples : 1),
+		_poolSize(poolSize > 0 ? static_cast<size_t>(poolSize) : 0),
+		_tickInterval(std::max<uint32_t>(1, _capacity >> 20)),
+		_slots(std::make_unique<Slot[]>(_capacity)) {
+		_map.reserve(_capacity);
+		_pool.reserve(_poolSize + static_cast<size_t>(_samples));
+	}
+
+	bool get(Key key, Value& value) {
+		std::shared_lock<std::shared_mutex> lock(_mutex);
+		auto it = _map.find(key);
+		if (it == _map.end()) {
+			return false;
+		}
+		Slot& slot = _slots[it->second];
+		value = slot.value;
+		// 时钟未变时不写，避免热点条目所在的缓存行在核间反复失效
+		uint32_t now = _clock.load(std::memory_order_relaxed);
+		if (slot.clock.load(std::memory_order_relaxed) != now) {
+			slot.clock.store(now, std::memory_order_relaxed);
+		}
+		return true;
+	}
+	Value get(Key key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+
+	void put(Key key, Value value) {
+		if (_capacity == 0) return;
+		std::unique_lock<std::shared_mutex> lock(_mutex);
+		auto it = _map.find(key);
+		if (it != _map.end()) {
+			Slot& slot = _slots[it->second];
+			slot.value = value;
+			slot.clock.store(_clock.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			return;
+		}
+		if (_size == _capacity) {
+			evict();
+		}
+		if (++_sinceTick >= _tickInterval) {
+			_sinceTick = 0;
+			_clock.store((_clock.load(std::memory_order_relaxed) + 1) & kClockMask, std::memory_order_relaxed);
+		}
+		uint32_t index = _size++;
+		Slot& slot = _slots[index];
+		slot.key = key;
+		slot.value = value;
+		slot.clock.store(_clock.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		_map[key] = index;
+	}
+
+	bool remove(Key key) {
+		std::unique_lock<std::shared_mutex> lock(_mutex);
+		auto it = _map.find(key);
+		if (it == _map.end()) return false;
+		uint32_t index = it->second;
+		_map.erase(it);
+		erase(index);
+		return true;
+	}
+
+	size_t size() {
+		std::shared_lock<std::shared_mutex> lock(_mutex);
+		return _size;
+	}
+	int getCapacity() const { return static_cast<int>(_capacity); }
+	/**
+	* 每个条目在槽位数组中占用的字节数（不含哈希索引）
+	*/
+	static constexpr size_t slotBytes() { return sizeof(Slot); }
+
+private:
+	static constexpr uint32_t kClockMask = (1u << 24) - 1;
+
+	struct Slot {
+		Key key{};
+		Value value{};
+		// 低 24 位为最近访问时的时钟
+		std::atomic<uint32_t> clock{ 0 };
+	};
+	struct Candidate {
+		uint32_t index;
+		uint32_t clock;		// 抽样时的时钟，之后被访问过则失效
+		uint32_t idle;
+		Key key;
+	};
+
+	uint32_t idleOf(uint32_t clock) const {
+		return (_clock.load(std::memory_order_relaxed) - clock) & kClockMask;
+	}
+
+	uint32_t nextRandom() {
+		_rng ^= _rng << 13;
+		_rng ^= _rng >> 7;
+		_rng ^= _rng << 17;
+		return static_cast<uint32_t>(_rng >> 32);
+	}
+
+	/**
+	* 候选是否仍然指向同一个 key，且抽样后没有被访问过
+	*/
+	bool stillValid(const Candidate& candidate) const {
+		return candidate.index < _size && _slots[candidate.index].key == candidate.key
+			&& _slots[candidate.index].clock.load(std::memory_order_relaxed) == candidate.clock;
+	}
+
+	/**
+	* 抽样补充候选池，池内按空闲时间升序，同一 key 只保留一份，超出容量时丢掉空闲最短的
+	*/
+	void sampleIntoPool() {
+		for (int i = 0; i < _samples; ++i) {
+			uint32_t index = nextRandom() % _size;
+			const Slot& slot = _slots[index];
+			uint32_t clock = slot.clock.load(std::memory_order_relaxed);
+			Candidate candidate{ index, clock, idleOf(clock), slot.key };
+			auto same = std::find_if(_pool.begin(), _pool.end(), [&candidate](const Candidate& c) { return c.key == candidate.key; });
+			if (same != _pool.end()) _pool.erase(same);
+			auto pos = std::upper_bound(_pool.begin(), _pool.end(), candidate.idle,
+				[](uint32_t idle, const Candidate& c) { return idle < c.idle; });
+			_pool.insert(pos, candidate);
+		}
+		size_t keep = std::max<size_t>(_poolSize, 1);
+		if (_pool.size() > keep) _pool.erase(_pool.begin(), _pool.begin() + static_cast<std::ptrdiff_t>(_pool.size() - keep));
+	}
+
+	/**
+	* 淘汰候选池中空闲最久且仍然有效的条目；过期的候选丢弃，池空时重新抽样
+	*/
+	void evict() {
+		while (true) {
+			if (_poolSize == 0) _pool.clear();
+			sampleIntoPool();
+			while (!_pool.empty()) {
+				Candidate best = _pool.back();
+				_pool.pop_back();
+				if (!stillValid(best)) continue;
+				_map.erase(best.key);
+				erase(best.index);
+				return;
+			}
+		}
+	}
+
+	/**
+	* 释放槽位：把最后一个条目搬进来，保持条目紧凑，抽样只需在 [0, size) 中取下标
+	*/
+	void erase(uint32_t index) {
+		uint32_t last = --_size;
+		if (index != last) {
+			Slot& hole = _slots[index];
+			Slot& moved = _slots[last];
+			hole.key = moved.key;
+			hole.value = moved.value;
+			hole.clock.store(moved.clock.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			_map[hole.key] = index;
+		}
+		_slots[last].key = Key{};
+		_slots[last].value = Value{};
+	}
+
+	std::shared_mutex _mutex;
+	uint32_t _capacity;
+	int _samples;
+	size_t _poolSize;
+	uint32_t _tickInterval;
+	uint32_t _sinceTick = 0;
+	uint32_t _size = 0;
+	std::atomic<uint32_t> _clock{ 0 };
+	uint64_t _rng = 0x9E3779B97F4A7C15ull;
+	std::unique_ptr<Slot[]> _slots;
+	FlatHashMap<Key, uint32_t> _map;
+	std::vector<Candidate> _pool;
+};
+
+/****************************************
+HashSampledLRUCache
+
+按 key 哈希分片的 SampledLRUCache，命中只持分片的共享锁
+****************************************/
+template<typename Key, typename Value>
+class HashSampledLRUCache {
+private:
+	int _capacity;
+	int _sliceNum;
+	std::vector<std::unique_ptr<SampledLRUCache<Key, Value>>> _slices;
+public:
+	HashSampledLRUCache(int capacity, int sliceNum, int samples = 5, int poolSize = 16) : _capacity(capacity), _sliceNum(sliceNum) {
+		for (int i = 0; i < _sliceNum; ++i) {
+			_slices.push_back(std::make_unique<SampledLRUCache<Key, Value>>(_capacity / _sliceNum, samples, poolSize));
+		}
+	}
+	bool get(Key key, Value& value) {
+		return _slices[std::hash<Key>()(key) % _sliceNum]->get(key, value);
+	}
+	Value get(Key key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+	void put(Key key, Value value) {
+		_slices[std::hash<Key>()(key) % _sliceNum]->put(key, value);
+	}
+	bool remove(Key key) {
+		return _slices[std::hash<Key>()(key) % _sliceNum]->remove(key);
+	}
+	size_t size() {
+		size_t total = 0;
+		for (auto& slice : _slices) total += slice->size();
+		return total;
+	}
+};
+
+#endif // SAMPLEDLRUCACHE_H
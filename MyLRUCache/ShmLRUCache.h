@@ -0,0 +1,471 @@
+#pragma once
+#ifndef SHMLRUCACHE_H
+#define SHMLRUCACHE_H
+
+// 依赖 POSIX 共享内存与进程间 robust mutex，Windows 下不提供
+#if !defined(_WIN32)
+#define SHMLRUCACHE_SUPPORTED 1
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/****************************************
+ShmLRUCache
+
+放在 POSIX 共享内存段中的分片 LRU 缓存，同一台机器上的多个 worker 进程共享同一份数据：
+	段内只保存下标与偏移量，不含指针，各进程映射到不同地址也能直接使用；
+	每个分片有固定大小的条目槽位（slab）、链式哈希桶和 LRU 双向链表，全部在创建时一次分配；
+	每个分片一把进程间共享的 robust mutex，持锁进程崩溃后下一个加锁者得到 EOWNERDEAD，
+	若该分片正处于修改中（dirty）就把它清空重建，然后标记锁恢复可用，不会永久锁死。
+Key/Value 必须可平凡拷贝且没有填充字节：按字节哈希和比较，不同进程（甚至不同程序）得到相同结果。
+第一个打开者创建并初始化段，之后的打开者校验布局一致后附着；段在调用 unlink 之前一直存在。
+****************************************/
+template<typename Key, typename Value>
+class ShmLRUCache {
+	static_assert(std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Value>,
+		"ShmLRUCache stores raw bytes in shared memory");
+	static_assert(std::has_unique_object_representations_v<Key>,
+		"ShmLRUCache hashes key bytes, keys must not contain padding");
+public:
+	struct Stats {
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+		uint64_t ownerDeaths = 0;	// 加锁时发现上一个持锁进程已经退出
+		uint64_t shardResets = 0;	// 其中分片处于修改中、被清空重建的次数
+	};
+
+	/**
+	* 打开名为 name 的共享内存缓存，不存在时按 capacity/shardNum 创建；
+	* 已存在但布局（容量、分片数、Key/Value 大小）不同时打开失败，isOpen() 返回 false
+	*/
+	ShmLRUCache(const std::string& name, int capacity, int shardNum) {
+		if (capacity <= 0 || shardNum <= 0) return;
+		_name = name.empty() || name[0] != '/' ? "/" + name : name;
+		uint32_t perShard = static_cast<uint32_t>((capacity + shardNum - 1) / shardNum);
+		size_t total = layoutSize(static_cast<uint32_t>(shardNum), perShard);
+		int fd = ::shm_open(_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd >= 0) {
+			if (::ftruncate(fd, static_cast<off_t>(total)) != 0 || !map(fd, total)) {
+				::close(fd);
+				::shm_unlink(_name.c_str());
+				return;
+			}
+			::close(fd);
+			initialize(static_cast<uint32_t>(capacity), static_cast<uint32_t>(shardNum), perShard, total);
+			return;
+		}
+		if (errno != EEXIST) return;
+		fd = ::shm_open(_name.c_str(), O_RDWR, 0600);
+		if (fd < 0) return;
+		bool ok = waitForSize(fd, total) && map(fd, total);
+		::close(fd);
+		if (!ok || !waitReady() || !matches(static_cast<uint32_t>(capacity), static_cast<uint32_t>(shardNum), total)) {
+			unmap();
+		}
+	}
+	~ShmLRUCache() { unmap(); }
+	ShmLRUCache(const ShmLRUCache&) = delete;
+	ShmLRUCache& operator=(const ShmLRUCache&) = delete;
+
+	/**
+	* 删除共享内存段的名字；已经附着的进程仍可继续使用，全部退出后内存才释放
+	*/
+	static bool unlink(const std::string& name) {
+		std::string path = name.empty() || name[0] != '/' ? "/" + name : name;
+		return ::shm_unlink(path.c_str()) == 0;
+	}
+
+	bool isOpen() const { return _header != nullptr; }
+	int getCapacity() const { return _header ? static_cast<int>(_header->capacity) : 0; }
+	int getShardNum() const { return _header ? static_cast<int>(_header->shardNum) : 0; }
+
+	bool get(const Key& key, Value& value) {
+		if (!_header) return false;
+		uint64_t h = hashOf(key);
+		Shard& shard = shardFor(h);
+		ShardLock lock(*this, shard);
+		if (!lock.locked()) return false;
+		uint32_t index = find(shard, key, h);
+		if (index == kNull) {
+			++shard.misses;
+			return false;
+		}
+		Entry* entries = entriesOf(shard);
+		value = entries[index].value;
+		beginModify(shard);
+		moveToHead(shard, index);
+		endModify(shard);
+		++shard.hits;
+		return true;
+	}
+	Value get(const Key& key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+
+	void put(const Key& key, const Value& value) {
+		if (!_header) return;
+		uint64_t h = hashOf(key);
+		Shard& shard = shardFor(h);
+		ShardLock lock(*this, shard);
+		if (!lock.locked()) return;
+		Entry* entries = entriesOf(shard);
+		beginModify(shard);
+		uint32_t index = find(shard, key, h);
+		if (index != kNull) {
+			entries[index].value = value;
+			moveToHead(shard, index);
+			endModify(shard);
+			return;
+		}
+		if (shard.freeHead != kNull) {
+			index = shard.freeHead;
+			shard.freeHead = entries[index].next;
+			++shard.size;
+		}
+		else {
+			// 槽位已满：复用最久未访问条目的槽位
+			index = shard.tail;
+			unlinkBucket(shard, index);
+			unlinkList(shard, index);
+			++shard.evictions;
+		}
+		Entry& entry = entries[index];
+		entry.key = key;
+		entry.value = value;
+		entry.hash = h;
+		uint32_t* buckets = bucketsOf(shard);
+		uint32_t& bucket = buckets[h & shard.bucketMask];
+		entry.chain = bucket;
+		bucket = index;
+		linkHead(shard, index);
+		endModify(shard);
+	}
+
+	bool remove(const Key& key) {
+		if (!_header) return false;
+		uint64_t h = hashOf(key);
+		Shard& shard = shardFor(h);
+		ShardLock lock(*this, shard);
+		if (!lock.locked()) return false;
+		uint32_t index = find(shard, key, h);
+		if (index == kNull) return false;
+		beginModify(shard);
+		unlinkBucket(shard, index);
+		unlinkList(shard, index);
+		entriesOf(shard)[index].next = shard.freeHead;
+		shard.freeHead = index;
+		--shard.size;
+		endModify(shard);
+		return true;
+	}
+
+	void clear() {
+		if (!_header) return;
+		for (uint32_t i = 0; i < _header->shardNum; ++i) {
+			Shard& shard = shards()[i];
+			ShardLock lock(*this, shard);
+			if (lock.locked()) resetShard(shard);
+		}
+	}
+
+	size_t size() {
+		size_t total = 0;
+		forEachShard([&total](Shard& shard) { total += shard.size; });
+		return total;
+	}
+	/**
+	* 所有进程累计的统计
+	*/
+	Stats getStats() {
+		Stats stats;
+		forEachShard([&stats](Shard& shard) {
+			stats.hits += shard.hits;
+			stats.misses += shard.misses;
+			stats.evictions += shard.evictions;
+			stats.ownerDeaths += shard.ownerDeaths;
+			stats.shardResets += shard.shardResets;
+		});
+		return stats;
+	}
+
+private:
+	static constexpr uint32_t kNull = UINT32_MAX;
+	static constexpr uint32_t kMagic = 0x4C52554Du;	// "MURL"
+	static constexpr uint32_t kVersion = 1;
+	static constexpr uint32_t kStateReady = 2;
+
+	struct Header {
+		std::atomic<uint32_t> state;
+		uint32_t magic;
+		uint32_t version;
+		uint32_t shardNum;
+		uint32_t capacity;
+		uint32_t perShard;
+		uint32_t keySize;
+		uint32_t valueSize;
+		uint64_t totalSize;
+	};
+	struct alignas(64) Shard {
+		pthread_mutex_t mutex;
+		// 链表：head 为最近访问，tail 为最久未访问；空闲槽位通过 next 串成单链表
+		uint32_t head;
+		uint32_t tail;
+		uint32_t freeHead;
+		uint32_t size;
+		uint32_t capacity;
+		uint32_t bucketMask;
+		// 修改链表/哈希桶期间为 1，持锁进程在此期间退出说明分片可能不一致；
+		// 原子类型与 uint32_t 大小相同，只用来约束它与链表写入之间的顺序
+		std::atomic<uint32_t> dirty;
+		// 相对段起始地址的偏移
+		uint64_t bucketsOffset;
+		uint64_t entriesOffset;
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t evictions;
+		uint64_t ownerDeaths;
+		uint64_t shardResets;
+	};
+	struct Entry {
+		Key key;
+		Value value;
+		uint64_t hash;
+		uint32_t prev;
+		uint32_t next;
+		uint32_t chain;
+	};
+	static_assert(std::atomic<uint32_t>::is_always_lock_free && sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+		"shared-memory state and dirty flags must be lock free");
+
+	/**
+	* 加锁；上一个持锁进程已退出时修复分片并恢复锁
+	*/
+	class ShardLock {
+	public:
+		ShardLock(ShmLRUCache& cache, Shard& shard) : _shard(shard) {
+			int rc = ::pthread_mutex_lock(&shard.mutex);
+			if (rc == EOWNERDEAD) {
+				++shard.ownerDeaths;
+				if (shard.dirty.load(std::memory_order_acquire)) {
+					cache.resetShard(shard);
+					++shard.shardResets;
+				}
+				::pthread_mutex_consistent(&shard.mutex);
+				rc = 0;
+			}
+			_locked = rc == 0;
+		}
+		~ShardLock() {
+			if (_locked) ::pthread_mutex_unlock(&_shard.mutex);
+		}
+		bool locked() const { return _locked; }
+	private:
+		Shard& _shard;
+		bool _locked = false;
+	};
+
+	static size_t alignUp(size_t value) { return (value + 63) / 64 * 64; }
+	static uint32_t bucketCountFor(uint32_t perShard) {
+		uint32_t buckets = 1;
+		while (buckets < perShard * 2) buckets <<= 1;
+		return buckets;
+	}
+	static size_t layoutSize(uint32_t shardNum, uint32_t perShard) {
+		size_t size = alignUp(sizeof(Header)) + alignUp(sizeof(Shard) * shardNum);
+		size_t perShardBytes = alignUp(sizeof(uint32_t) * bucketCountFor(perShard)) + alignUp(sizeof(Entry) * perShard);
+		return size + perShardBytes * shardNum;
+	}
+
+	/**
+	* 按字节哈希（FNV-1a 后再混合），与进程和编译器无关
+	*/
+	static uint64_t hashOf(const Key& key) {
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&key);
+		uint64_t h = 0xCBF29CE484222325ull;
+		for (size_t i = 0; i < sizeof(Key); ++i) {
+			h = (h ^ bytes[i]) * 0x100000001B3ull;
+		}
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDull;
+		h ^= h >> 33;
+		return h;
+	}
+
+	Shard* shards() const { return reinterpret_cast<Shard*>(_base + alignUp(sizeof(Header))); }
+	Shard& shardFor(uint64_t h) const { return shards()[(h >> 40) % _header->shardNum]; }
+	uint32_t* bucketsOf(Shard& shard) const { return reinterpret_cast<uint32_t*>(_base + shard.bucketsOffset); }
+	Entry* entriesOf(Shard& shard) const { return reinterpret_cast<Entry*>(_base + shard.entriesOffset); }
+
+	template<typename Fn>
+	void forEachShard(Fn fn) {
+		if (!_header) return;
+		for (uint32_t i = 0; i < _header->shardNum; ++i) {
+			Shard& shard = shards()[i];
+			ShardLock lock(*this, shard);
+			if (lock.locked()) fn(shard);
+		}
+	}
+
+	uint32_t find(Shard& shard, const Key& key, uint64_t h) const {
+		Entry* entries = entriesOf(shard);
+		for (uint32_t index = bucketsOf(shard)[h & shard.bucketMask]; index != kNull; index = entries[index].chain) {
+			if (entries[index].hash == h && std::memcmp(&entries[index].key, &key, sizeof(Key)) == 0) return index;
+		}
+		return kNull;
+	}
+
+	// ---- 链表与哈希桶，调用者持锁 ----
+	void linkHead(Shard& shard, uint32_t index) {
+		Entry* entries = entriesOf(shard);
+		entries[index].prev = kNull;
+		entries[index].next = shard.head;
+		if (shard.head != kNull) entries[shard.head].prev = index;
+		else shard.tail = index;
+		shard.head = index;
+	}
+	void unlinkList(Shard& shard, uint32_t index) {
+		Entry* entries = entriesOf(shard);
+		Entry& entry = entries[index];
+		if (entry.prev != kNull) entries[entry.prev].next = entry.next;
+		else shard.head = entry.next;
+		if (entry.next != kNull) entries[entry.next].prev = entry.prev;
+		else shard.tail = entry.prev;
+	}
+	void moveToHead(Shard& shard, uint32_t index) {
+		if (shard.head == index) return;
+		unlinkList(shard, index);
+		linkHead(shard, index);
+	}
+	void unlinkBucket(Shard& shard, uint32_t index) {
+		Entry* entries = entriesOf(shard);
+		uint32_t* slot = &bucketsOf(shard)[entries[index].hash & shard.bucketMask];
+		while (*slot != index) slot = &entries[*slot].chain;
+		*slot = entries[index].chain;
+	}
+
+	/**
+	* 清空分片：所有槽位放回空闲链表，哈希桶置空；统计保留
+	*/
+	void resetShard(Shard& shard) {
+		Entry* entries = entriesOf(shard);
+		uint32_t* buckets = bucketsOf(shard);
+		for (uint32_t i = 0; i <= shard.bucketMask; ++i) buckets[i] = kNull;
+		for (uint32_t i = 0; i < shard.capacity; ++i) {
+			entries[i].next = i + 1 < shard.capacity ? i + 1 : kNull;
+		}
+		shard.freeHead = shard.capacity > 0 ? 0 : kNull;
+		shard.head = kNull;
+		shard.tail = kNull;
+		shard.size = 0;
+		endModify(shard);
+	}
+
+	/**
+	* dirty 置 1 之后才写链表与哈希桶，全部写完之后才清 0；编译器与处理器都不能把这些写入移到标记之外，
+	* 否则持锁进程在修改中途退出时，恢复者可能看到已清 0 的标记和改了一半的分片
+	*/
+	static void beginModify(Shard& shard) {
+		shard.dirty.store(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+	static void endModify(Shard& shard) {
+		shard.dirty.store(0, std::memory_order_release);
+	}
+
+	void initialize(uint32_t capacity, uint32_t shardNum, uint32_t perShard, size_t total) {
+		_header->magic = kMagic;
+		_header->version = kVersion;
+		_header->shardNum = shardNum;
+		_header->capacity = capacity;
+		_header->perShard = perShard;
+		_header->keySize = sizeof(Key);
+		_header->valueSize = sizeof(Value);
+		_header->totalSize = total;
+		pthread_mutexattr_t attr;
+		::pthread_mutexattr_init(&attr);
+		::pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+		::pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+		uint32_t buckets = bucketCountFor(perShard);
+		size_t offset = alignUp(sizeof(Header)) + alignUp(sizeof(Shard) * shardNum);
+		for (uint32_t i = 0; i < shardNum; ++i) {
+			Shard* shard = new (shards() + i) Shard();
+			::pthread_mutex_init(&shard->mutex, &attr);
+			shard->capacity = perShard;
+			shard->bucketMask = buckets - 1;
+			shard->bucketsOffset = offset;
+			offset += alignUp(sizeof(uint32_t) * buckets);
+			shard->entriesOffset = offset;
+			offset += alignUp(sizeof(Entry) * perShard);
+			resetShard(*shard);
+		}
+		::pthread_mutexattr_destroy(&attr);
+		_header->state.store(kStateReady, std::memory_order_release);
+	}
+
+	bool matches(uint32_t capacity, uint32_t shardNum, size_t total) const {
+		return _header->magic == kMagic && _header->version == kVersion
+			&& _header->capacity == capacity && _header->shardNum == shardNum
+			&& _header->keySize == sizeof(Key) && _header->valueSize == sizeof(Value)
+			&& _header->totalSize == total;
+	}
+
+	/**
+	* 创建者可能还没有 ftruncate 或初始化完，附着时最多等待一秒
+	*/
+	static bool waitForSize(int fd, size_t total) {
+		for (int i = 0; i < 1000; ++i) {
+			struct stat st;
+			if (::fstat(fd, &st) != 0) return false;
+			if (static_cast<size_t>(st.st_size) >= total) return static_cast<size_t>(st.st_size) == total;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return false;
+	}
+	bool waitReady() const {
+		for (int i = 0; i < 1000; ++i) {
+			if (_header->state.load(std::memory_order_acquire) == kStateReady) return true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return false;
+	}
+
+	bool map(int fd, size_t total) {
+		void* base = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (base == MAP_FAILED) return false;
+		_base = static_cast<char*>(base);
+		_mappedSize = total;
+		_header = reinterpret_cast<Header*>(_base);
+		return true;
+	}
+	void unmap() {
+		if (_base) ::munmap(_base, _mappedSize);
+		_base = nullptr;
+		_header = nullptr;
+		_mappedSize = 0;
+	}
+
+	std::string _name;
+	char* _base = nullptr;
+	size_t _mappedSize = 0;
+	Header* _header = nullptr;
+};
+
+#endif // !_WIN32
+
+#endif // SHMLRUCACHE_H
@@ -0,0 +1,184 @@
+#pragma once
+#ifndef SIEVECACHE_H
+#define SIEVECACHE_H
+
+#include "FlatHashMap.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+/****************************************
+SieveCache
+
+基于 SIEVE 算法的缓存：条目按插入顺序排成 FIFO 队列，命中时只把条目的 visited 位置 1，
+不移动节点，因此 get 只需要共享锁。淘汰时指针 hand 从队尾（最老）向队头扫描，
+清掉途经条目的 visited 位，淘汰第一个未被访问的条目，扫到队头后回到队尾。
+条目存放在预先分配的数组里，用 32 位下标串成双向链表；插入与淘汰持独占锁。
+****************************************/
+template<typename Key, typename Value>
+class SieveCache {
+public:
+	explicit SieveCache(int capacity)
+		: _capacity(capacity > 0 ? static_cast<uint32_t>(capacity) : 0),
+		_slots(std::make_unique<Slot[]>(_capacity)) {
+		_map.reserve(_capacity);
+	}
+
+	bool get(Key key, Value& value) {
+		std::shared_lock<std::shared_mutex> lock(_mutex);
+		auto it = _map.find(key);
+		if (it == _map.end()) {
+			return false;
+		}
+		Slot& slot = _slots[it->second];
+		value = slot.value;
+		// 已置位时不再写，避免热点条目所在的缓存行在核间反复失效
+		if (!slot.visited.load(std::memory_order_relaxed)) {
+			slot.visited.store(true, std::memory_order_relaxed);
+		}
+		return true;
+	}
+	Value get(Key key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+
+	void put(Key key, Value value) {
+		if (_capacity == 0) return;
+		std::unique_lock<std::shared_mutex> lock(_mutex);
+		auto it = _map.find(key);
+		if (it != _map.end()) {
+			Slot& slot = _slots[it->second];
+			slot.value = value;
+			slot.visited.store(true, std::memory_order_relaxed);
+			return;
+		}
+		uint32_t index;
+		if (_free != kNull) {
+			index = _free;
+			_free = _slots[index].next;
+		}
+		else if (_used < _capacity) {
+			index = _used++;
+		}
+		else {
+			index = evict();
+		}
+		Slot& slot = _slots[index];
+		slot.key = key;
+		slot.value = value;
+		slot.visited.store(false, std::memory_order_relaxed);
+		linkHead(index);
+		_map[key] = index;
+	}
+
+	bool remove(Key key) {
+		std::unique_lock<std::shared_mutex> lock(_mutex);
+		auto it = _map.find(key);
+		if (it == _map.end()) return false;
+		uint32_t index = it->second;
+		_map.erase(it);
+		unlink(index);
+		// 空出的槽位挂到空闲链表，下次插入复用
+		_slots[index].next = _free;
+		_free = index;
+		return true;
+	}
+
+	size_t size() {
+		std::shared_lock<std::shared_mutex> lock(_mutex);
+		return _map.size();
+	}
+
+private:
+	static constexpr uint32_t kNull = UINT32_MAX;
+
+	struct Slot {
+		Key key{};
+		Value value{};
+		uint32_t prev = kNull;
+		uint32_t next = kNull;
+		std::atomic<bool> visited{ false };
+	};
+
+	/**
+	* 从 hand 开始向队头扫描，返回被淘汰条目空出的槽位
+	*/
+	uint32_t evict() {
+		uint32_t hand = _hand != kNull ? _hand : _tail;
+		while (_slots[hand].visited.load(std::memory_order_relaxed)) {
+			_slots[hand].visited.store(false, std::memory_order_relaxed);
+			hand = _slots[hand].prev != kNull ? _slots[hand].prev : _tail;
+		}
+		_hand = _slots[hand].prev;
+		_map.erase(_slots[hand].key);
+		unlink(hand);
+		return hand;
+	}
+
+	// ---- 双向链表：_head 为最新插入，_tail 为最老 ----
+	void linkHead(uint32_t index) {
+		_slots[index].prev = kNull;
+		_slots[index].next = _head;
+		if (_head != kNull) _slots[_head].prev = index;
+		else _tail = index;
+		_head = index;
+	}
+	void unlink(uint32_t index) {
+		Slot& slot = _slots[index];
+		if (_hand == index) _hand = slot.prev;
+		if (slot.prev != kNull) _slots[slot.prev].next = slot.next;
+		else _head = slot.next;
+		if (slot.next != kNull) _slots[slot.next].prev = slot.prev;
+		else _tail = slot.prev;
+	}
+
+	std::shared_mutex _mutex;
+	uint32_t _capacity;
+	uint32_t _used = 0;
+	uint32_t _head = kNull;
+	uint32_t _tail = kNull;
+	uint32_t _hand = kNull;
+	uint32_t _free = kNull;
+	std::unique_ptr<Slot[]> _slots;
+	FlatHashMap<Key, uint32_t> _map;
+};
+
+/****************************************
+HashSieveCache
+
+按 key 哈希分片的 SieveCache，插入与淘汰的独占锁只影响一个分片
+****************************************/
+template<typename Key, typename Value>
+class HashSieveCache {
+private:
+	int _capacity;
+	int _sliceNum;
+	std::vector<std::unique_ptr<SieveCache<Key, Value>>> _slices;
+public:
+	HashSieveCache(int capacity, int sliceNum) : _capacity(capacity), _sliceNum(sliceNum) {
+		for (int i = 0; i < _sliceNum; ++i) {
+			_slices.push_back(std::make_unique<SieveCache<Key, Value>>(_capacity / _sliceNum));
+		}
+	}
+	bool get(Key key, Value& value) {
+		return _slices[std::hash<Key>()(key) % _sliceNum]->get(key, value);
+	}
+	Value get(Key key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+	void put(Key key, Value value) {
+		_slices[std::hash<Key>()(key) % _sliceNum]->put(key, value);
+	}
+	bool remove(Key key) {
+		return _slices[std::hash<Key>()(key) % _sliceNum]->remove(key);
+	}
+};
+
+#endif // SIEVECACHE_H
@@ -0,0 +1,140 @@
+#pragma once
+#ifndef SLABARENA_H
+#define SLABARENA_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/****************************************
+SlabArena
+
+按大小分级（约 1.25 倍递增，8 字节对齐）的 slab 分配器。每个级别按 1MB 页切分成等长 chunk，
+释放的 chunk 通过写在 chunk 自身前 4 字节里的空闲链表复用，不额外占用元数据。
+返回 32 位引用：高 6 位为级别，低 26 位为级别内的 chunk 编号。
+非线程安全，由使用者（每个分片一个）加锁。
+****************************************/
+class SlabArena {
+public:
+	using Ref = uint32_t;
+	static constexpr Ref kInvalidRef = UINT32_MAX;
+	static constexpr size_t kPageSize = size_t{ 1 } << 20;
+	static constexpr size_t kMinChunkSize = 16;
+	static constexpr size_t kMaxChunkSize = kPageSize;
+
+	/**
+	* memoryLimit 为所有页的总字节上限，0 表示不限制
+	*/
+	explicit SlabArena(size_t memoryLimit = 0) : _memoryLimit(memoryLimit) {
+		size_t size = kMinChunkSize;
+		while (size < kMaxChunkSize) {
+			_classes.emplace_back(size);
+			size_t next = (size * 5 / 4 + 7) & ~size_t{ 7 };
+			size = next > size ? next : size + 8;
+		}
+		_classes.emplace_back(kMaxChunkSize);
+	}
+	SlabArena(const SlabArena&) = delete;
+	SlabArena& operator=(const SlabArena&) = delete;
+
+	/**
+	* 分配至少 size 字节，超出最大级别或达到内存上限时返回 kInvalidRef
+	*/
+	Ref allocate(size_t size) {
+		int cls = classFor(size);
+		if (cls < 0) return kInvalidRef;
+		SizeClass& sc = _classes[static_cast<size_t>(cls)];
+		uint32_t chunk;
+		if (sc.freeHead != kNoChunk) {
+			chunk = sc.freeHead;
+			std::memcpy(&sc.freeHead, chunkData(sc, chunk), sizeof(uint32_t));
+		}
+		else {
+			if (sc.nextUnused == sc.pages.size() * sc.chunksPerPage) {
+				if (_memoryLimit && _pageBytes + kPageSize > _memoryLimit) return kInvalidRef;
+				if (sc.nextUnused + sc.chunksPerPage > kChunkMask) return kInvalidRef;
+				sc.pages.emplace_back(new char[kPageSize]);
+				_pageBytes += kPageSize;
+			}
+			chunk = sc.nextUnused++;
+		}
+		sc.used += 1;
+		return (static_cast<Ref>(cls) << kChunkBits) | chunk;
+	}
+
+	void free(Ref ref) {
+		SizeClass& sc = _classes[ref >> kChunkBits];
+		uint32_t chunk = ref & kChunkMask;
+		std::memcpy(chunkData(sc, chunk), &sc.freeHead, sizeof(uint32_t));
+		sc.freeHead = chunk;
+		sc.used -= 1;
+	}
+
+	char* data(Ref ref) {
+		SizeClass& sc = _classes[ref >> kChunkBits];
+		return chunkData(sc, ref & kChunkMask);
+	}
+	const char* data(Ref ref) const {
+		return const_cast<SlabArena*>(this)->data(ref);
+	}
+
+	size_t chunkSize(Ref ref) const { return _classes[ref >> kChunkBits].chunkSize; }
+	/**
+	* ref 是否与 size 属于同一级别；页不在级别之间转移，释放其他级别的 chunk 不能满足 size 的分配
+	*/
+	bool sameClass(Ref ref, size_t size) const {
+		int cls = classFor(size);
+		return cls >= 0 && static_cast<Ref>(cls) == (ref >> kChunkBits);
+	}
+	size_t pageBytes() const { return _pageBytes; }
+
+	/**
+	* 已分配 chunk 的总字节数（含级别向上取整造成的内部碎片）
+	*/
+	size_t usedBytes() const {
+		size_t total = 0;
+		for (const auto& sc : _classes) {
+			total += sc.used * sc.chunkSize;
+		}
+		return total;
+	}
+
+private:
+	static constexpr int kChunkBits = 26;
+	static constexpr uint32_t kChunkMask = (uint32_t{ 1 } << kChunkBits) - 1;
+	static constexpr uint32_t kNoChunk = UINT32_MAX;
+
+	struct SizeClass {
+		size_t chunkSize;
+		size_t chunksPerPage;
+		std::vector<std::unique_ptr<char[]>> pages;
+		uint32_t nextUnused = 0;
+		uint32_t freeHead = kNoChunk;
+		size_t used = 0;
+
+		explicit SizeClass(size_t size) : chunkSize(size), chunksPerPage(kPageSize / size) {}
+	};
+
+	int classFor(size_t size) const {
+		if (size > kMaxChunkSize) return -1;
+		// 级别数量很少（约 50 个），二分查找第一个能放下的级别
+		size_t lo = 0, hi = _classes.size() - 1;
+		while (lo < hi) {
+			size_t mid = (lo + hi) / 2;
+			if (_classes[mid].chunkSize >= size) hi = mid;
+			else lo = mid + 1;
+		}
+		return static_cast<int>(lo);
+	}
+
+	static char* chunkData(SizeClass& sc, uint32_t chunk) {
+		return sc.pages[chunk / sc.chunksPerPage].get() + (chunk % sc.chunksPerPage) * sc.chunkSize;
+	}
+
+	std::vector<SizeClass> _classes;
+	size_t _memoryLimit;
+	size_t _pageBytes = 0;
+};
+
+#endif // SLABARENA_H
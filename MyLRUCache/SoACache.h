@@ -0,0 +1,421 @@
+#pragma once
+#ifndef SOACACHE_H
+#define SOACACHE_H
+
+#include "CacheSnapshot.h"
+#include "FlatHashMap.h"
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/****************************************
+SoAStorage
+
+结构数组（SoA）形式的条目存储：前驱、后继下标与访问次数各自是一个紧凑的 uint32 数组，
+key 与 value 存放在另外两个平行数组中，条目 i 的各字段都在下标 i。
+链表遍历、淘汰与频率衰减只访问元数据数组，不会把体积大的 value 读进缓存行。
+条目始终紧凑地占用前 size() 个下标，删除时把最后一个条目搬进空位。非线程安全。
+****************************************/
+template<typename Key, typename Value>
+class SoAStorage {
+public:
+	static constexpr uint32_t kNull = UINT32_MAX;
+
+	/**
+	* 一条用下标串起来的双向链表的两端，head 为最新，tail 为最老
+	*/
+	struct ListEnds {
+		uint32_t head = kNull;
+		uint32_t tail = kNull;
+		bool empty() const { return head == kNull; }
+	};
+
+	void reserve(size_t count) {
+		_prev.reserve(count);
+		_next.reserve(count);
+		_freq.reserve(count);
+		_keys.reserve(count);
+		_values.reserve(count);
+	}
+	uint32_t size() const { return static_cast<uint32_t>(_keys.size()); }
+	void clear() {
+		_prev.clear();
+		_next.clear();
+		_freq.clear();
+		_keys.clear();
+		_values.clear();
+	}
+
+	/**
+	* 在末尾追加一个条目（未链入任何链表），返回其下标
+	*/
+	uint32_t append(const Key& key, const Value& value) {
+		_prev.push_back(kNull);
+		_next.push_back(kNull);
+		_freq.push_back(1);
+		_keys.push_back(key);
+		_values.push_back(value);
+		return size() - 1;
+	}
+
+	/**
+	* 删除下标 index 的条目（须已从链表断开）。最后一个条目会被搬到 index，
+	* lastList 为最后一个条目所在的链表；返回被搬动条目原来的下标，没有搬动时返回 kNull
+	*/
+	uint32_t erase(uint32_t index, ListEnds& lastList) {
+		uint32_t last = size() - 1;
+		if (index != last) {
+			_prev[index] = _prev[last];
+			_next[index] = _next[last];
+			_freq[index] = _freq[last];
+			_keys[index] = std::move(_keys[last]);
+			_values[index] = std::move(_values[last]);
+			if (_prev[index] != kNull) _next[_prev[index]] = index;
+			else lastList.head = index;
+			if (_next[index] != kNull) _prev[_next[index]] = index;
+			else lastList.tail = index;
+		}
+		_prev.pop_back();
+		_next.pop_back();
+		_freq.pop_back();
+		_keys.pop_back();
+		_values.pop_back();
+		return index != last ? last : kNull;
+	}
+
+	void linkHead(ListEnds& list, uint32_t index) {
+		_prev[index] = kNull;
+		_next[index] = list.head;
+		if (list.head != kNull) _prev[list.head] = index;
+		else list.tail = index;
+		list.head = index;
+	}
+	void unlink(ListEnds& list, uint32_t index) {
+		if (_prev[index] != kNull) _next[_prev[index]] = _next[index];
+		else list.head = _next[index];
+		if (_next[index] != kNull) _prev[_next[index]] = _prev[index];
+		else list.tail = _prev[index];
+	}
+
+	uint32_t prev(uint32_t index) const { return _prev[index]; }
+	uint32_t next(uint32_t index) const { return _next[index]; }
+	uint32_t& freq(uint32_t index) { return _freq[index]; }
+	std::vector<uint32_t>& freqs() { return _freq; }
+	Key& key(uint32_t index) { return _keys[index]; }
+	Value& value(uint32_t index) { return _values[index]; }
+
+private:
+	// 元数据
+	std::vector<uint32_t> _prev;
+	std::vector<uint32_t> _next;
+	std::vector<uint32_t> _freq;
+	// 数据
+	std::vector<Key> _keys;
+	std::vector<Value> _values;
+};
+
+/****************************************
+SoALRUCache
+
+与 LRUCache 行为一致、使用 SoAStorage 存储的 LRU 缓存。
+淘汰时直接复用最老条目的下标，只读写链表元数据和被淘汰的 key；
+快照与 LRUCache 使用同一格式（SnapshotKind::LRU），两者可以互相加载。
+****************************************/
+template<typename Key, typename Value>
+class SoALRUCache {
+	using Storage = SoAStorage<Key, Value>;
+public:
+	explicit SoALRUCache(int capacity) : _capacity(capacity > 0 ? static_cast<uint32_t>(capacity) : 0) {
+		_storage.reserve(_capacity);
+		_index.reserve(_capacity);
+	}
+
+	bool get(Key key, Value& value) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _index.find(key);
+		if (it == _index.end()) {
+			return false;
+		}
+		uint32_t index = it->second;
+		moveToHead(index);
+		value = _storage.value(index);
+		return true;
+	}
+	Value get(Key key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+
+	void put(Key key, Value value) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_capacity == 0) return;
+		auto it = _index.find(key);
+		if (it != _index.end()) {
+			_storage.value(it->second) = value;
+			moveToHead(it->second);
+			return;
+		}
+		insert(key, value);
+	}
+
+	bool remove(Key key) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _index.find(key);
+		if (it == _index.end()) return false;
+		uint32_t index = it->second;
+		_index.erase(it);
+		_storage.unlink(_list, index);
+		uint32_t moved = _storage.erase(index, _list);
+		if (moved != Storage::kNull) _index[_storage.key(index)] = index;
+		return true;
+	}
+
+	size_t size() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _storage.size();
+	}
+
+	/**
+	* 按从最久未使用到最近使用的顺序导出全部条目，与 LRUCache::exportEntries 相同
+	*/
+	std::vector<std::pair<Key, Value>> exportEntries() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::vector<std::pair<Key, Value>> entries;
+		entries.reserve(_storage.size());
+		for (uint32_t index = _list.tail; index != Storage::kNull; index = _storage.prev(index)) {
+			entries.emplace_back(_storage.key(index), _storage.value(index));
+		}
+		return entries;
+	}
+	/**
+	* 清空缓存后按顺序导入，超出容量时保留最近使用的部分
+	*/
+	void importEntries(const std::vector<std::pair<Key, Value>>& entries) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_storage.clear();
+		_index.clear();
+		_list = typename Storage::ListEnds();
+		if (_capacity == 0) return;
+		size_t begin = entries.size() > _capacity ? entries.size() - _capacity : 0;
+		for (size_t i = begin; i < entries.size(); ++i) {
+			auto it = _index.find(entries[i].first);
+			if (it != _index.end()) {
+				_storage.value(it->second) = entries[i].second;
+				moveToHead(it->second);
+				continue;
+			}
+			insert(entries[i].first, entries[i].second);
+		}
+	}
+	bool saveSnapshot(const std::string& path) {
+		auto entries = exportEntries();
+		SnapshotWriter writer(path, SnapshotKind::LRU);
+		writer.writeEntries(entries);
+		return writer.finish();
+	}
+	bool loadSnapshot(const std::string& path) {
+		SnapshotReader reader;
+		if (!reader.open(path, SnapshotKind::LRU)) return false;
+		std::vector<std::pair<Key, Value>> entries;
+		if (!reader.readEntries(entries) || !reader.atEnd()) return false;
+		importEntries(entries);
+		return true;
+	}
+
+private:
+	void moveToHead(uint32_t index) {
+		if (_list.head == index) return;
+		_storage.unlink(_list, index);
+		_storage.linkHead(_list, index);
+	}
+
+	void insert(const Key& key, const Value& value) {
+		uint32_t index;
+		if (_storage.size() < _capacity) {
+			index = _storage.append(key, value);
+		}
+		else {
+			// 已满：复用最老条目的下标，只有被淘汰的 key 和新数据会被写入
+			index = _list.tail;
+			_storage.unlink(_list, index);
+			_index.erase(_storage.key(index));
+			_storage.key(index) = key;
+			_storage.value(index) = value;
+		}
+		_storage.linkHead(_list, index);
+		_index[key] = index;
+	}
+
+	std::mutex _mutex;
+	uint32_t _capacity;
+	Storage _storage;
+	typename Storage::ListEnds _list;
+	FlatHashMap<Key, uint32_t> _index;
+};
+
+/****************************************
+SoALFUCache
+
+淘汰与衰减规则同 AlignLFUCache、使用 SoAStorage 存储的 LFU 缓存：
+同一访问次数的条目串成一条链表，淘汰最小次数链表中最老的条目；
+平均访问次数超过 maxAverageFreq 时所有条目次数减去 maxAverageFreq / 2（最少为 1）。
+衰减只读写访问次数与链表元数据，不访问 key 与 value。与 AlignLFUCache 按哈希表顺序重建不同，
+衰减后同一链表内仍按最近访问排序，合并到同一次数的条目中原次数低的更老。
+****************************************/
+template<typename Key, typename Value>
+class SoALFUCache {
+	using Storage = SoAStorage<Key, Value>;
+	using ListEnds = typename Storage::ListEnds;
+public:
+	SoALFUCache(int capacity, int maxAverageFreq)
+		: _capacity(capacity > 0 ? static_cast<uint32_t>(capacity) : 0),
+		_maxAverageFreq(maxAverageFreq > 1 ? static_cast<uint32_t>(maxAverageFreq) : 2) {
+		_storage.reserve(_capacity);
+		_index.reserve(_capacity);
+	}
+
+	bool get(Key key, Value& value) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _index.find(key);
+		if (it == _index.end()) {
+			return false;
+		}
+		uint32_t index = it->second;
+		touch(index);
+		value = _storage.value(index);
+		return true;
+	}
+	Value get(Key key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+
+	void put(Key key, Value value) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_capacity == 0) return;
+		auto it = _index.find(key);
+		if (it != _index.end()) {
+			_storage.value(it->second) = value;
+			touch(it->second);
+			return;
+		}
+		uint32_t index;
+		if (_storage.size() >= _capacity) {
+			// 淘汰最小次数链表中最老的条目，复用其下标
+			index = _buckets[_minFreq].tail;
+			unlinkFromBucket(index);
+			_totalFreq -= _storage.freq(index);
+			_index.erase(_storage.key(index));
+			_storage.key(index) = key;
+			_storage.value(index) = value;
+			_storage.freq(index) = 1;
+		}
+		else {
+			index = _storage.append(key, value);
+		}
+		_storage.linkHead(_buckets[1], index);
+		_minFreq = 1;
+		_index[key] = index;
+		addFreq();
+	}
+
+	bool remove(Key key) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _index.find(key);
+		if (it == _index.end()) return false;
+		uint32_t index = it->second;
+		_index.erase(it);
+		unlinkFromBucket(index);
+		_totalFreq -= _storage.freq(index);
+		uint32_t last = _storage.size() - 1;
+		if (index != last) {
+			uint32_t moved = _storage.erase(index, _buckets[_storage.freq(last)]);
+			if (moved != Storage::kNull) _index[_storage.key(index)] = index;
+		}
+		else {
+			ListEnds unused;
+			_storage.erase(index, unused);
+		}
+		if (_storage.size() == 0) _minFreq = 1;
+		else if (_buckets[_minFreq].empty()) updateMinFreq();
+		return true;
+	}
+
+	size_t size() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _storage.size();
+	}
+
+private:
+	/**
+	* 访问次数加 1，移到下一个频次链表
+	*/
+	void touch(uint32_t index) {
+		uint32_t freq = _storage.freq(index);
+		unlinkFromBucket(index);
+		if (freq == _minFreq && _buckets[freq].empty()) ++_minFreq;
+		_storage.freq(index) = freq + 1;
+		_storage.linkHead(_buckets[freq + 1], index);
+		addFreq();
+	}
+
+	void unlinkFromBucket(uint32_t index) {
+		_storage.unlink(_buckets[_storage.freq(index)], index);
+	}
+
+	void addFreq() {
+		++_totalFreq;
+		if (_totalFreq / std::max<uint32_t>(1, _storage.size()) > _maxAverageFreq) {
+			age();
+		}
+	}
+
+	/**
+	* 衰减：顺序扫描访问次数数组，再按原次数从低到高、各链表从老到新插到新链表表头，保留最近访问顺序
+	*/
+	void age() {
+		uint32_t decrement = _maxAverageFreq / 2;
+		std::vector<uint32_t>& freqs = _storage.freqs();
+		_totalFreq = 0;
+		for (uint32_t& freq : freqs) {
+			freq = freq > decrement + 1 ? freq - decrement : 1;
+			_totalFreq += freq;
+		}
+		std::vector<std::pair<uint32_t, ListEnds>> old(_buckets.begin(), _buckets.end());
+		std::sort(old.begin(), old.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+		_buckets.clear();
+		for (auto& bucket : old) {
+			for (uint32_t index = bucket.second.tail; index != Storage::kNull;) {
+				uint32_t newer = _storage.prev(index);
+				_storage.linkHead(_buckets[freqs[index]], index);
+				index = newer;
+			}
+		}
+		updateMinFreq();
+	}
+
+	void updateMinFreq() {
+		_minFreq = UINT32_MAX;
+		for (const auto& bucket : _buckets) {
+			if (!bucket.second.empty()) _minFreq = std::min(_minFreq, bucket.first);
+		}
+		if (_minFreq == UINT32_MAX) _minFreq = 1;
+	}
+
+	std::mutex _mutex;
+	uint32_t _capacity;
+	uint32_t _maxAverageFreq;
+	uint32_t _minFreq = 1;
+	uint64_t _totalFreq = 0;
+	Storage _storage;
+	std::unordered_map<uint32_t, ListEnds> _buckets;
+	FlatHashMap<Key, uint32_t> _index;
+};
+
+#endif // SOACACHE_H
@@ -0,0 +1,183 @@
+#pragma once
+#ifndef STATICLRUCACHE_H
+#define STATICLRUCACHE_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STATICLRUCACHE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/****************************************
+StaticLRUCache
+
+容量在编译期确定的 LRU 缓存，适合每个请求、每个连接私有的小缓存：
+	所有数据都在对象内部的 std::array 中，构造、插入、淘汰都不分配堆内存；
+	链表下标使用能容纳 N 的最小无符号整数类型（N < 255 时为 1 字节）；
+	条目始终紧凑地存放在前 size() 个槽位，查找时先用 SSE2 一次比较 16 个 1 字节标签，
+	标签相同才比较 key，N 较小时整个标签数组只有一两条缓存行。
+Key 为整数或枚举、Value 为字面类型时，所有操作都可以在常量表达式中使用。
+非线程安全，需要共享时由调用者加锁。
+****************************************/
+template<typename Key, typename Value, size_t N>
+class StaticLRUCache {
+	static_assert(N > 0, "StaticLRUCache capacity must be positive");
+public:
+	using Index = std::conditional_t<(N < UINT8_MAX), uint8_t,
+		std::conditional_t<(N < UINT16_MAX), uint16_t, uint32_t>>;
+
+	constexpr StaticLRUCache() = default;
+
+	static constexpr size_t capacity() { return N; }
+	constexpr size_t size() const { return _size; }
+	constexpr bool empty() const { return _size == 0; }
+
+	constexpr bool get(const Key& key, Value& value) {
+		Index index = find(key);
+		if (index == kNull) {
+			return false;
+		}
+		moveToHead(index);
+		value = _values[index];
+		return true;
+	}
+	constexpr Value get(const Key& key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+	constexpr bool contains(const Key& key) const {
+		return find(key) != kNull;
+	}
+
+	constexpr void put(const Key& key, const Value& value) {
+		Index index = find(key);
+		if (index != kNull) {
+			_values[index] = value;
+			moveToHead(index);
+			return;
+		}
+		if (_size < N) {
+			index = static_cast<Index>(_size++);
+		}
+		else {
+			// 已满：直接复用最久未访问条目的槽位
+			index = _tail;
+			unlink(index);
+		}
+		_keys[index] = key;
+		_values[index] = value;
+		_tags[index] = tagOf(key);
+		linkHead(index);
+	}
+
+	constexpr bool remove(const Key& key) {
+		Index index = find(key);
+		if (index == kNull) {
+			return false;
+		}
+		unlink(index);
+		// 把最后一个槽位搬到空洞里，保持条目紧凑
+		Index last = static_cast<Index>(--_size);
+		if (index != last) {
+			_keys[index] = _keys[last];
+			_values[index] = _values[last];
+			_tags[index] = _tags[last];
+			_prev[index] = _prev[last];
+			_next[index] = _next[last];
+			if (_prev[index] != kNull) _next[_prev[index]] = index;
+			else _head = index;
+			if (_next[index] != kNull) _prev[_next[index]] = index;
+			else _tail = index;
+		}
+		return true;
+	}
+
+	constexpr void clear() {
+		_size = 0;
+		_head = kNull;
+		_tail = kNull;
+	}
+
+private:
+	static constexpr Index kNull = std::numeric_limits<Index>::max();
+	// 标签数组按 16 字节对齐补齐，SIMD 比较不会越界
+	static constexpr size_t kTagCount = (N + 15) / 16 * 16;
+
+	/**
+	* 1 字节标签；整数与枚举 key 用常量表达式可计算的混合函数，其他类型用 std::hash
+	*/
+	static constexpr uint8_t tagOf(const Key& key) {
+		uint64_t h;
+		if constexpr (std::is_integral_v<Key> || std::is_enum_v<Key>) {
+			h = static_cast<uint64_t>(key);
+		}
+		else {
+			h = static_cast<uint64_t>(std::hash<Key>()(key));
+		}
+		return static_cast<uint8_t>((h * 0x9E3779B97F4A7C15ull) >> 56);
+	}
+
+	constexpr Index find(const Key& key) const {
+		uint8_t tag = tagOf(key);
+#ifdef STATICLRUCACHE_SSE2
+		if (!std::is_constant_evaluated()) {
+			const __m128i needle = _mm_set1_epi8(static_cast<char>(tag));
+			for (size_t base = 0; base < _size; base += 16) {
+				__m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_tags.data() + base));
+				uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, needle)));
+				// 只看已占用的槽位
+				if (_size - base < 16) mask &= (1u << (_size - base)) - 1;
+				while (mask) {
+					size_t index = base + static_cast<size_t>(std::countr_zero(mask));
+					if (_keys[index] == key) return static_cast<Index>(index);
+					mask &= mask - 1;
+				}
+			}
+			return kNull;
+		}
+#endif
+		for (size_t index = 0; index < _size; ++index) {
+			if (_tags[index] == tag && _keys[index] == key) return static_cast<Index>(index);
+		}
+		return kNull;
+	}
+
+	// ---- 双向链表：_head 为最近访问，_tail 为最久未访问 ----
+	constexpr void linkHead(Index index) {
+		_prev[index] = kNull;
+		_next[index] = _head;
+		if (_head != kNull) _prev[_head] = index;
+		else _tail = index;
+		_head = index;
+	}
+	constexpr void unlink(Index index) {
+		if (_prev[index] != kNull) _next[_prev[index]] = _next[index];
+		else _head = _next[index];
+		if (_next[index] != kNull) _prev[_next[index]] = _prev[index];
+		else _tail = _prev[index];
+	}
+	constexpr void moveToHead(Index index) {
+		if (_head == index) return;
+		unlink(index);
+		linkHead(index);
+	}
+
+	std::array<uint8_t, kTagCount> _tags{};
+	std::array<Index, N> _prev{};
+	std::array<Index, N> _next{};
+	Index _head = kNull;
+	Index _tail = kNull;
+	size_t _size = 0;
+	std::array<Key, N> _keys{};
+	std::array<Value, N> _values{};
+};
+
+#endif // STATICLRUCACHE_H
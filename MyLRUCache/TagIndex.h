@@ -0,0 +1,215 @@
+#pragma once
+#ifndef TAGINDEX_H
+#define TAGINDEX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <set>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/****************************************
+TagIndex
+
+缓存条目的二级索引：tag -> 条目 与 key 前缀 -> 条目，用于上游实体变化时批量失效。
+每个 (key, tag) 关系是一个链接节点，同时挂在两条侵入式链表上：
+	tag 的双向链表，按 tag 取出条目时从表头逐个摘下；
+	key 的单向链表，key 被淘汰或删除时沿它把自己从所有 tag 链表中摘掉。
+因此失效一个 tag 的耗时与被删除的条目数（乘以每个条目的 tag 数）成正比，与缓存大小无关。
+前缀索引是按字典序排列的 key 集合，只对 std::string key 开启，开启后每次写入新 key 多一次有序插入。
+非线程安全，由所属缓存在自己的锁内调用。
+****************************************/
+template<typename Key>
+class TagIndex {
+public:
+	using Tag = std::string;
+
+	TagIndex() = default;
+	~TagIndex() { clear(); }
+	TagIndex(const TagIndex&) = delete;
+	TagIndex& operator=(const TagIndex&) = delete;
+
+	/**
+	* 是否有需要维护的内容；为 false 时淘汰路径不必查索引
+	*/
+	bool active() const { return !_keys.empty() || _prefixEnabled; }
+
+	/**
+	* 用 tags 替换 key 的标签，重复的 tag 只记一次
+	*/
+	void setTags(const Key& key, const std::vector<Tag>& tags) {
+		auto it = _keys.find(key);
+		if (it != _keys.end()) {
+			unlinkAll(it->second);
+			if (tags.empty()) {
+				_keys.erase(it);
+				return;
+			}
+		}
+		else {
+			if (tags.empty()) return;
+			it = _keys.emplace(key, nullptr).first;
+		}
+		for (const Tag& tag : tags) {
+			bool duplicate = false;
+			for (Link* link = it->second; link; link = link->keyNext) {
+				if (link->tag->first == tag) {
+					duplicate = true;
+					break;
+				}
+			}
+			if (duplicate) continue;
+			auto& entry = *_tags.try_emplace(tag).first;
+			Link* link = new Link{ &it->first, &entry, nullptr, entry.second.head, it->second };
+			if (entry.second.head) entry.second.head->tagPrev = link;
+			entry.second.head = link;
+			++entry.second.size;
+			it->second = link;
+			++_links;
+		}
+	}
+
+	/**
+	* 记录新写入的 key，开启前缀索引时才有作用
+	*/
+	void track(const Key& key) {
+		if (_prefixEnabled) _ordered.insert(key);
+	}
+
+	/**
+	* key 已离开缓存：从所有 tag 与前缀索引中删除
+	*/
+	void erase(const Key& key) {
+		if (_prefixEnabled) _ordered.erase(key);
+		if (_keys.empty()) return;
+		auto it = _keys.find(key);
+		if (it == _keys.end()) return;
+		unlinkAll(it->second);
+		_keys.erase(it);
+	}
+
+	/**
+	* key 当前的标签，没有时为空
+	*/
+	std::vector<Tag> tagsOf(const Key& key) const {
+		std::vector<Tag> tags;
+		auto it = _keys.find(key);
+		if (it == _keys.end()) return tags;
+		for (Link* link = it->second; link; link = link->keyNext) tags.push_back(link->tag->first);
+		return tags;
+	}
+
+	/**
+	* 取出最多 maxKeys 个带 tag 的 key，并把它们从索引中完全删除；返回数量小于 maxKeys 表示已取完
+	*/
+	std::vector<Key> takeTag(const Tag& tag, size_t maxKeys) {
+		std::vector<Key> keys;
+		auto it = _tags.find(tag);
+		if (it == _tags.end()) return keys;
+		keys.reserve(std::min(maxKeys, it->second.size));
+		while (keys.size() < maxKeys) {
+			Link* head = it->second.head;
+			// 摘下最后一个链接时 tag 本身会被删除，it 随之失效
+			bool last = head->tagNext == nullptr;
+			keys.push_back(*head->key);
+			erase(keys.back());
+			if (last) break;
+		}
+		return keys;
+	}
+
+	/**
+	* 取出最多 maxKeys 个以 prefix 开头的 key，并把它们从索引中完全删除；需先 enablePrefix
+	*/
+	std::vector<Key> takePrefix(std::string_view prefix, size_t maxKeys) {
+		static_assert(std::is_same_v<Key, std::string>, "prefix invalidation requires std::string keys");
+		std::vector<Key> keys;
+		auto it = _ordered.lower_bound(prefix);
+		while (keys.size() < maxKeys && it != _ordered.end() && std::string_view(*it).substr(0, prefix.size()) == prefix) {
+			keys.push_back(*it++);
+		}
+		for (const Key& key : keys) {
+			erase(key);
+		}
+		return keys;
+	}
+
+	/**
+	* 开启前缀索引，keys 为缓存中现有的 key
+	*/
+	template<typename Range>
+	void enablePrefix(const Range& keys) {
+		if (_prefixEnabled) return;
+		_prefixEnabled = true;
+		for (const Key& key : keys) _ordered.insert(key);
+	}
+	bool prefixEnabled() const { return _prefixEnabled; }
+
+	/**
+	* 清空所有记录，前缀索引保持开启
+	*/
+	void clear() {
+		for (auto& pair : _keys) {
+			Link* link = pair.second;
+			while (link) {
+				Link* next = link->keyNext;
+				delete link;
+				link = next;
+			}
+		}
+		_keys.clear();
+		_tags.clear();
+		_ordered.clear();
+		_links = 0;
+	}
+
+	size_t tagCount() const { return _tags.size(); }
+	size_t taggedKeyCount() const { return _keys.size(); }
+	size_t linkCount() const { return _links; }
+
+private:
+	struct Link;
+	struct TagList {
+		Link* head = nullptr;
+		size_t size = 0;
+	};
+	using TagMap = std::unordered_map<Tag, TagList>;
+	struct Link {
+		// 指向 _keys/_tags 中的元素，unordered_map 扩容不会移动元素
+		const Key* key;
+		typename TagMap::value_type* tag;
+		Link* tagPrev;
+		Link* tagNext;
+		Link* keyNext;
+	};
+
+	/**
+	* 把 key 的链接逐个从所在 tag 链表中摘下并释放，空的 tag 一并删除
+	*/
+	void unlinkAll(Link*& first) {
+		Link* link = first;
+		while (link) {
+			TagList& list = link->tag->second;
+			if (link->tagPrev) link->tagPrev->tagNext = link->tagNext;
+			else list.head = link->tagNext;
+			if (link->tagNext) link->tagNext->tagPrev = link->tagPrev;
+			if (--list.size == 0) _tags.erase(_tags.find(link->tag->first));
+			Link* next = link->keyNext;
+			delete link;
+			--_links;
+			link = next;
+		}
+		first = nullptr;
+	}
+
+	std::unordered_map<Key, Link*> _keys;
+	TagMap _tags;
+	std::set<Key, std::less<>> _ordered;
+	bool _prefixEnabled = false;
+	size_t _links = 0;
+};
+
+#endif // TAGINDEX_H
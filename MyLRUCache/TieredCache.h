@@ -0,0 +1,434 @@
+#pragma once
+#ifndef TIEREDCACHE_H
+#define TIEREDCACHE_H
+
+#include "CacheSnapshot.h"
+#include "LRUCache.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/****************************************
+SegmentFile
+
+日志段文件：按偏移写入与读取（POSIX 为 pwrite/pread，Windows 为带 OVERLAPPED 偏移的 WriteFile/ReadFile），
+读操作不共享文件指针，可以并发执行。析构时关闭并删除文件。
+****************************************/
+class SegmentFile {
+public:
+	explicit SegmentFile(std::string path) : _path(std::move(path)) {
+#ifdef _WIN32
+		_handle = CreateFileA(_path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+			nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+		_fd = ::open(_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+#endif
+	}
+	~SegmentFile() {
+#ifdef _WIN32
+		if (_handle != INVALID_HANDLE_VALUE) CloseHandle(_handle);
+#else
+		if (_fd >= 0) ::close(_fd);
+#endif
+		std::error_code ec;
+		std::filesystem::remove(_path, ec);
+	}
+	SegmentFile(const SegmentFile&) = delete;
+	SegmentFile& operator=(const SegmentFile&) = delete;
+
+	bool isOpen() const {
+#ifdef _WIN32
+		return _handle != INVALID_HANDLE_VALUE;
+#else
+		return _fd >= 0;
+#endif
+	}
+
+	bool writeAt(const char* data, size_t len, uint64_t offset) {
+		while (len > 0) {
+#ifdef _WIN32
+			OVERLAPPED ov{};
+			ov.Offset = static_cast<DWORD>(offset);
+			ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+			DWORD written = 0;
+			DWORD chunk = len > (1u << 30) ? (1u << 30) : static_cast<DWORD>(len);
+			if (!WriteFile(_handle, data, chunk, &written, &ov) || written == 0) return false;
+#else
+			ssize_t written = ::pwrite(_fd, data, len, static_cast<off_t>(offset));
+			if (written <= 0) return false;
+#endif
+			data += written;
+			len -= static_cast<size_t>(written);
+			offset += static_cast<uint64_t>(written);
+		}
+		return true;
+	}
+
+	bool readAt(char* data, size_t len, uint64_t offset) const {
+		while (len > 0) {
+#ifdef _WIN32
+			OVERLAPPED ov{};
+			ov.Offset = static_cast<DWORD>(offset);
+			ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+			DWORD got = 0;
+			DWORD chunk = len > (1u << 30) ? (1u << 30) : static_cast<DWORD>(len);
+			if (!ReadFile(_handle, data, chunk, &got, &ov) || got == 0) return false;
+#else
+			ssize_t got = ::pread(_fd, data, len, static_cast<off_t>(offset));
+			if (got <= 0) return false;
+#endif
+			data += got;
+			len -= static_cast<size_t>(got);
+			offset += static_cast<uint64_t>(got);
+		}
+		return true;
+	}
+
+private:
+	std::string _path;
+#ifdef _WIN32
+	HANDLE _handle = INVALID_HANDLE_VALUE;
+#else
+	int _fd = -1;
+#endif
+};
+
+/****************************************
+SegmentLogStore
+
+二级缓存：被淘汰的条目追加写入固定大小的日志段，内存中只保留 key -> (段号, 偏移, 长度) 的索引。
+段写满后封存并打开新段，段数超过上限时按 FIFO 整段回收。
+记录格式：u32 crc | u32 keyBytes | u32 valueBytes | key | value（Serializer 编码）
+****************************************/
+template<typename Key, typename Value>
+class SegmentLogStore {
+public:
+	SegmentLogStore(std::string directory, uint64_t segmentBytes, size_t maxSegments)
+		: _directory(std::move(directory)), _segmentBytes(segmentBytes), _maxSegments(maxSegments < 1 ? 1 : maxSegments) {
+		std::error_code ec;
+		std::filesystem::create_directories(_directory, ec);
+		// 索引只在内存中，上次运行留下的段文件无法再使用
+		for (auto& entry : std::filesystem::directory_iterator(_directory, ec)) {
+			auto name = entry.path().filename().string();
+			if (name.rfind("segment_", 0) == 0 && entry.path().extension() == ".log") {
+				std::filesystem::remove(entry.path(), ec);
+			}
+		}
+		_writeBuffer.reserve(kWriteBufferBytes);
+	}
+	~SegmentLogStore() = default;
+
+	/**
+	* 追加一条记录，同一个 key 的旧记录自动失效
+	*/
+	bool append(const Key& key, const Value& value) {
+		size_t keyBytes = Serializer<Key>::size(key);
+		size_t valueBytes = Serializer<Value>::size(value);
+		size_t length = kHeaderBytes + keyBytes + valueBytes;
+		if (length > _segmentBytes || keyBytes > UINT32_MAX || valueBytes > UINT32_MAX) return false;
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_segments.empty() || _segments.back().size + length > _segmentBytes) {
+			if (!roll()) return false;
+		}
+		Segment& active = _segments.back();
+		size_t begin = _writeBuffer.size();
+		_writeBuffer.resize(begin + length);
+		char* record = _writeBuffer.data() + begin;
+		uint32_t lengths[2] = { static_cast<uint32_t>(keyBytes), static_cast<uint32_t>(valueBytes) };
+		std::memcpy(record + 4, lengths, sizeof(lengths));
+		char* out = Serializer<Key>::write(record + kHeaderBytes, key);
+		Serializer<Value>::write(out, value);
+		uint32_t crc = Crc32::update(0, record + 4, length - 4);
+		std::memcpy(record, &crc, 4);
+
+		_index[key] = Location{ active.id, static_cast<uint32_t>(length), active.size };
+		active.size += length;
+		_appendedBytes += length;
+		if (_writeBuffer.size() >= kWriteBufferBytes) {
+			flush();
+		}
+		return true;
+	}
+
+	/**
+	* 读出并移出索引（提升回内存层时使用），不存在或校验失败返回 false
+	*/
+	bool take(const Key& key, Value& value) {
+		std::vector<char> record;
+		std::shared_ptr<SegmentFile> file;
+		Location loc;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto it = _index.find(key);
+			if (it == _index.end()) return false;
+			loc = it->second;
+			_index.erase(it);
+			record.resize(loc.length);
+			const Segment& active = _segments.back();
+			if (loc.segment == active.id && loc.offset >= _bufferOffset) {
+				// 仍在写缓冲中
+				std::memcpy(record.data(), _writeBuffer.data() + (loc.offset - _bufferOffset), loc.length);
+			}
+			else {
+				file = _segments[loc.segment - _segments.front().id].file;
+			}
+		}
+		// 段文件由 shared_ptr 持有，读取期间即使被回收也不会关闭
+		if (file && !file->readAt(record.data(), record.size(), loc.offset)) return false;
+		return decode(record, key, value);
+	}
+
+	bool erase(const Key& key) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _index.erase(key) > 0;
+	}
+
+	size_t size() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _index.size();
+	}
+
+	/**
+	* 当前所有段占用的磁盘字节数
+	*/
+	uint64_t diskBytes() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		uint64_t total = 0;
+		for (auto& segment : _segments) total += segment.size;
+		return total;
+	}
+
+	uint64_t reclaimedSegments() const { return _reclaimedSegments.load(std::memory_order_relaxed); }
+
+private:
+	static constexpr size_t kHeaderBytes = 12;
+	static constexpr size_t kWriteBufferBytes = 64 * 1024;
+
+	struct Location {
+		uint32_t segment;
+		uint32_t length;
+		uint64_t offset;
+	};
+
+	struct Segment {
+		uint32_t id;
+		std::shared_ptr<SegmentFile> file;
+		uint64_t size;
+	};
+
+	bool decode(const std::vector<char>& record, const Key& key, Value& value) const {
+		if (record.size() < kHeaderBytes) return false;
+		uint32_t crc = 0;
+		uint32_t lengths[2] = { 0, 0 };
+		std::memcpy(&crc, record.data(), 4);
+		std::memcpy(lengths, record.data() + 4, sizeof(lengths));
+		if (Crc32::update(0, record.data() + 4, record.size() - 4) != crc) return false;
+		const char* in = record.data() + kHeaderBytes;
+		const char* end = record.data() + record.size();
+		Key storedKey{};
+		if (!Serializer<Key>::read(in, end, storedKey) || !(storedKey == key)) return false;
+		return Serializer<Value>::read(in, end, value);
+	}
+
+	/**
+	* 写出缓冲，失败时丢弃缓冲中记录对应的索引
+	*/
+	void flush() {
+		if (_writeBuffer.empty()) return;
+		Segment& active = _segments.back();
+		if (!active.file->writeAt(_writeBuffer.data(), _writeBuffer.size(), _bufferOffset)) {
+			for (auto it = _index.begin(); it != _index.end();) {
+				if (it->second.segment == active.id && it->second.offset >= _bufferOffset) it = _index.erase(it);
+				else ++it;
+			}
+			active.size = _bufferOffset;
+		}
+		_bufferOffset = active.size;
+		_writeBuffer.clear();
+	}
+
+	/**
+	* 封存当前段并打开新段，超过段数上限时回收最旧的段
+	*/
+	bool roll() {
+		if (!_segments.empty()) {
+			flush();
+		}
+		uint32_t id = _nextSegmentId++;
+		auto file = std::make_shared<SegmentFile>(_directory + "/segment_" + std::to_string(id) + ".log");
+		if (!file->isOpen()) return false;
+		_segments.push_back(Segment{ id, std::move(file), 0 });
+		_bufferOffset = 0;
+		while (_segments.size() > _maxSegments) {
+			uint32_t oldest = _segments.front().id;
+			// 回收整段：扫描索引删除指向该段的条目，摊还到每次追加上开销为 O(段数)
+			for (auto it = _index.begin(); it != _index.end();) {
+				if (it->second.segment == oldest) it = _index.erase(it);
+				else ++it;
+			}
+			_segments.pop_front();
+			_reclaimedSegments.fetch_add(1, std::memory_order_relaxed);
+		}
+		return true;
+	}
+
+	std::string _directory;
+	uint64_t _segmentBytes;
+	size_t _maxSegments;
+	std::mutex _mutex;
+	std::unordered_map<Key, Location> _index;
+	std::deque<Segment> _segments;
+	uint32_t _nextSegmentId = 0;
+	std::vector<char> _writeBuffer;
+	uint64_t _bufferOffset = 0;
+	uint64_t _appendedBytes = 0;
+	std::atomic<uint64_t> _reclaimedSegments{ 0 };
+};
+
+/****************************************
+TieredLRUCache
+
+内存 LRUCache + 本地磁盘 SegmentLogStore 两级缓存：
+内存层淘汰的条目写入磁盘层；磁盘层命中时读出并提升回内存层。
+内存层的锁内只把被淘汰的条目按淘汰顺序放入待落盘队列，写磁盘（缓冲刷出、换段回收）在锁外进行，
+内存层的读写不会等待磁盘 I/O。队列按序写入，同一个 key 较新的淘汰总是覆盖较旧的；
+提升与 remove 在操作磁盘层之前先把队列写完，不会漏掉尚在队列中的条目。
+****************************************/
+template<typename Key, typename Value>
+class TieredLRUCache {
+public:
+	struct TierStats {
+		uint64_t ramHits = 0;
+		uint64_t diskHits = 0;
+		uint64_t misses = 0;
+		size_t diskEntries = 0;
+		uint64_t diskBytes = 0;
+		uint64_t reclaimedSegments = 0;
+	};
+
+	TieredLRUCache(int ramCapacity, const std::string& directory,
+		uint64_t segmentBytes = 64ull << 20, size_t maxSegments = 16)
+		: _ram(ramCapacity), _disk(directory, segmentBytes, maxSegments) {
+		// 在内存层的锁内入队，保证队列顺序与淘汰顺序一致
+		_ram.setEvictionCallback([this](const Key& key, const Value& value) {
+			std::lock_guard<std::mutex> lock(_spillMutex);
+			_spills.emplace_back(key, value);
+			_spillPending.store(true, std::memory_order_release);
+		}, true);
+	}
+
+	bool get(Key key, Value& value) {
+		if (_ram.get(key, value)) {
+			_ramHits.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+		{
+			std::lock_guard<std::mutex> lock(keyLock(key));
+			// 该 key 可能刚被淘汰、还在队列中
+			drainSpills(true);
+			if (!_disk.take(key, value)) {
+				_misses.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			_diskHits.fetch_add(1, std::memory_order_relaxed);
+			// 提升期间并发 put 写入的新值优先，不能被磁盘中的旧值覆盖
+			if (!_ram.putIfAbsent(key, value)) _ram.get(key, value);
+		}
+		drainSpills(false);
+		return true;
+	}
+	Value get(Key key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+
+	void put(Key key, Value value) {
+		// 磁盘层中的旧版本作废，避免之后被提升覆盖新值；之后才从队列落盘的旧值会被内存层的新值遮住，
+		// 新值被淘汰时排在它后面入队并覆盖它
+		_disk.erase(key);
+		_ram.put(key, value);
+		drainSpills(false);
+	}
+
+	/**
+	* 先删内存层再删磁盘层：内存层删除之后该 key 不会再被淘汰入队，删磁盘层前写完队列中已有的旧值。
+	* 与提升持同一把分片锁，避免已取出的旧值在删除之后被写回内存层
+	*/
+	void remove(Key key) {
+		std::lock_guard<std::mutex> lock(keyLock(key));
+		_ram.remove(key);
+		drainSpills(true);
+		_disk.erase(key);
+	}
+
+	TierStats getStats() {
+		TierStats stats;
+		stats.ramHits = _ramHits.load(std::memory_order_relaxed);
+		stats.diskHits = _diskHits.load(std::memory_order_relaxed);
+		stats.misses = _misses.load(std::memory_order_relaxed);
+		stats.diskEntries = _disk.size();
+		stats.diskBytes = _disk.diskBytes();
+		stats.reclaimedSegments = _disk.reclaimedSegments();
+		return stats;
+	}
+
+private:
+	static constexpr size_t kKeyLocks = 64;
+
+	std::mutex& keyLock(const Key& key) {
+		return _keyLocks[std::hash<Key>()(key) % kKeyLocks];
+	}
+
+	/**
+	* 按入队顺序把待落盘的条目写入磁盘层。wait 为 true 时返回前队列已写完（包括其他线程正在写的批次）；
+	* 为 false 时若已有线程在写则直接返回，剩下的条目由它或之后的操作写出
+	*/
+	void drainSpills(bool wait) {
+		if (!_spillPending.load(std::memory_order_acquire)) return;
+		std::unique_lock<std::mutex> drain(_drainMutex, std::defer_lock);
+		if (wait) drain.lock();
+		else if (!drain.try_lock()) return;
+		std::vector<std::pair<Key, Value>> batch;
+		while (true) {
+			{
+				std::lock_guard<std::mutex> lock(_spillMutex);
+				if (_spills.empty()) {
+					_spillPending.store(false, std::memory_order_release);
+					return;
+				}
+				batch.swap(_spills);
+			}
+			for (const auto& [key, value] : batch) _disk.append(key, value);
+			batch.clear();
+		}
+	}
+
+	LRUCache<Key, Value> _ram;
+	SegmentLogStore<Key, Value> _disk;
+	// 按 key 分片的锁，只用于磁盘层提升与 remove 之间互斥
+	std::mutex _keyLocks[kKeyLocks];
+	// 待落盘队列；_drainMutex 保证同一时间只有一个线程按序写磁盘。加锁顺序为 key 锁 -> _drainMutex -> 磁盘层，
+	// 内存层的锁 -> _spillMutex
+	std::mutex _spillMutex;
+	std::vector<std::pair<Key, Value>> _spills;
+	std::atomic<bool> _spillPending{ false };
+	std::mutex _drainMutex;
+	std::atomic<uint64_t> _ramHits{ 0 };
+	std::atomic<uint64_t> _diskHits{ 0 };
+	std::atomic<uint64_t> _misses{ 0 };
+};
+
+#endif // TIEREDCACHE_H
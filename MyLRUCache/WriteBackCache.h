@@ -0,0 +1,369 @@
+#pragma once
+#ifndef WRITEBACKCACHE_H
+#define WRITEBACKCACHE_H
+
+#include "LRUCache.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/****************************************
+BackingStore
+
+WriteBackCache 背后的慢速存储接口。
+writeBatch 返回 false 表示这一批写入失败，整批会被重试，其中部分条目可能已经写入，
+因此实现必须允许同一 key 被重复写入同一个值（幂等）。
+****************************************/
+template<typename Key, typename Value>
+class BackingStore {
+public:
+	virtual ~BackingStore() = default;
+	virtual bool read(const Key& key, Value& value) = 0;
+	virtual bool writeBatch(const std::vector<std::pair<Key, Value>>& entries) = 0;
+};
+
+/****************************************
+MemoryBackingStore
+
+内存中的 BackingStore，供测试使用：可以模拟每批写入的延迟，以及让接下来的若干批写入失败
+****************************************/
+template<typename Key, typename Value>
+class MemoryBackingStore : public BackingStore<Key, Value> {
+public:
+	explicit MemoryBackingStore(std::chrono::microseconds writeLatency = std::chrono::microseconds(0))
+		: _writeLatency(writeLatency) {}
+
+	bool read(const Key& key, Value& value) override {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _data.find(key);
+		if (it == _data.end()) return false;
+		value = it->second;
+		return true;
+	}
+	bool writeBatch(const std::vector<std::pair<Key, Value>>& entries) override {
+		if (_writeLatency.count() > 0) std::this_thread::sleep_for(_writeLatency);
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_failuresLeft > 0) {
+			--_failuresLeft;
+			return false;
+		}
+		for (const auto& entry : entries) {
+			_data[entry.first] = entry.second;
+			++_writesPerKey[entry.first];
+		}
+		++_batches;
+		_entries += entries.size();
+		return true;
+	}
+
+	/**
+	* 接下来的 count 批写入返回失败
+	*/
+	void failNextWrites(int count) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_failuresLeft = count;
+	}
+	uint64_t batches() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _batches;
+	}
+	uint64_t entriesWritten() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _entries;
+	}
+	uint64_t writesOf(const Key& key) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _writesPerKey.find(key);
+		return it == _writesPerKey.end() ? 0 : it->second;
+	}
+	size_t size() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _data.size();
+	}
+
+private:
+	std::mutex _mutex;
+	std::chrono::microseconds _writeLatency;
+	std::unordered_map<Key, Value> _data;
+	std::unordered_map<Key, uint64_t> _writesPerKey;
+	int _failuresLeft = 0;
+	uint64_t _batches = 0;
+	uint64_t _entries = 0;
+};
+
+/**
+* 写回参数
+*/
+struct WriteBackOptions {
+	// 脏数据最长停留时间，超过后由后台线程写回
+	std::chrono::milliseconds maxDirtyAge{ 100 };
+	// 脏数据总字节数超过该值时立即写回
+	size_t dirtyBytesThreshold = 1 << 20;
+	// 每批最多写回的条目数
+	size_t batchSize = 128;
+	// 写回失败后的重试间隔，每次失败翻倍，不超过 maxRetryDelay
+	std::chrono::milliseconds retryDelay{ 10 };
+	std::chrono::milliseconds maxRetryDelay{ 1000 };
+};
+
+/****************************************
+WriteBackCache
+
+写回模式的 LRUCache：put 只写缓存并把 key 标记为脏，由后台线程分批写入 BackingStore。
+	合并：同一 key 在写回之前的多次 put 只写回最后一个值；
+	触发：最老的脏数据超过 maxDirtyAge、脏数据字节数超过阈值、脏条目被 LRU 淘汰、调用 flush；
+	顺序：按 key 第一次变脏的先后写回，最老的先写，同一批内每个 key 只出现一次；
+	失败：整批保留为脏并按指数退避重试，直到成功，期间新的 put 继续合并，读取仍能看到脏值；
+	写回过程中 key 又被 put 时，写回成功后它仍是脏的，排到队尾等待下一次写回。
+被淘汰但尚未写回的脏条目仍可以通过 get 读到。析构时停止后台线程并尝试写回全部脏数据一次。
+****************************************/
+template<typename Key, typename Value>
+class WriteBackCache {
+public:
+	struct Stats {
+		uint64_t puts = 0;
+		uint64_t coalescedWrites = 0;		// 覆盖了尚未写回的脏值的 put
+		uint64_t flushedEntries = 0;
+		uint64_t flushBatches = 0;
+		uint64_t failedBatches = 0;
+		uint64_t dirtyEvictions = 0;		// 被 LRU 淘汰时仍是脏的条目
+		size_t dirtyEntries = 0;
+		size_t dirtyBytes = 0;
+	};
+
+	WriteBackCache(int capacity, BackingStore<Key, Value>& store, WriteBackOptions options = WriteBackOptions(),
+		std::function<size_t(const Key&, const Value&)> sizeOf = nullptr)
+		: _cache(capacity), _store(store), _options(options), _sizeOf(std::move(sizeOf)) {
+		if (_options.batchSize == 0) _options.batchSize = 1;
+		_cache.setEvictionCallback([this](const Key& key, const Value&) { onEvict(key); });
+		_flusher = std::thread([this]() { flusherLoop(); });
+	}
+	~WriteBackCache() {
+		{
+			std::lock_guard<std::mutex> lock(_dirtyMutex);
+			_stopping = true;
+		}
+		_wakeup.notify_one();
+		_flusher.join();
+		flushRound(true);
+	}
+	WriteBackCache(const WriteBackCache&) = delete;
+	WriteBackCache& operator=(const WriteBackCache&) = delete;
+
+	bool get(Key key, Value& value) {
+		if (_cache.get(key, value)) return true;
+		// 回填与 put 持同一把分片锁，否则读出的旧值可能在并发 put 之后才写入缓存
+		std::lock_guard<std::mutex> keyGuard(keyLock(key));
+		{
+			// 已被淘汰但还没写回的脏值
+			std::lock_guard<std::mutex> lock(_dirtyMutex);
+			auto it = _dirty.find(key);
+			if (it != _dirty.end()) {
+				value = it->second.value;
+				return true;
+			}
+		}
+		if (!_store.read(key, value)) return false;
+		_cache.putIfAbsent(key, value);
+		return true;
+	}
+	Value get(Key key) {
+		Value value{};
+		get(key, value);
+		return value;
+	}
+
+	void put(Key key, Value value) {
+		// 同一 key 的 put 串行：缓存与脏表按同样的顺序更新，最后一次 put 的值在两边都生效。
+		// 不能直接持 _dirtyMutex，缓存淘汰回调 onEvict 需要它
+		std::lock_guard<std::mutex> keyGuard(keyLock(key));
+		_cache.put(key, value);
+		bool wake = false;
+		{
+			std::lock_guard<std::mutex> lock(_dirtyMutex);
+			++_stats.puts;
+			auto it = _dirty.find(key);
+			if (it != _dirty.end()) {
+				DirtyEntry& entry = it->second;
+				_dirtyBytes -= entry.bytes;
+				entry.value = value;
+				entry.bytes = bytesOf(key, value);
+				_dirtyBytes += entry.bytes;
+				++entry.version;
+				++_stats.coalescedWrites;
+				// 重新写入了缓存，不再算作被淘汰
+				if (entry.evicted) {
+					entry.evicted = false;
+					--_evictedDirty;
+				}
+			}
+			else {
+				DirtyEntry entry{ value, bytesOf(key, value), 1, _nextSeq++, std::chrono::steady_clock::now(), false };
+				_dirtyBytes += entry.bytes;
+				_order.emplace(entry.seq, key);
+				_dirty.emplace(key, std::move(entry));
+			}
+			wake = _dirtyBytes > _options.dirtyBytesThreshold;
+		}
+		if (wake) _wakeup.notify_one();
+	}
+
+	/**
+	* 在调用线程中写回全部脏数据，某一批失败时立即返回 false（不在这里重试）
+	*/
+	bool flush() {
+		return flushRound(true);
+	}
+
+	Stats getStats() {
+		std::lock_guard<std::mutex> lock(_dirtyMutex);
+		Stats stats = _stats;
+		stats.dirtyEntries = _dirty.size();
+		stats.dirtyBytes = _dirtyBytes;
+		return stats;
+	}
+
+private:
+	struct DirtyEntry {
+		Value value;
+		size_t bytes;
+		uint64_t version;			// 每次 put 加 1，写回成功时用来判断期间是否又被改写
+		uint64_t seq;				// 在写回顺序中的位置
+		std::chrono::steady_clock::time_point since;
+		bool evicted;				// 已被 LRU 淘汰，只剩这里的一份
+	};
+
+	static constexpr size_t kKeyLocks = 64;
+
+	std::mutex& keyLock(const Key& key) {
+		return _keyLocks[std::hash<Key>()(key) % kKeyLocks];
+	}
+
+	size_t bytesOf(const Key& key, const Value& value) const {
+		return _sizeOf ? _sizeOf(key, value) : sizeof(Key) + sizeof(Value);
+	}
+
+	void onEvict(const Key& key) {
+		{
+			std::lock_guard<std::mutex> lock(_dirtyMutex);
+			auto it = _dirty.find(key);
+			if (it == _dirty.end() || it->second.evicted) return;
+			it->second.evicted = true;
+			++_stats.dirtyEvictions;
+			++_evictedDirty;
+		}
+		_wakeup.notify_one();
+	}
+
+	/**
+	* 是否需要立即写回；调用者持有 _dirtyMutex
+	*/
+	bool flushDue(std::chrono::steady_clock::time_point now) const {
+		if (_order.empty()) return false;
+		if (_evictedDirty > 0 || _dirtyBytes > _options.dirtyBytesThreshold) return true;
+		return now - _dirty.at(_order.begin()->second).since >= _options.maxDirtyAge;
+	}
+
+	/**
+	* 写回一批或多批。all 为 true 时写回全部脏数据，否则写到不再满足触发条件为止。
+	* 返回是否没有失败
+	*/
+	bool flushRound(bool all) {
+		std::lock_guard<std::mutex> flushLock(_flushMutex);
+		for (;;) {
+			std::vector<std::pair<Key, Value>> batch;
+			std::vector<uint64_t> versions;
+			{
+				std::lock_guard<std::mutex> lock(_dirtyMutex);
+				if (_order.empty() || (!all && !flushDue(std::chrono::steady_clock::now()))) return true;
+				for (auto it = _order.begin(); it != _order.end() && batch.size() < _options.batchSize; ++it) {
+					const DirtyEntry& entry = _dirty.at(it->second);
+					batch.emplace_back(it->second, entry.value);
+					versions.push_back(entry.version);
+				}
+			}
+			// 写回期间不持锁，put 与 get 照常进行
+			bool ok = _store.writeBatch(batch);
+			std::lock_guard<std::mutex> lock(_dirtyMutex);
+			if (!ok) {
+				++_stats.failedBatches;
+				return false;
+			}
+			++_stats.flushBatches;
+			_stats.flushedEntries += batch.size();
+			for (size_t i = 0; i < batch.size(); ++i) {
+				auto it = _dirty.find(batch[i].first);
+				DirtyEntry& entry = it->second;
+				_order.erase(entry.seq);
+				if (entry.version != versions[i]) {
+					// 写回期间又被改写：仍是脏的，排到队尾
+					entry.seq = _nextSeq++;
+					entry.since = std::chrono::steady_clock::now();
+					_order.emplace(entry.seq, it->first);
+					continue;
+				}
+				if (entry.evicted) --_evictedDirty;
+				_dirtyBytes -= entry.bytes;
+				_dirty.erase(it);
+			}
+		}
+	}
+
+	void flusherLoop() {
+		auto retryDelay = _options.retryDelay;
+		std::unique_lock<std::mutex> lock(_dirtyMutex);
+		while (!_stopping) {
+			auto now = std::chrono::steady_clock::now();
+			if (!flushDue(now)) {
+				// 等到最老的脏数据到期，或被 put/淘汰唤醒
+				auto deadline = _order.empty() ? now + _options.maxDirtyAge
+					: _dirty.at(_order.begin()->second).since + _options.maxDirtyAge;
+				_wakeup.wait_until(lock, deadline);
+				continue;
+			}
+			lock.unlock();
+			bool ok = flushRound(false);
+			lock.lock();
+			if (ok) {
+				retryDelay = _options.retryDelay;
+				continue;
+			}
+			// 失败：退避后重试，停止时不再等待
+			_wakeup.wait_for(lock, retryDelay, [this]() { return _stopping; });
+			retryDelay = std::min(retryDelay * 2, _options.maxRetryDelay);
+		}
+	}
+
+	LRUCache<Key, Value> _cache;
+	BackingStore<Key, Value>& _store;
+	WriteBackOptions _options;
+	std::function<size_t(const Key&, const Value&)> _sizeOf;
+
+	// 按 key 分片的锁，串行化同一 key 的 put 与缓存回填；加锁顺序为 分片锁 -> _dirtyMutex
+	std::mutex _keyLocks[kKeyLocks];
+	std::mutex _dirtyMutex;
+	std::unordered_map<Key, DirtyEntry> _dirty;
+	// 写回顺序：seq -> key，seq 越小越早变脏
+	std::map<uint64_t, Key> _order;
+	uint64_t _nextSeq = 0;
+	size_t _dirtyBytes = 0;
+	// 被淘汰且尚未写回的脏条目数，非 0 时后台线程立即按顺序写回，直到它们都写完
+	size_t _evictedDirty = 0;
+	Stats _stats;
+
+	// 串行化写回，后台线程与 flush 不会同时写同一批
+	std::mutex _flushMutex;
+	std::condition_variable _wakeup;
+	bool _stopping = false;
+	std::thread _flusher;
+};
+
+#endif // WRITEBACKCACHE_H
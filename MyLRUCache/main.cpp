@@ -1,11 +1,43 @@
+#include "AdaptiveCache.h"
 #include "ARCCache.h"
+#include "ArenaLRUCache.h"
+#include "AsyncCache.h"
+#include "CompressedLRUCache.h"
+#include "DecayLFUCache.h"
+#include "FlatHashMap.h"
+#include "FrontCache.h"
+#include "GDSFCache.h"
 #include "LRUCache.h"
 #include "LFUCache.h"
 #include "Random.h"
+#include "S3FIFOCache.h"
+#include "SampledLRUCache.h"
+#include "SieveCache.h"
+#include "ShmLRUCache.h"
+#include "SoACache.h"
+#include "StaticLRUCache.h"
+#include "TieredCache.h"
+#include "WriteBackCache.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
 #include <iostream>
 #include <memory>
 #include <random>
+#include <thread>
 #include <unordered_map>
+#include <vector>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#ifdef SHMLRUCACHE_SUPPORTED
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -78,9 +110,1690 @@ void testHashList() {
 	}
 }
 
+void testProfiler() {
+	using Key = int;
+	using Value = int;
+	const int threadNum = 4;
+	const int opsPerThread = 200000;
+	const int sliceNum = 8;
+
+	HashLRUCache<Key, Value> cache(1024, sliceNum);
+	auto profiler = make_shared<CacheProfiler>(16);
+	cache.setProfiler(profiler);
+
+	vector<thread> workers;
+	for (int t = 0; t < threadNum; ++t) {
+		workers.emplace_back([&cache, t]() {
+			// Random::get 共用一个全局引擎，不能多线程调用，每个线程用自己的引擎
+			mt19937 rng(20240u + t);
+			uniform_int_distribution<int> hotDist(0, 7), coldDist(0, 4096);
+			for (int i = 0; i < opsPerThread; ++i) {
+				// 一半请求落在 8 个热点 key 上；它们都是 sliceNum 的倍数，同属 0 号分片，制造分片倾斜
+				Key key = (i % 2 == 0) ? hotDist(rng) * sliceNum : coldDist(rng);
+				Value value{};
+				if (!cache.get(key, value)) {
+					cache.put(key, key);
+				}
+			}
+		});
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	cout << "========== Latency ==========" << endl;
+	profiler->printSummary(cout);
+	cout << "========== Shards ==========" << endl;
+	auto shardStats = cache.getShardLockStats();
+	for (size_t i = 0; i < shardStats.size(); ++i) {
+		cout << "Shard " << i << ": acquisitions=" << shardStats[i].acquisitions
+			<< " contended=" << shardStats[i].contentionRate() * 100 << "%"
+			<< " meanHold=" << shardStats[i].meanHoldNs() << "ns" << endl;
+	}
+}
+
+void testSnapshot() {
+	using Key = int;
+	using Value = std::string;
+	const int cacheSize = 1000;
+	const string path = "cache_snapshot.bin";
+
+	// LRU：重启后访问顺序不变
+	LRUCache<Key, Value> lru(cacheSize);
+	for (int i = 0; i < cacheSize * 2; ++i) {
+		lru.put(Random::get(0, cacheSize * 3), "value_" + to_string(i));
+	}
+	LRUCache<Key, Value> lruRestored(cacheSize);
+	bool lruOk = lru.saveSnapshot(path) && lruRestored.loadSnapshot(path)
+		&& lru.exportEntries() == lruRestored.exportEntries();
+	cout << "LRU snapshot: " << (lruOk ? "OK" : "FAILED") << endl;
+
+	// HashLRU：分片数变化也可以加载
+	HashLRUCache<Key, Value> hashLru(cacheSize, 4);
+	for (int i = 0; i < cacheSize; ++i) {
+		hashLru.put(i, "value_" + to_string(i));
+	}
+	HashLRUCache<Key, Value> hashLruRestored(cacheSize, 8);
+	bool hashOk = hashLru.saveSnapshot(path) && hashLruRestored.loadSnapshot(path);
+	int hashHits = 0;
+	for (int i = 0; i < cacheSize; ++i) {
+		Value v;
+		if (hashLruRestored.get(i, v) && v == "value_" + to_string(i)) ++hashHits;
+	}
+	cout << "HashLRU snapshot: " << (hashOk ? "OK" : "FAILED") << ", restored " << hashHits << " entries" << endl;
+
+	// LFU：频数保留
+	LFUCache<Key, Value> lfu(cacheSize);
+	for (int i = 0; i < cacheSize * 5; ++i) {
+		Key key = Random::get(0, cacheSize * 2);
+		if (lfu.get(key).empty()) lfu.put(key, "value_" + to_string(key));
+	}
+	LFUCache<Key, Value> lfuRestored(cacheSize);
+	bool lfuOk = lfu.saveSnapshot(path) && lfuRestored.loadSnapshot(path)
+		&& lfu.exportEntries() == lfuRestored.exportEntries();
+	cout << "LFU snapshot: " << (lfuOk ? "OK" : "FAILED") << endl;
+
+	// ARC：T1/T2/ghost 状态保留
+	ARCCache<Key, Value> arc(cacheSize, 2);
+	for (int i = 0; i < cacheSize * 5; ++i) {
+		Key key = Random::get(0, cacheSize * 2);
+		if (arc.get(key).empty()) arc.put(key, "value_" + to_string(key));
+	}
+	ARCCache<Key, Value> arcRestored(cacheSize, 2);
+	bool arcOk = arc.saveSnapshot(path) && arcRestored.loadSnapshot(path);
+	cout << "ARC snapshot: " << (arcOk ? "OK" : "FAILED") << endl;
+
+	// 加载速度
+	const int bigSize = 1000000;
+	LRUCache<Key, Key> big(bigSize);
+	for (int i = 0; i < bigSize; ++i) {
+		big.put(i, i);
+	}
+	big.saveSnapshot(path);
+	LRUCache<Key, Key> bigRestored(bigSize);
+	auto begin = chrono::steady_clock::now();
+	bool bigOk = bigRestored.loadSnapshot(path);
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+	cout << "Reload " << bigSize << " entries: " << (bigOk ? "OK" : "FAILED") << ", "
+		<< bigSize / seconds / 1e6 << "M entries/s" << endl;
+	std::remove(path.c_str());
+}
+
+void testArenaCache() {
+	const int cacheSize = 100000;
+	const int keySpace = 300000;
+	HashArenaLRUCache arena(cacheSize, 8);
+	LRUCache<string, string> reference(cacheSize);
+
+	// 与 LRUCache<string, string> 对拍
+	int mismatch = 0;
+	for (int i = 0; i < cacheSize * 10; ++i) {
+		string key = "user:" + to_string(Random::get(0, keySpace));
+		string expected, actual;
+		bool inArena = arena.get(key, actual);
+		if (inArena) {
+			string value = "profile-" + key;
+			if (actual != value) ++mismatch;
+		}
+		else {
+			arena.put(key, "profile-" + key);
+		}
+		if (!reference.get(key, expected)) {
+			reference.put(key, "profile-" + key);
+		}
+	}
+	size_t entries = arena.size();
+	cout << "Arena entries: " << entries << ", value mismatches: " << mismatch << endl;
+	cout << "Metadata per entry: " << static_cast<double>(arena.metadataBytes()) / static_cast<double>(entries) << " bytes" << endl;
+	cout << "Arena pages: " << arena.arenaBytes() / 1024 << " KB" << endl;
+
+	// 内存上限下混合大小：页已被小条目占满时，大条目写入失败，但不能为此清空其他级别的条目
+	ArenaLRUCache limited(cacheSize, 2 << 20);
+	for (int i = 0; i < 32768; ++i) limited.put("small:" + to_string(i), string(20, 's'));
+	size_t smallEntries = limited.size();
+	int mediumWritten = 0;
+	for (int i = 0; i < 10000; ++i) mediumWritten += limited.put("medium:" + to_string(i), string(200, 'm'));
+	size_t afterMedium = limited.size();
+	bool largeWritten = limited.put("large", string(5000, 'l'));
+	string probe;
+	bool smallKept = limited.get("small:32767", probe) && probe == string(20, 's');
+	cout << "Arena 2 MiB limit: small entries " << smallEntries << ", medium written " << mediumWritten << ", size after medium "
+		<< afterMedium << ", large written " << largeWritten << ", size " << limited.size() << ", newest small kept " << smallKept << endl;
+
+	// 已满时写入超过最大级别的条目：写入失败，不能为它淘汰已有条目
+	ArenaLRUCache full(4);
+	for (int i = 0; i < 4; ++i) full.put("key:" + to_string(i), "value");
+	bool hugeWritten = full.put("huge", string(SlabArena::kMaxChunkSize + 1, 'h'));
+	bool oldestKept = full.get("key:0", probe);
+	cout << "Arena full, oversized put: written " << hugeWritten << ", size " << full.size() << "/4, oldest kept " << oldestKept << endl;
+}
+
+void testTieredCache() {
+	using Key = int;
+	using Value = std::string;
+	const int ramSize = 1000;
+	const int keySpace = 10000;
+	const int totalData = 200000;
+
+	LRUCache<Key, Value> ramOnly(ramSize);
+	// 段大小故意设小，验证 FIFO 回收
+	TieredLRUCache<Key, Value> tiered(ramSize, "tiered_cache_test", 256 * 1024, 8);
+
+	int ramOnlyMiss = 0;
+	int wrongValue = 0;
+	for (int i = 0; i < totalData; ++i) {
+		Key key = Random::get(0, keySpace);
+		Value expected = "payload-" + to_string(key);
+		Value value;
+		if (!ramOnly.get(key, value)) {
+			++ramOnlyMiss;
+			ramOnly.put(key, expected);
+		}
+		if (tiered.get(key, value)) {
+			if (value != expected) ++wrongValue;
+		}
+		else {
+			tiered.put(key, expected);
+		}
+	}
+	auto stats = tiered.getStats();
+	cout << "RAM only hit rate: " << (totalData - ramOnlyMiss) * 100.0 / totalData << "%" << endl;
+	cout << "Tiered: ram hits=" << stats.ramHits << " disk hits=" << stats.diskHits << " misses=" << stats.misses
+		<< " hit rate=" << (stats.ramHits + stats.diskHits) * 100.0 / totalData << "%" << endl;
+	cout << "Disk tier: entries=" << stats.diskEntries << " bytes=" << stats.diskBytes
+		<< " reclaimed segments=" << stats.reclaimedSegments << " wrong values=" << wrongValue << endl;
+	std::filesystem::remove_all("tiered_cache_test");
+
+	// 并发：每个线程只写自己的 key，其他线程的写入不断把它们淘汰落盘；删除后不能再读到，覆盖后不能读到旧值
+	TieredLRUCache<Key, Value> shared(64, "tiered_cache_race", 256 * 1024, 8);
+	atomic<int> resurrected{ 0 }, stale{ 0 };
+	vector<thread> workers;
+	for (int t = 0; t < 4; ++t) {
+		workers.emplace_back([&shared, &resurrected, &stale, t]() {
+			for (int i = 0; i < 20000; ++i) {
+				Key key = t * 1000 + i % 200;
+				Value value;
+				shared.put(key, "v" + to_string(i));
+				shared.get(key + 500, value);
+				if (i % 3 == 0) {
+					shared.remove(key);
+					if (shared.get(key, value)) ++resurrected;
+				}
+				else if (shared.get(key, value) && value != "v" + to_string(i)) {
+					++stale;
+				}
+			}
+		});
+	}
+	for (auto& worker : workers) worker.join();
+	cout << "Concurrent tiered: resurrected after remove=" << resurrected << " stale after put=" << stale << endl;
+	std::filesystem::remove_all("tiered_cache_race");
+}
+
+void testCompressedCache() {
+	const int keySpace = 20000;
+	const int totalData = 200000;
+	const uint64_t budget = 8ull * 1024 * 1024;
+
+	auto makeValue = [](int key) {
+		string v = "{\"id\":" + to_string(key) + ",\"items\":[";
+		for (int i = 0; i < 12; ++i) {
+			v += "{\"sku\":\"item-" + to_string(key % 97 + i) + "\",\"price\":" + to_string(100 + i) + ",\"status\":\"available\"},";
+		}
+		v += "{}]}";
+		return v;
+	};
+
+	// 编解码往返
+	int codecErrors = 0;
+	for (int i = 0; i < 1000; ++i) {
+		string raw = makeValue(i), decoded;
+		if (!LZCodec::decompress(LZCodec::compress(raw), decoded) || decoded != raw) ++codecErrors;
+	}
+	cout << "Codec round-trip errors: " << codecErrors << endl;
+
+	// 相同字节预算下，hotFraction=1 相当于不压缩
+	CompressedLRUCache<int> raw(budget, 1.0, false);
+	CompressedLRUCache<int> compressed(budget, 0.25);
+	int wrongValue = 0;
+	for (int i = 0; i < totalData; ++i) {
+		int key = Random::get(0, keySpace);
+		string value;
+		if (!raw.get(key, value)) raw.put(key, makeValue(key));
+		if (compressed.get(key, value)) {
+			if (value != makeValue(key)) ++wrongValue;
+		}
+		else {
+			compressed.put(key, makeValue(key));
+		}
+	}
+	compressed.compressPending();
+	auto rawStats = raw.getStats();
+	auto stats = compressed.getStats();
+	cout << "Raw: entries=" << rawStats.entries << " hit rate=" << (rawStats.hotHits + rawStats.coldHits) * 100.0 / totalData << "%" << endl;
+	cout << "Compressed: entries=" << stats.entries << " hit rate=" << (stats.hotHits + stats.coldHits) * 100.0 / totalData << "%"
+		<< " hot hits=" << stats.hotHits << " cold hits=" << stats.coldHits << endl;
+	cout << "Compressed entries=" << stats.compressedEntries << " ratio=" << stats.compressionRatio()
+		<< " wrong values=" << wrongValue << endl;
+	// 不启动后台线程且从不调用 compressPending：反复降级与淘汰后待压缩队列仍有上限
+	CompressedLRUCache<int> manual(256 * 1024, 0.25, false);
+	size_t maxPending = 0;
+	for (int i = 0; i < totalData; ++i) {
+		int key = Random::get(0, keySpace);
+		string value;
+		if (!manual.get(key, value)) manual.put(key, makeValue(key));
+		if (i % 1000 == 0) maxPending = max(maxPending, manual.getStats().pendingEntries);
+	}
+	auto manualStats = manual.getStats();
+	cout << "Manual compression: entries=" << manualStats.entries << " max pending=" << maxPending
+		<< " evictions=" << manualStats.evictions << endl;
+}
+
+// 随机查找的平均耗时（纳秒），一半命中一半未命中
+template<typename Map>
+double benchmarkLookup(size_t entries, size_t lookups) {
+	auto keyOf = [](uint64_t i) {
+		i = (i ^ (i >> 30)) * 0xBF58476D1CE4E5B9ull;
+		i = (i ^ (i >> 27)) * 0x94D049BB133111EBull;
+		return i ^ (i >> 31);
+	};
+	Map map;
+	map.reserve(entries);
+	for (size_t i = 0; i < entries; ++i) {
+		map[keyOf(i)] = i;
+	}
+	mt19937_64 rng(42);
+	vector<uint64_t> keys(lookups);
+	for (size_t i = 0; i < lookups; ++i) {
+		uint64_t index = rng() % entries;
+		keys[i] = keyOf((i & 1) ? index : entries + index);
+	}
+	size_t found = 0;
+	auto begin = chrono::steady_clock::now();
+	for (int round = 0; round < 4; ++round) {
+		for (uint64_t key : keys) {
+			auto it = map.find(key);
+			if (it != map.end()) found += it->second;
+		}
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+	if (found == 1) cout << "";
+	return seconds * 1e9 / static_cast<double>(lookups * 4);
+}
+
+/**
+* includeHuge 为 true 时加入 1 亿条目的规模，std::unordered_map 需要约 6GB 内存
+*/
+void testFlatHashMap(bool includeHuge = false) {
+	// 正确性：与 std::unordered_map 对拍随机插入/删除
+	FlatHashMap<int, int> flat;
+	unordered_map<int, int> reference;
+	int mismatch = 0;
+	for (int i = 0; i < 1000000; ++i) {
+		int key = Random::get(0, 50000);
+		int op = Random::get(0, 2);
+		if (op == 0) {
+			flat[key] = i;
+			reference[key] = i;
+		}
+		else if (op == 1) {
+			if (flat.erase(key) != reference.erase(key)) ++mismatch;
+		}
+		else {
+			auto it = flat.find(key);
+			auto ref = reference.find(key);
+			if ((it == flat.end()) != (ref == reference.end()) || (ref != reference.end() && it->second != ref->second)) ++mismatch;
+		}
+	}
+	if (flat.size() != reference.size()) ++mismatch;
+	cout << "FlatHashMap mismatches: " << mismatch << endl;
+
+	vector<size_t> sizes = { 1000, 1000000 };
+	if (includeHuge) sizes.push_back(100000000);
+	const size_t lookups = 1000000;
+	for (size_t entries : sizes) {
+		double stdNs = benchmarkLookup<unordered_map<uint64_t, uint64_t>>(entries, lookups);
+		double flatNs = benchmarkLookup<FlatHashMap<uint64_t, uint64_t>>(entries, lookups);
+		cout << entries << " entries: unordered_map " << stdNs << " ns, FlatHashMap " << flatNs << " ns per lookup" << endl;
+	}
+}
+
+// Zipf 分布的访问序列，skew 越大热点越集中
+vector<int> makeZipfTrace(int keySpace, int length, double skew, uint32_t seed) {
+	vector<double> cdf(keySpace);
+	double sum = 0;
+	for (int i = 0; i < keySpace; ++i) {
+		sum += 1.0 / pow(i + 1, skew);
+		cdf[i] = sum;
+	}
+	mt19937 rng(seed);
+	uniform_real_distribution<double> dist(0, sum);
+	vector<int> trace(length);
+	for (int& key : trace) {
+		key = static_cast<int>(lower_bound(cdf.begin(), cdf.end(), dist(rng)) - cdf.begin());
+	}
+	return trace;
+}
+
+// 按序回放，未命中时写入，返回命中率（%）
+template<typename Cache>
+double replayHitRate(Cache& cache, const vector<int>& trace) {
+	int hits = 0;
+	for (int key : trace) {
+		int value = 0;
+		if (cache.get(key, value)) ++hits;
+		else cache.put(key, key);
+	}
+	return hits * 100.0 / static_cast<double>(trace.size());
+}
+
+// 多线程只读命中吞吐（百万次/秒）
+template<typename Cache>
+double hitThroughput(Cache& cache, int keySpace, int threads) {
+	for (int key = 0; key < keySpace; ++key) cache.put(key, key);
+	const int perThread = 2000000;
+	atomic<long long> sink{ 0 };
+	auto begin = chrono::steady_clock::now();
+	vector<thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		workers.emplace_back([&cache, &sink, keySpace, t]() {
+			long long local = 0;
+			uint32_t x = 2463534242u + t;
+			for (int i = 0; i < perThread; ++i) {
+				x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+				int value = 0;
+				if (cache.get(static_cast<int>(x % keySpace), value)) local += value;
+			}
+			sink += local;
+		});
+	}
+	for (auto& worker : workers) worker.join();
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+	return perThread * static_cast<double>(threads) / seconds / 1e6;
+}
+
+void testPolicyComparison() {
+	const int cacheSize = 1000;
+	const int keySpace = 20000;
+	const int length = 500000;
+	struct Workload {
+		const char* name;
+		vector<int> trace;
+	};
+	vector<Workload> workloads;
+	workloads.push_back({ "zipf 0.8", makeZipfTrace(keySpace, length, 0.8, 1) });
+	workloads.push_back({ "zipf 1.0", makeZipfTrace(keySpace, length, 1.0, 2) });
+	// Zipf 中夹杂一次性顺序扫描
+	vector<int> scan = makeZipfTrace(keySpace, length, 0.9, 3);
+	for (int i = 0; i < length; i += 50000) {
+		for (int j = 0; j < 5000 && i + j < length; ++j) scan[i + j] = keySpace + i + j;
+	}
+	workloads.push_back({ "zipf 0.9 + scan", scan });
+
+	for (const auto& workload : workloads) {
+		LRUCache<int, int> lru(cacheSize);
+		LFUCache<int, int> lfu(cacheSize);
+		ARCCache<int, int> arc(cacheSize, 2);
+		SieveCache<int, int> sieve(cacheSize);
+		S3FIFOCache<int, int> s3fifo(cacheSize);
+		cout << workload.name << ": LRU " << replayHitRate(lru, workload.trace) << "%"
+			<< ", LFU " << replayHitRate(lfu, workload.trace) << "%"
+			<< ", ARC " << replayHitRate(arc, workload.trace) << "%"
+			<< ", SIEVE " << replayHitRate(sieve, workload.trace) << "%"
+			<< ", S3-FIFO " << replayHitRate(s3fifo, workload.trace) << "%" << endl;
+	}
+
+	int threads = max(2, static_cast<int>(thread::hardware_concurrency()));
+	HashLRUCache<int, int> hashLru(100000, 16);
+	HashSieveCache<int, int> hashSieve(100000, 16);
+	HashS3FIFOCache<int, int> hashS3fifo(100000, 16);
+	cout << threads << " threads hit throughput: HashLRU " << hitThroughput(hashLru, 50000, threads) << "M/s"
+		<< ", HashSIEVE " << hitThroughput(hashSieve, 50000, threads) << "M/s"
+		<< ", HashS3-FIFO " << hitThroughput(hashS3fifo, 50000, threads) << "M/s" << endl;
+
+	// 单线程混合读写（按序回放并在未命中时写入）的吞吐
+	const auto& trace = workloads.back().trace;
+	auto replayThroughput = [&trace](auto& cache) {
+		auto begin = chrono::steady_clock::now();
+		replayHitRate(cache, trace);
+		return trace.size() / chrono::duration<double>(chrono::steady_clock::now() - begin).count() / 1e6;
+	};
+	LRUCache<int, int> lru(cacheSize);
+	ARCCache<int, int> arc(cacheSize, 2);
+	SieveCache<int, int> sieve(cacheSize);
+	S3FIFOCache<int, int> s3fifo(cacheSize);
+	cout << "Replay throughput: LRU " << replayThroughput(lru) << "M/s, ARC " << replayThroughput(arc)
+		<< "M/s, SIEVE " << replayThroughput(sieve) << "M/s, S3-FIFO " << replayThroughput(s3fifo) << "M/s" << endl;
+}
+
+void testResize() {
+	using Key = int;
+	using Value = int;
+	const int bigSize = 100000;
+	const int smallSize = 10000;
+
+	// 单个缓存缩容/扩容
+	LRUCache<Key, Value> lru(bigSize);
+	LFUCache<Key, Value> lfu(bigSize);
+	AlignLFUCache<Key, Value> alignLfu(bigSize, 10);
+	ARCCache<Key, Value> arc(bigSize, 2);
+	for (int i = 1; i <= bigSize; ++i) {
+		lru.put(i, i);
+		lfu.put(i, i);
+		alignLfu.put(i, i);
+		arc.put(i, i);
+	}
+	lru.setCapacity(smallSize);
+	lfu.setCapacity(smallSize);
+	alignLfu.setCapacity(smallSize);
+	arc.setCapacity(smallSize);
+	int lruNewest = 0;
+	for (int i = bigSize - smallSize + 1; i <= bigSize; ++i) {
+		if (lru.get(i) == i) ++lruNewest;
+	}
+	cout << "LRU after shrink: size=" << lru.size() << ", newest entries kept=" << lruNewest << endl;
+	cout << "LFU after shrink: size=" << lfu.size() << endl;
+	lru.setCapacity(bigSize);
+	for (int i = 1; i <= bigSize; ++i) lru.put(i, i);
+	cout << "LRU after grow: size=" << lru.size() << endl;
+
+	// HashLRUCache：读写并发进行时调整容量与分片数
+	HashLRUCache<Key, Value> hashLru(bigSize, 4);
+	atomic<bool> stop{ false };
+	atomic<long long> wrongValue{ 0 };
+	atomic<long long> operations{ 0 };
+	vector<thread> workers;
+	for (int t = 0; t < 2; ++t) {
+		workers.emplace_back([&, t]() {
+			uint32_t x = 12345u + t;
+			while (!stop) {
+				x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+				Key key = static_cast<Key>(x % (bigSize * 2)) + 1;
+				Value value = 0;
+				if (hashLru.get(key, value)) {
+					if (value != key * 2) ++wrongValue;
+				}
+				else {
+					hashLru.put(key, key * 2);
+				}
+				++operations;
+			}
+		});
+	}
+	this_thread::sleep_for(chrono::milliseconds(200));
+	auto begin = chrono::steady_clock::now();
+	hashLru.setSliceNum(16);
+	hashLru.setCapacity(smallSize);
+	hashLru.setSliceNum(3);
+	hashLru.setCapacity(bigSize / 2);
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+	this_thread::sleep_for(chrono::milliseconds(200));
+	stop = true;
+	for (auto& worker : workers) worker.join();
+	cout << "HashLRU resize under load: " << seconds * 1000 << " ms, shards=" << hashLru.getSliceNum()
+		<< ", size=" << hashLru.size() << "/" << hashLru.getCapacity()
+		<< ", operations=" << operations << ", wrong values=" << wrongValue << endl;
+
+	// 迁移与删除并发：迁移搬动 key 的同时删除它，删除后的 key 不能被搬回新表
+	HashLRUCache<Key, Value> migrating(bigSize, 4);
+	for (int i = 1; i <= smallSize; ++i) migrating.put(i, i);
+	thread resizer([&migrating]() { migrating.setSliceNum(16); });
+	thread reader([&migrating, smallSize]() {
+		Value value;
+		for (int i = smallSize; i >= 1; --i) migrating.get(i, value);
+	});
+	for (int i = 1; i <= smallSize; ++i) migrating.remove(i);
+	resizer.join();
+	reader.join();
+	int resurrected = 0;
+	Value value;
+	for (int i = 1; i <= smallSize; ++i) resurrected += migrating.get(i, value);
+	cout << "HashLRU remove during migration: resurrected keys " << resurrected << endl;
+
+	// ARC：ghost 命中不断在两部分间转移容量的同时调整总容量，两部分容量之和须与总容量一致（否则快照无法载入）
+	ARCCache<Key, Value> arcShifting(smallSize, 2);
+	stop = false;
+	thread churn([&arcShifting, &stop]() {
+		uint32_t x = 2463534242u;
+		Value value;
+		while (!stop) {
+			x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+			Key key = static_cast<Key>(x % (smallSize * 4)) + 1;
+			if (!arcShifting.get(key, value)) arcShifting.put(key, key);
+		}
+	});
+	for (int i = 0; i < 200; ++i) arcShifting.setCapacity(i % 2 ? smallSize : smallSize / 2 + i);
+	stop = true;
+	churn.join();
+	const string arcPath = "resize_arc.snapshot";
+	ARCCache<Key, Value> arcReloaded(arcShifting.getCapacity(), 2);
+	bool arcSaved = arcShifting.saveSnapshot(arcPath);
+	bool arcLoaded = arcSaved && arcReloaded.loadSnapshot(arcPath);
+	std::remove(arcPath.c_str());
+	cout << "ARC resize during ghost shifts: capacity " << arcShifting.getCapacity()
+		<< ", snapshot saved " << arcSaved << ", loaded " << arcLoaded << endl;
+}
+
+// 热点 key 负载：90% 的读落在 16 个 key 上，1% 的操作是写
+template<typename Cache>
+double hotKeyThroughput(Cache& cache, int threads, atomic<long long>& wrongValue) {
+	const int keySpace = 100000;
+	const int perThread = 2000000;
+	auto begin = chrono::steady_clock::now();
+	vector<thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		workers.emplace_back([&cache, &wrongValue, t]() {
+			uint32_t x = 88172645u + t;
+			for (int i = 0; i < perThread; ++i) {
+				x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+				int key = (x % 10 != 0) ? static_cast<int>(x >> 8) % 16 : static_cast<int>(x >> 8) % keySpace;
+				if (x % 100 == 0) {
+					cache.put(key, key * 3);
+					continue;
+				}
+				int value = 0;
+				if (cache.get(key, value)) {
+					if (value != key * 3) ++wrongValue;
+				}
+				else {
+					cache.put(key, key * 3);
+				}
+			}
+		});
+	}
+	for (auto& worker : workers) worker.join();
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+	return perThread * static_cast<double>(threads) / seconds / 1e6;
+}
+
+void testFrontCache() {
+	int threads = max(2, static_cast<int>(thread::hardware_concurrency()));
+	atomic<long long> wrongValue{ 0 };
+
+	HashLRUCache<int, int> plain(50000, 16);
+	double plainOps = hotKeyThroughput(plain, threads, wrongValue);
+
+	HashLRUCache<int, int> backing(50000, 16);
+	FrontCache<int, int> front(backing, 256);
+	double frontOps = hotKeyThroughput(front, threads, wrongValue);
+	auto stats = front.getStats();
+	cout << threads << " threads hot-key: HashLRU " << plainOps << "M ops/s, with FrontCache " << frontOps << "M ops/s" << endl;
+	cout << "L1 hit rate: " << stats.hitRate() * 100 << "%, stale rejects: " << stats.staleRejects
+		<< ", wrong values: " << wrongValue << endl;
+
+	// 一致性：另一个线程改写后，本线程 L1 中的旧值不能再被读到
+	int staleReads = 0;
+	for (int i = 0; i < 1000; ++i) {
+		front.put(7, i);
+		int value = -1;
+		front.get(7, value);
+		thread writer([&front, i]() { front.put(7, i + 1); });
+		writer.join();
+		if (front.get(7, value) && value != i + 1) ++staleReads;
+	}
+	cout << "Stale reads after remote put: " << staleReads << endl;
+}
+
+// 模拟耗时的后端读取，在执行器线程上阻塞 sleepMs 毫秒
+Task<int> slowLoad(int key, int sleepMs, atomic<int>& calls) {
+	++calls;
+	this_thread::sleep_for(chrono::milliseconds(sleepMs));
+	co_return key * 10;
+}
+
+template<typename Async>
+Task<int> requestKey(Async& cache, int key, typename Async::Loader loader, atomic<int>& suspended) {
+	auto before = this_thread::get_id();
+	int value = co_await cache.getAsync(key, loader);
+	if (this_thread::get_id() != before) ++suspended;
+	co_return value;
+}
+
+void testAsyncCache() {
+	ThreadPoolExecutor executor(4);
+	atomic<int> calls{ 0 };
+	atomic<int> suspended{ 0 };
+	auto loader = [&calls](int key) { return slowLoad(key, 50, calls); };
+
+	// 同一个 key 的并发未命中合并为一次加载
+	HashLRUCache<int, int> hashLru(1000, 4);
+	AsyncCache<HashLRUCache<int, int>, int, int> asyncHash(hashLru, executor);
+	atomic<int> wrongValue{ 0 };
+	vector<thread> clients;
+	for (int i = 0; i < 32; ++i) {
+		clients.emplace_back([&]() {
+			if (syncWait(requestKey(asyncHash, 42, loader, suspended)) != 420) ++wrongValue;
+		});
+	}
+	for (auto& client : clients) client.join();
+	auto stats = asyncHash.getStats();
+	cout << "32 concurrent misses: loader calls=" << calls << ", loads=" << stats.loads << ", coalesced=" << stats.coalesced
+		<< ", hits=" << stats.hits << ", suspended=" << suspended << ", wrong values=" << wrongValue << endl;
+
+	// 命中时同步完成，不挂起
+	suspended = 0;
+	int hitValue = syncWait(requestKey(asyncHash, 42, loader, suspended));
+	cout << "Hit: value=" << hitValue << ", suspended=" << suspended << endl;
+
+	// LRUCache 与 ARCCache 使用同一套接口
+	LRUCache<int, int> lru(100);
+	ARCCache<int, int> arc(100, 2);
+	AsyncCache<LRUCache<int, int>, int, int> asyncLru(lru, executor);
+	AsyncCache<ARCCache<int, int>, int, int> asyncArc(arc, executor);
+	calls = 0;
+	int sum = 0;
+	for (int key = 1; key <= 20; ++key) {
+		sum += syncWait(requestKey(asyncLru, key, [&calls](int k) { return slowLoad(k, 0, calls); }, suspended));
+		sum += syncWait(requestKey(asyncArc, key, [&calls](int k) { return slowLoad(k, 0, calls); }, suspended));
+	}
+	cout << "LRU/ARC async: sum=" << sum << ", loader calls=" << calls << endl;
+
+	// 加载失败时异常传给等待者
+	auto failing = [](int) -> Task<int> {
+		throw runtime_error("backend unavailable");
+		co_return 0;
+	};
+	try {
+		syncWait(requestKey(asyncHash, 7, failing, suspended));
+		cout << "Loader error: not propagated" << endl;
+	}
+	catch (const exception& e) {
+		cout << "Loader error: " << e.what() << endl;
+	}
+}
+
+void testAdaptiveCache() {
+	const int cacheSize = 2000;
+	const int keySpace = 50000;
+	const int phaseLength = 600000;
+	// 白天：Zipf 热点中夹杂一次性扫描，偏向频率
+	vector<int> day = makeZipfTrace(keySpace, phaseLength, 0.9, 7);
+	for (int i = 0; i < phaseLength; i += 40000) {
+		for (int j = 0; j < 4000 && i + j < phaseLength; ++j) day[i + j] = keySpace + i + j;
+	}
+	// 夜间批处理：工作集每 30000 次访问整体换一批，偏向最近访问
+	vector<int> night(phaseLength);
+	mt19937 rng(11);
+	uniform_int_distribution<int> inSet(0, cacheSize * 3 / 4);
+	for (int i = 0; i < phaseLength; ++i) {
+		night[i] = 10 * keySpace + (i / 30000) * cacheSize + inSet(rng);
+	}
+	vector<pair<const char*, const vector<int>*>> phases = { { "day", &day }, { "night", &night }, { "day again", &day } };
+
+	LRUCache<int, int> lru(cacheSize);
+	LFUCache<int, int> lfu(cacheSize);
+	AdaptiveCache<int, int> adaptive(cacheSize);
+	for (auto& phase : phases) {
+		double lruRate = replayHitRate(lru, *phase.second);
+		double lfuRate = replayHitRate(lfu, *phase.second);
+		double adaptiveRate = replayHitRate(adaptive, *phase.second);
+		auto stats = adaptive.getStats();
+		cout << phase.first << ": LRU " << lruRate << "%, LFU " << lfuRate << "%, Adaptive " << adaptiveRate
+			<< "% (window " << stats.windowRatio * 100 << "%, epochs " << stats.epochs << ", switches " << stats.switches << ")" << endl;
+		cout << "  shadow hit rates:";
+		for (size_t i = 0; i < stats.candidateRatios.size(); ++i) {
+			cout << " w" << stats.candidateRatios[i] * 100 << "%=" << stats.candidateHitRates[i] << "%";
+		}
+		cout << endl;
+	}
+
+	HashAdaptiveCache<int, int> sharded(cacheSize * 4, 4);
+	replayHitRate(sharded, night);
+	cout << "Sharded window ratios after night phase:";
+	for (auto& stats : sharded.getStats()) cout << " " << stats.windowRatio * 100 << "%";
+	cout << endl;
+}
+
+constexpr int staticCacheDemo() {
+	StaticLRUCache<int, int, 3> cache;
+	cache.put(1, 10);
+	cache.put(2, 20);
+	cache.put(3, 30);
+	cache.get(1);
+	cache.put(4, 40);	// 淘汰 2
+	cache.remove(3);
+	return cache.contains(2) || cache.contains(3) ? -1 : cache.get(1) + cache.get(4) + static_cast<int>(cache.size());
+}
+
+void testStaticCache() {
+	static_assert(staticCacheDemo() == 52, "StaticLRUCache should work in constant expressions");
+	static_assert(sizeof(StaticLRUCache<int, int, 16>::Index) == 1);
+	static_assert(sizeof(StaticLRUCache<int, int, 1000>::Index) == 2);
+	static_assert(sizeof(StaticLRUCache<int, int, 100000>::Index) == 4);
+
+	// 与 LRUCache 逐次比较命中结果
+	StaticLRUCache<int, int, 64> fixed;
+	LRUCache<int, int> reference(64);
+	mt19937 rng(5);
+	uniform_int_distribution<int> keyDist(0, 150);
+	int mismatches = 0;
+	for (int i = 0; i < 200000; ++i) {
+		int key = keyDist(rng);
+		if (i % 7 == 0) {
+			fixed.remove(key);
+			reference.remove(key);
+			continue;
+		}
+		int a = -1, b = -1;
+		bool hitA = fixed.get(key, a);
+		bool hitB = reference.get(key, b);
+		if (hitA != hitB || (hitA && a != b)) ++mismatches;
+		if (!hitA) {
+			fixed.put(key, key * 3 + i % 5);
+			reference.put(key, key * 3 + i % 5);
+		}
+	}
+	cout << "StaticLRUCache<64> vs LRUCache mismatches: " << mismatches << ", sizeof " << sizeof(fixed) << " bytes" << endl;
+
+	// 构造开销
+	const int rounds = 1000000;
+	long long sink = 0;
+	auto begin = chrono::steady_clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		StaticLRUCache<int, int, 16> cache;
+		cache.put(i, i);
+		sink += cache.get(i);
+	}
+	double staticNs = chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count() / rounds;
+	begin = chrono::steady_clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		LRUCache<int, int> cache(16);
+		cache.put(i, i);
+		sink += cache.get(i);
+	}
+	double lruNs = chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count() / rounds;
+	cout << "Construct + put + get: StaticLRUCache<16> " << staticNs << " ns, LRUCache(16) " << lruNs << " ns (sink " << sink << ")" << endl;
+}
+
+// 体积较大的 value，用来体现淘汰与衰减是否读到 value
+struct Payload {
+	int id = 0;
+	char bytes[252] = {};
+	bool operator==(const Payload& other) const { return id == other.id; }
+};
+
+void testSoACache() {
+	// 与 LRUCache 逐次比较命中结果
+	SoALRUCache<int, int> soaLru(64);
+	LRUCache<int, int> reference(64);
+	mt19937 rng(9);
+	uniform_int_distribution<int> keyDist(0, 150);
+	int mismatches = 0;
+	for (int i = 0; i < 200000; ++i) {
+		int key = keyDist(rng);
+		if (i % 7 == 0) {
+			soaLru.remove(key);
+			reference.remove(key);
+			continue;
+		}
+		int a = -1, b = -1;
+		bool hitA = soaLru.get(key, a);
+		bool hitB = reference.get(key, b);
+		if (hitA != hitB || (hitA && a != b)) ++mismatches;
+		if (!hitA) {
+			soaLru.put(key, key + i % 3);
+			reference.put(key, key + i % 3);
+		}
+	}
+	cout << "SoALRUCache vs LRUCache mismatches: " << mismatches << endl;
+
+	// SoALFUCache 混合读写删除，检查取到的值与容量
+	SoALFUCache<int, int> soaLfu(64, 8);
+	int wrongValue = 0;
+	for (int i = 0; i < 200000; ++i) {
+		int key = keyDist(rng);
+		int value = -1;
+		if (i % 5 == 0) soaLfu.remove(key);
+		else if (soaLfu.get(key, value)) wrongValue += value != key * 2;
+		else soaLfu.put(key, key * 2);
+	}
+	cout << "SoALFUCache wrong values: " << wrongValue << ", size " << soaLfu.size() << "/64" << endl;
+
+	// 衰减后同一次数内仍按最近访问淘汰：1..4 次数相同，最后一次访问触发衰减，之后先淘汰最久未访问的 1
+	SoALFUCache<int, int> aging(4, 2);
+	for (int key = 1; key <= 4; ++key) aging.put(key, key);
+	for (int round = 0; round < 2; ++round) {
+		for (int key = 1; key <= 4; ++key) aging.get(key);
+	}
+	aging.put(5, 5);
+	int value;
+	cout << "SoALFUCache evicts least recent after aging: " << (!aging.get(1, value) && aging.get(4, value)) << endl;
+
+	// 快照格式与 LRUCache 相同
+	string path = (filesystem::temp_directory_path() / "soa_lru.snap").string();
+	soaLru.saveSnapshot(path);
+	LRUCache<int, int> restored(64);
+	bool loaded = restored.loadSnapshot(path);
+	cout << "Snapshot SoALRUCache -> LRUCache: loaded=" << loaded << ", same entries=" << (restored.exportEntries() == soaLru.exportEntries()) << endl;
+	std::remove(path.c_str());
+
+	// 大 value 下的淘汰与衰减吞吐
+	const int cacheSize = 50000;
+	vector<int> trace = makeZipfTrace(1000000, 2000000, 0.8, 13);
+	auto replay = [&trace](auto& cache) {
+		int hits = 0;
+		auto begin = chrono::steady_clock::now();
+		for (int key : trace) {
+			Payload value;
+			if (cache.get(key, value)) ++hits;
+			else {
+				value.id = key + 1;
+				cache.put(key, value);
+			}
+		}
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+		cout << hits * 100.0 / trace.size() << "% hit, " << trace.size() / seconds / 1e6 << "M ops/s";
+	};
+	// SoALRUCache 的索引是 FlatHashMap，与同样用 FlatHashMap 的 LRUCache 比较才只反映存储布局的差别
+	{
+		LRUCache<int, Payload> lru(cacheSize);
+		LRUCache<int, Payload, FlatHashMap> flatLru(cacheSize);
+		SoALRUCache<int, Payload> soa(cacheSize);
+		cout << "LRU    AoS: ";
+		replay(lru);
+		cout << " | AoS + FlatHashMap: ";
+		replay(flatLru);
+		cout << " | SoA: ";
+		replay(soa);
+		cout << endl;
+	}
+	// AlignLFUCache 的衰减遍历全部节点，用较小的容量和较短的访问序列
+	trace.resize(300000);
+	{
+		AlignLFUCache<int, Payload> lfu(cacheSize / 10, 50);
+		SoALFUCache<int, Payload> soa(cacheSize / 10, 50);
+		cout << "LFU    AoS: ";
+		replay(lfu);
+		cout << " | SoA: ";
+		replay(soa);
+		cout << endl;
+	}
+}
+
+// 写入 count 个新 key，返回每次 put 耗时的 p50/p99/max（纳秒）
+template<typename Cache>
+vector<double> putLatency(Cache& cache, int firstKey, int count, int burst, chrono::microseconds pause) {
+	vector<double> latencies;
+	latencies.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		auto begin = chrono::steady_clock::now();
+		cache.put(firstKey + i, i);
+		latencies.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count());
+		if (burst > 0 && (i + 1) % burst == 0) this_thread::sleep_for(pause);
+	}
+	sort(latencies.begin(), latencies.end());
+	return { latencies[count / 2], latencies[count * 99 / 100], latencies.back() };
+}
+
+void testBackgroundEviction() {
+	const int capacity = 64000;
+	const int writes = 100000;
+	auto report = [](const char* name, const vector<double>& latency, EvictionStats stats) {
+		cout << name << ": put p50 " << latency[0] << " ns, p99 " << latency[1] << " ns, max " << latency[2]
+			<< " ns; inline evictions " << stats.inlineEvictions << ", background " << stats.backgroundEvictions;
+	};
+	for (bool background : { false, true }) {
+		HashLRUCache<int, int> cache(capacity, 16);
+		for (int i = 0; i < capacity; ++i) cache.put(i, i);
+		if (background) cache.enableBackgroundEviction(256);
+		this_thread::sleep_for(chrono::milliseconds(20));
+		// 写入按突发进行，突发之间后台线程有时间补足空位
+		auto latency = putLatency(cache, capacity, writes, 1000, chrono::microseconds(2000));
+		report(background ? "HashLRU background" : "HashLRU inline    ", latency, cache.getEvictionStats());
+		cout << ", size " << cache.size() << endl;
+	}
+	for (bool background : { false, true }) {
+		ARCCache<int, int> cache(capacity / 4, 2);
+		for (int i = 0; i < capacity / 4; ++i) cache.put(i, i);
+		if (background) cache.enableBackgroundEviction(256);
+		this_thread::sleep_for(chrono::milliseconds(20));
+		EvictionStats fill = cache.getEvictionStats();
+		auto latency = putLatency(cache, capacity, writes / 4, 100, chrono::microseconds(2000));
+		EvictionStats stats = cache.getEvictionStats();
+		stats.inlineEvictions -= fill.inlineEvictions;
+		report(background ? "ARC background    " : "ARC inline        ", latency, stats);
+		cout << endl;
+	}
+
+	// 连续写入超过后台淘汰速度时，put 退回锁内淘汰，容量仍然不会超出
+	HashLRUCache<int, int> cache(capacity, 16);
+	cache.enableBackgroundEviction(64, chrono::milliseconds(50));
+	auto latency = putLatency(cache, 0, writes * 3, 0, chrono::microseconds(0));
+	report("HashLRU saturated ", latency, cache.getEvictionStats());
+	cout << ", size " << cache.size() << endl;
+}
+
+void testWriteBack() {
+	// 每批写入 1ms 的慢速存储
+	MemoryBackingStore<int, int> store(chrono::microseconds(1000));
+	WriteBackOptions options;
+	options.maxDirtyAge = chrono::milliseconds(20);
+	options.batchSize = 256;
+	options.retryDelay = chrono::milliseconds(5);
+	{
+		WriteBackCache<int, int> cache(1000, store, options);
+		// 同一 key 的重复写入合并
+		auto begin = chrono::steady_clock::now();
+		for (int i = 0; i < 10000; ++i) cache.put(7, i);
+		double putUs = chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count() / 10000;
+		this_thread::sleep_for(chrono::milliseconds(100));
+		int value = -1;
+		store.read(7, value);
+		cout << "Hot key: 10000 puts (" << putUs << " us/put), store writes " << store.writesOf(7) << ", stored value " << value << endl;
+
+		// 超过容量的写入：被淘汰的脏条目在写回前仍可读到，最终全部写回
+		int wrong = 0;
+		for (int i = 0; i < 5000; ++i) cache.put(100000 + i, i);
+		for (int i = 0; i < 5000; ++i) {
+			if (cache.get(100000 + i) != i) ++wrong;
+		}
+		cache.flush();
+		int missing = 0;
+		for (int i = 0; i < 5000; ++i) {
+			if (!store.read(100000 + i, value) || value != i) ++missing;
+		}
+		auto stats = cache.getStats();
+		cout << "Overflow: wrong reads " << wrong << ", missing in store " << missing << ", dirty evictions " << stats.dirtyEvictions
+			<< ", batches " << stats.flushBatches << ", coalesced " << stats.coalescedWrites << endl;
+
+		// 写回失败后退避重试，直到成功
+		store.failNextWrites(3);
+		for (int i = 0; i < 100; ++i) cache.put(200000 + i, i);
+		this_thread::sleep_for(chrono::milliseconds(300));
+		stats = cache.getStats();
+		missing = 0;
+		for (int i = 0; i < 100; ++i) {
+			if (!store.read(200000 + i, value) || value != i) ++missing;
+		}
+		cout << "Failures: failed batches " << stats.failedBatches << ", dirty left " << stats.dirtyEntries << ", missing in store " << missing << endl;
+
+		// 析构时写回剩余脏数据
+		for (int i = 0; i < 50; ++i) cache.put(300000 + i, i);
+	}
+	cout << "After destruction: store has " << store.size() << " keys (expect 5151)" << endl;
+
+	// 并发写同一批 key：最后生效的值在缓存与存储中必须一致
+	MemoryBackingStore<int, int> raceStore;
+	{
+		WriteBackCache<int, int> raceCache(1000, raceStore, options);
+		vector<thread> writers;
+		for (int t = 0; t < 4; ++t) {
+			writers.emplace_back([&raceCache, t]() {
+				for (int i = 0; i < 20000; ++i) raceCache.put(i % 64, t * 100000 + i);
+			});
+		}
+		for (auto& writer : writers) writer.join();
+		raceCache.flush();
+		int diverged = 0;
+		for (int key = 0; key < 64; ++key) {
+			int cached = -1, stored = -2;
+			raceCache.get(key, cached);
+			raceStore.read(key, stored);
+			diverged += cached != stored;
+		}
+		cout << "Concurrent puts: cache/store diverged keys " << diverged << endl;
+	}
+
+	// 与同步写穿对比
+	MemoryBackingStore<int, int> slowStore(chrono::microseconds(1000));
+	LRUCache<int, int> writeThrough(1000);
+	auto begin = chrono::steady_clock::now();
+	for (int i = 0; i < 500; ++i) {
+		writeThrough.put(i % 100, i);
+		slowStore.writeBatch({ { i % 100, i } });
+	}
+	double throughUs = chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count() / 500;
+	WriteBackCache<int, int> writeBack(1000, slowStore, options);
+	begin = chrono::steady_clock::now();
+	for (int i = 0; i < 500; ++i) writeBack.put(i % 100, i);
+	double backUs = chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count() / 500;
+	cout << "put latency: write-through " << throughUs << " us, write-back " << backUs << " us" << endl;
+}
+
+void testDoorkeeper() {
+	const int cacheSize = 2000;
+	const int length = 1000000;
+	// long-tail：一半访问落在 Zipf 热点上，另一半是只出现一次的 key
+	vector<int> trace = makeZipfTrace(50000, length, 0.9, 21);
+	mt19937 rng(22);
+	int nextUnique = 1 << 24;
+	for (int& key : trace) {
+		if (rng() % 2) key = nextUnique++;
+	}
+	auto run = [&trace](const char* name, auto& cache, auto stats) {
+		int misses = 0;
+		int hits = 0;
+		for (int key : trace) {
+			int value = 0;
+			if (cache.get(key, value)) ++hits;
+			else {
+				++misses;
+				cache.put(key, key);
+			}
+		}
+		Doorkeeper::Stats door = stats();
+		uint64_t inserts = door.admitted + door.rejected > 0 ? door.admitted : misses;
+		cout << name << ": hit rate " << hits * 100.0 / trace.size() << "%, inserts " << inserts
+			<< ", rejected " << door.rejected << ", resets " << door.resets << endl;
+	};
+	for (bool door : { false, true }) {
+		LRUCache<int, int> lru(cacheSize);
+		if (door) lru.enableDoorkeeper();
+		run(door ? "LRU     + doorkeeper" : "LRU                 ", lru, [&lru]() { return lru.getDoorkeeperStats(); });
+		HashLRUCache<int, int> hashLru(cacheSize, 8);
+		if (door) hashLru.enableDoorkeeper();
+		run(door ? "HashLRU + doorkeeper" : "HashLRU             ", hashLru, [&hashLru]() { return hashLru.getDoorkeeperStats(); });
+		ARCCache<int, int> arc(cacheSize, 2);
+		if (door) arc.enableDoorkeeper();
+		run(door ? "ARC     + doorkeeper" : "ARC                 ", arc, [&arc]() { return arc.getDoorkeeperStats(); });
+	}
+}
+
+void testTagInvalidation() {
+	auto keyOf = [](int user, int item) { return "user:" + to_string(user) + ":item:" + to_string(item); };
+	// 80 个用户 x 100 个条目，每个条目带 user 与 item 两个标签
+	auto check = [&keyOf](const char* name, auto& cache) {
+		for (int user = 0; user < 80; ++user) {
+			for (int item = 0; item < 100; ++item) {
+				cache.put(keyOf(user, item), user * 100 + item + 1, { "user:" + to_string(user), "item:" + to_string(item) });
+			}
+		}
+		size_t byTag = cache.invalidateTag("item:7");
+		size_t byPrefix = cache.invalidatePrefix("user:42:");
+		// 前缀失效已经连同标签记录一起删除，再按 user:42 失效应为 0
+		size_t again = cache.invalidateTag("user:42");
+		int present = 0;
+		int wrong = 0;
+		for (int user = 0; user < 80; ++user) {
+			for (int item = 0; item < 100; ++item) {
+				int value = 0;
+				bool expected = item != 7 && user != 42;
+				bool found = cache.get(keyOf(user, item), value);
+				present += found;
+				if (found != expected || (found && value != user * 100 + item + 1)) ++wrong;
+			}
+		}
+		cout << name << ": item:7 removed " << byTag << ", user:42: removed " << byPrefix << ", again " << again
+			<< ", present " << present << ", wrong " << wrong << endl;
+	};
+	{
+		LRUCache<string, int> lru(10000);
+		check("LRU    ", lru);
+		LFUCache<string, int> lfu(10000);
+		check("LFU    ", lfu);
+		ARCCache<string, int> arc(20000, 2);
+		check("ARC    ", arc);
+		HashLRUCache<string, int> hashLru(16000, 8);
+		check("HashLRU", hashLru);
+	}
+	// 调整分片数后，搬到新表的条目仍带着标签
+	{
+		HashLRUCache<string, int> resized(16000, 8);
+		for (int i = 0; i < 1000; ++i) resized.put("k" + to_string(i), i, { "t:" + to_string(i % 4) });
+		resized.setSliceNum(3);
+		size_t removed = resized.invalidateTag("t:1");
+		int left = 0;
+		for (int i = 1; i < 1000; i += 4) {
+			int value = 0;
+			left += resized.get("k" + to_string(i), value);
+		}
+		cout << "HashLRU after setSliceNum: t:1 removed " << removed << ", left " << left << ", size " << resized.size() << endl;
+	}
+
+	// 容量小于写入量：淘汰时索引同步删除，失效数量等于仍在缓存中的带标签条目数
+	auto churn = [](const char* name, auto& cache) {
+		for (int i = 0; i < 5000; ++i) {
+			cache.put("k" + to_string(i), i, { "t:" + to_string(i % 5) });
+		}
+		size_t present = 0;
+		for (int i = 0; i < 5000; i += 5) {
+			int value = 0;
+			present += cache.get("k" + to_string(i), value);
+		}
+		size_t removed = cache.invalidateTag("t:0");
+		size_t left = 0;
+		for (int i = 0; i < 5000; i += 5) {
+			int value = 0;
+			left += cache.get("k" + to_string(i), value);
+		}
+		cout << name << " churn: present " << present << ", removed " << removed << ", left " << left << endl;
+	};
+	{
+		LRUCache<string, int> lru(1000);
+		churn("LRU", lru);
+		LFUCache<string, int> lfu(1000);
+		churn("LFU", lfu);
+		ARCCache<string, int> arc(1000, 2);
+		churn("ARC", arc);
+	}
+
+	// 耗时与删除数量成正比；大批量失效时读线程仍能推进
+	LRUCache<int, int> big(200000);
+	for (int i = 0; i < 200000; ++i) {
+		if (i < 100) big.put(i, i, { "small" });
+		else if (i < 100100) big.put(i, i, { "bulk" });
+		else big.put(i, i);
+	}
+	auto start = chrono::steady_clock::now();
+	size_t small = big.invalidateTag("small");
+	double smallUs = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+	atomic<bool> done{ false };
+	atomic<long long> reads{ 0 };
+	atomic<long long> maxReadUs{ 0 };
+	thread reader([&]() {
+		mt19937 rng(5);
+		while (!done.load()) {
+			auto t0 = chrono::steady_clock::now();
+			big.get(100100 + static_cast<int>(rng() % 99900));
+			long long us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - t0).count();
+			if (us > maxReadUs.load()) maxReadUs.store(us);
+			reads.fetch_add(1);
+		}
+	});
+	start = chrono::steady_clock::now();
+	size_t bulk = big.invalidateTag("bulk");
+	double bulkUs = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+	long long readsDuring = reads.load();
+	done = true;
+	reader.join();
+	cout << "invalidate " << small << " entries: " << smallUs << " us, " << bulk << " entries: " << bulkUs
+		<< " us, size " << big.size() << ", reads during bulk " << readsDuring << ", max read " << maxReadUs.load() << " us" << endl;
+}
+
+void testSampledLRU() {
+	const int cacheSize = 1000;
+	const int keySpace = 20000;
+	const int length = 500000;
+	vector<int> zipf = makeZipfTrace(keySpace, length, 0.9, 11);
+	vector<int> scan = makeZipfTrace(keySpace, length, 0.9, 12);
+	for (int i = 0; i < length; i += 50000) {
+		for (int j = 0; j < 5000 && i + j < length; ++j) scan[i + j] = keySpace + i + j;
+	}
+	for (const auto* trace : { &zipf, &scan }) {
+		LRUCache<int, int> lru(cacheSize);
+		cout << (trace == &zipf ? "zipf 0.9" : "zipf 0.9 + scan") << ": LRU " << replayHitRate(lru, *trace) << "%";
+		for (int samples : { 3, 5, 10 }) {
+			SampledLRUCache<int, int> pooled(cacheSize, samples);
+			SampledLRUCache<int, int> plain(cacheSize, samples, 0);
+			cout << ", K=" << samples << " pool " << replayHitRate(pooled, *trace) << "% / no pool " << replayHitRate(plain, *trace) << "%";
+		}
+		cout << endl;
+	}
+
+	// 一致性：remove 搬动末尾条目后，所有仍在缓存中的 key 都要取到自己的值
+	SampledLRUCache<int, int> check(512, 5);
+	mt19937 rng(5);
+	int wrong = 0;
+	for (int i = 0; i < 200000; ++i) {
+		int key = static_cast<int>(rng() % 2000);
+		int value = 0;
+		if (rng() % 4 == 0) check.remove(key);
+		else if (check.get(key, value)) wrong += value != key * 3;
+		else check.put(key, key * 3);
+	}
+	cout << "sampled consistency: size " << check.size() << "/512, wrong " << wrong << endl;
+
+	// 每个条目的内存占用：槽位数组 + 哈希索引，对比 LRUCache 的链表节点 + 哈希表
+	const int entries = 1000000;
+	cout << "slot bytes: " << SampledLRUCache<int, int>::slotBytes() << endl;
+#ifdef __GLIBC__
+	auto bytesPerEntry = [entries](auto create) {
+		size_t before = mallinfo2().uordblks;
+		auto cache = create();
+		for (int key = 0; key < entries; ++key) cache->put(key, key);
+		size_t after = mallinfo2().uordblks;
+		return static_cast<double>(after - before) / entries;
+	};
+	cout << "bytes per entry at " << entries << " entries: LRU "
+		<< bytesPerEntry([entries]() { return make_unique<LRUCache<int, int>>(entries); })
+		<< ", Sampled " << bytesPerEntry([entries]() { return make_unique<SampledLRUCache<int, int>>(entries); }) << endl;
+#endif
+
+	int threads = max(2, static_cast<int>(thread::hardware_concurrency()));
+	HashLRUCache<int, int> hashLru(100000, 16);
+	HashSampledLRUCache<int, int> hashSampled(100000, 16);
+	cout << threads << " threads hit throughput: HashLRU " << hitThroughput(hashLru, 50000, threads) << "M/s"
+		<< ", HashSampled " << hitThroughput(hashSampled, 50000, threads) << "M/s" << endl;
+
+	auto replayThroughput = [&scan](auto& cache) {
+		auto begin = chrono::steady_clock::now();
+		replayHitRate(cache, scan);
+		return scan.size() / chrono::duration<double>(chrono::steady_clock::now() - begin).count() / 1e6;
+	};
+	LRUCache<int, int> lru(cacheSize);
+	SampledLRUCache<int, int> sampled(cacheSize);
+	cout << "replay throughput: LRU " << replayThroughput(lru) << "M/s, Sampled " << replayThroughput(sampled) << "M/s" << endl;
+}
+
+void testGDSF() {
+	const int keySpace = 20000;
+	const int length = 500000;
+	vector<int> trace = makeZipfTrace(keySpace, length, 0.9, 21);
+	// 与热度无关地分配代价：一成 key 跨地域回源 200 ms，其余本地 0.1 ms；大小 1~64
+	auto costOf = [](int key) { return static_cast<uint32_t>(key) * 2654435761u % 10 == 0 ? 200.0 : 0.1; };
+	auto sizeOf = [](int key) { return static_cast<size_t>(1) << (static_cast<uint32_t>(key) * 40503u % 7); };
+	// 返回 { 命中率, 按代价加权的命中率 }（%）
+	auto replay = [&trace, &costOf](auto& cache, auto put) {
+		int hits = 0;
+		double hitCost = 0, totalCost = 0;
+		for (int key : trace) {
+			int value = 0;
+			totalCost += costOf(key);
+			if (cache.get(key, value)) {
+				++hits;
+				hitCost += costOf(key);
+			}
+			else put(cache, key);
+		}
+		return make_pair(hits * 100.0 / static_cast<double>(trace.size()), hitCost * 100.0 / totalCost);
+	};
+	auto print = [](const char* name, pair<double, double> result) {
+		cout << ", " << name << " " << result.first << "% / cost " << result.second << "%";
+	};
+
+	const int cacheSize = 1000;
+	auto plainPut = [](auto& cache, int key) { cache.put(key, key + 1); };
+	LRUCache<int, int> lru(cacheSize);
+	LFUCache<int, int> lfu(cacheSize);
+	GDSFCache<int, int> blind(cacheSize);
+	GDSFCache<int, int> aware(cacheSize);
+	cout << "uniform size";
+	print("LRU", replay(lru, plainPut));
+	print("LFU", replay(lfu, plainPut));
+	print("GDSF cost-blind", replay(blind, plainPut));
+	print("GDSF", replay(aware, [&costOf](auto& cache, int key) { cache.put(key, key + 1, costOf(key), 1); }));
+	cout << endl;
+	auto stats = aware.getStats();
+	cout << "GDSF stats: hit rate " << stats.hitRate() * 100 << "%, cost hit rate " << stats.costHitRate() * 100
+		<< "%, evictions " << stats.evictions << ", L " << aware.inflation() << endl;
+
+	// 大小不一时容量按大小计；cost 为 0 的 GDSF 即按大小计容量的 LRU
+	const size_t budget = 16000;
+	GDSFCache<int, int> sizedLru(budget);
+	GDSFCache<int, int> sizeOnly(budget);
+	GDSFCache<int, int> sized(budget);
+	cout << "variable size";
+	print("LRU", replay(sizedLru, [&sizeOf](auto& cache, int key) { cache.put(key, key + 1, 0.0, sizeOf(key)); }));
+	print("GDSF cost-blind", replay(sizeOnly, [&sizeOf](auto& cache, int key) { cache.put(key, key + 1, 1.0, sizeOf(key)); }));
+	print("GDSF", replay(sized, [&costOf, &sizeOf](auto& cache, int key) { cache.put(key, key + 1, costOf(key), sizeOf(key)); }));
+	cout << endl;
+
+	// 一致性：随机读写删除与更新大小，容量不超限且值不错
+	GDSFCache<int, int> check(500);
+	mt19937 rng(9);
+	int wrong = 0;
+	bool overflow = false;
+	for (int i = 0; i < 200000; ++i) {
+		int key = static_cast<int>(rng() % 3000);
+		int value = 0;
+		uint32_t op = rng() % 8;
+		if (op == 0) check.remove(key);
+		else if (op == 1) check.put(key, key * 3, costOf(key), rng() % 40 + 1);
+		else if (check.get(key, value)) wrong += value != key * 3;
+		else check.put(key, key * 3, costOf(key), sizeOf(key));
+		overflow |= check.usedSize() > check.getCapacity();
+	}
+	cout << "GDSF consistency: size " << check.size() << ", used " << check.usedSize() << "/500, overflow " << overflow
+		<< ", wrong " << wrong << endl;
+}
+
+// 三成读写集中在 8 个同属 0 号分片的 key 上，其余均匀分布；返回百万次/秒
+template<typename Cache>
+double skewedShardThroughput(Cache& cache, int threads, atomic<long long>& wrongValue) {
+	const int keySpace = 100000;
+	const int perThread = 1000000;
+	auto begin = chrono::steady_clock::now();
+	vector<thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		workers.emplace_back([&cache, &wrongValue, t]() {
+			uint32_t x = 1234567u + t;
+			for (int i = 0; i < perThread; ++i) {
+				x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+				int key = (x % 10 < 3) ? static_cast<int>((x >> 8) % 8) * 16 : static_cast<int>(x >> 8) % keySpace;
+				if ((x >> 4) % 1000 == 0) {
+					cache.put(key, key * 3);
+					continue;
+				}
+				int value = 0;
+				if (cache.get(key, value)) {
+					if (value != key * 3) ++wrongValue;
+				}
+				else {
+					cache.put(key, key * 3);
+				}
+			}
+		});
+	}
+	for (auto& worker : workers) worker.join();
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+	return perThread * static_cast<double>(threads) / seconds / 1e6;
+}
+
+void testHotKeys() {
+	int threads = max(2, static_cast<int>(thread::hardware_concurrency()));
+	atomic<long long> wrongValue{ 0 };
+	// 分片锁的加锁次数，最忙分片与平均值之比
+	auto lockSkew = [](const vector<LockStats>& stats) {
+		uint64_t total = 0, busiest = 0;
+		for (const auto& stat : stats) {
+			total += stat.acquisitions;
+			busiest = max(busiest, stat.acquisitions);
+		}
+		return total ? static_cast<double>(busiest) * static_cast<double>(stats.size()) / static_cast<double>(total) : 0.0;
+	};
+
+	HashLRUCache<int, int> plain(50000, 16);
+	plain.setProfiler(make_shared<CacheProfiler>());
+	double plainOps = skewedShardThroughput(plain, threads, wrongValue);
+
+	HashLRUCache<int, int> replicated(50000, 16);
+	replicated.setProfiler(make_shared<CacheProfiler>());
+	replicated.enableHotKeys();
+	double hotOps = skewedShardThroughput(replicated, threads, wrongValue);
+	auto stats = replicated.getHotKeyStats();
+	cout << threads << " threads skewed shard: HashLRU " << plainOps << "M ops/s, with hot keys " << hotOps << "M ops/s" << endl;
+	cout << "shard lock skew: " << lockSkew(plain.getShardLockStats()) << " -> " << lockSkew(replicated.getShardLockStats())
+		<< ", sampled read skew " << stats.skew() << " -> " << stats.skew(true) << ", served by replica " << stats.hotShare() * 100
+		<< "%, hot keys " << stats.hotKeys << ", refreshes " << stats.refreshes << ", wrong values " << wrongValue << endl;
+
+	// 一致性：另一个线程改写热点 key 后，副本中的旧值不能再被读到
+	int staleReads = 0;
+	for (int i = 0; i < 1000; ++i) {
+		thread writer([&replicated, i]() { replicated.put(0, i); });
+		writer.join();
+		int value = -1;
+		for (int j = 0; j < 50; ++j) {
+			if (replicated.get(0, value) && value != i) ++staleReads;
+		}
+	}
+	vector<int> hot = replicated.getHotKeys();
+	cout << "key 0 hot: " << (find(hot.begin(), hot.end(), 0) != hot.end()) << ", stale reads after remote put: " << staleReads << endl;
+
+	// 读线程不断触发刷新时并发改写热点 key：刷新途中的写入也要使正在发布的表项失效，写完后只能读到最后的值
+	atomic<bool> writing{ true };
+	vector<thread> readers;
+	for (int t = 0; t < threads; ++t) {
+		readers.emplace_back([&replicated, &writing]() {
+			int value;
+			while (writing.load()) replicated.get(0, value);
+		});
+	}
+	const int lastValue = 100000;
+	for (int i = 0; i <= lastValue; ++i) replicated.put(0, i);
+	writing = false;
+	for (auto& reader : readers) reader.join();
+	int staleAfterRace = 0;
+	for (int i = 0; i < 200000; ++i) {
+		int value = -1;
+		if (replicated.get(0, value) && value != lastValue) ++staleAfterRace;
+	}
+	cout << "stale reads after concurrent puts during refresh: " << staleAfterRace << endl;
+}
+
+void testPinnedHandle() {
+	const size_t valueBytes = 1 << 20;
+	auto makeValue = [valueBytes](int key, int version = 0) { return string(valueBytes, static_cast<char>('a' + (key + version) % 26)); };
+	auto intact = [valueBytes](const string& value, int key, int version = 0) {
+		char c = static_cast<char>('a' + (key + version) % 26);
+		return value.size() == valueBytes && value.front() == c && value.back() == c;
+	};
+	auto stringBytes = [](const string& value) { return value.size(); };
+
+	// 读取 1 MB 的值：拷贝 vs handle
+	LRUCache<int, string> lru(8);
+	for (int key = 0; key < 8; ++key) lru.put(key, makeValue(key));
+	const int reads = 2000;
+	size_t checksum = 0;
+	auto begin = chrono::steady_clock::now();
+	for (int i = 0; i < reads; ++i) {
+		string value;
+		lru.get(i % 8, value);
+		checksum += static_cast<unsigned char>(value[i % valueBytes]);
+	}
+	double copyUs = chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count() / reads;
+	begin = chrono::steady_clock::now();
+	for (int i = 0; i < reads; ++i) {
+		auto handle = lru.getHandle(i % 8);
+		checksum += static_cast<unsigned char>((*handle)[i % valueBytes]);
+	}
+	double handleUs = chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count() / reads;
+	cout << "1 MB get: copy " << copyUs << " us, handle " << handleUs << " us (checksum " << checksum % 10 << ")" << endl;
+
+	// pin 住的条目不被淘汰，handle 看到的是取出时的值；释放后照常淘汰
+	auto pinnedSurvives = [&](auto& cache, const char* name) {
+		cache.put(0, makeValue(0));
+		auto handle = cache.getHandle(0);
+		if (!handle) return;
+		for (int key = 100; key < 140; ++key) cache.put(key, makeValue(key));
+		bool kept = cache.getHandle(0) && intact(*handle, 0);
+		cache.put(0, makeValue(0, 1));
+		bool oldValue = intact(*handle, 0);
+		auto updated = cache.getHandle(0);
+		bool newValue = updated && intact(*updated, 0, 1);
+		cache.remove(0);
+		bool afterRemove = intact(*handle, 0) && updated && intact(*updated, 0, 1);
+		updated.release();
+		handle.release();
+		cache.put(0, makeValue(0));
+		for (int key = 200; key < 240; ++key) cache.put(key, makeValue(key));
+		cout << name << ": pinned kept " << kept << ", old value after put " << oldValue << ", new value " << newValue
+			<< ", values after remove " << afterRemove << ", evicted after release " << !cache.getHandle(0)
+			<< ", pinned bytes " << cache.getPinStats().pinnedBytes << endl;
+	};
+	pinnedSurvives(lru, "LRU");
+	HashLRUCache<int, string> hash(8, 2);
+	for (int key = 0; key < 8; ++key) hash.put(key, makeValue(key));
+	pinnedSurvives(hash, "HashLRU");
+	// 提升阈值设大，让 key 0 留在 LRU 部分
+	ARCCache<int, string> arc(8, 100);
+	for (int key = 0; key < 8; ++key) arc.put(key, makeValue(key));
+	pinnedSurvives(arc, "ARC");
+
+	// pin 预算：超出后 handle 改为拷贝，条目照常淘汰
+	LRUCache<int, string> limited(8);
+	limited.setPinLimit(3 * valueBytes, stringBytes);
+	for (int key = 0; key < 8; ++key) limited.put(key, makeValue(key));
+	vector<LRUCache<int, string>::Handle> handles;
+	for (int key = 0; key < 4; ++key) handles.push_back(limited.getHandle(key));
+	handles.push_back(limited.getHandle(0));
+	int pinnedCount = 0;
+	for (auto& handle : handles) pinnedCount += handle.pinned();
+	for (int key = 100; key < 120; ++key) limited.put(key, makeValue(key));
+	auto pinStats = limited.getPinStats();
+	cout << "pin limit 3 MB: pinned handles " << pinnedCount << "/5, pinned entries " << pinStats.pinnedEntries << ", pinned bytes "
+		<< pinStats.pinnedBytes << ", rejects " << pinStats.rejects << ", unpinned evicted " << !limited.getHandle(3)
+		<< ", copy intact " << intact(*handles[3], 3) << endl;
+	handles.clear();
+
+	// 并发：读线程持有 handle 校验内容，写线程持续写入新 key 触发淘汰
+	HashLRUCache<int, string> shared(32, 4);
+	shared.setPinLimit(16 * valueBytes, stringBytes);
+	atomic<bool> stop{ false };
+	atomic<long long> corrupted{ 0 }, held{ 0 };
+	vector<thread> readers;
+	for (int t = 0; t < 2; ++t) {
+		readers.emplace_back([&, t]() {
+			uint32_t x = 777u + t;
+			while (!stop.load()) {
+				x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+				int key = static_cast<int>(x % 64);
+				auto handle = shared.getHandle(key);
+				if (!handle) continue;
+				++held;
+				this_thread::yield();
+				if (!intact(*handle, key)) ++corrupted;
+			}
+		});
+	}
+	thread writer([&]() {
+		for (int i = 0; i < 3000; ++i) shared.put(i % 64, makeValue(i % 64));
+		stop = true;
+	});
+	writer.join();
+	for (auto& reader : readers) reader.join();
+	cout << "concurrent: handles " << held << ", corrupted " << corrupted << ", size " << shared.size()
+		<< ", pinned bytes after release " << shared.getPinStats().pinnedBytes << endl;
+}
+
+void testDecayLFU() {
+	const int cacheSize = 2000;
+	const int keySpace = 50000;
+	const int phaseLength = 200000;
+	// 热点整体迁移：每个阶段换一批 key，第一阶段的热点之后不再访问。
+	// AlignLFUCache 每次衰减遍历全部节点，在这样长的序列上太慢，不参与比较
+	vector<vector<int>> phases;
+	for (int p = 0; p < 3; ++p) {
+		vector<int> trace = makeZipfTrace(keySpace, phaseLength, 0.9, 31 + p);
+		for (int& key : trace) key += 1 + p * keySpace;
+		phases.push_back(move(trace));
+	}
+	LRUCache<int, int> lru(cacheSize);
+	LFUCache<int, int> lfu(cacheSize);
+	DecayLFUCache<int, int> decay(cacheSize, cacheSize * 4.0);
+	for (size_t p = 0; p < phases.size(); ++p) {
+		double lruRate = replayHitRate(lru, phases[p]);
+		double lfuRate = replayHitRate(lfu, phases[p]);
+		double decayRate = replayHitRate(decay, phases[p]);
+		cout << "phase " << p << ": LRU " << lruRate << "%, LFU " << lfuRate << "%, DecayLFU " << decayRate << "%" << endl;
+	}
+
+	// 固定分布下与 LFU 相当，且每次操作的开销不随容量变化
+	vector<int> stable = makeZipfTrace(keySpace * 4, 1000000, 0.8, 41);
+	for (int& key : stable) ++key;
+	auto timed = [&stable](auto& cache) {
+		auto begin = chrono::steady_clock::now();
+		double rate = replayHitRate(cache, stable);
+		double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count() / static_cast<double>(stable.size());
+		return make_pair(rate, ns);
+	};
+	LFUCache<int, int> lfuLarge(cacheSize * 10);
+	DecayLFUCache<int, int> decayLarge(cacheSize * 10, cacheSize * 40.0);
+	auto lfuResult = timed(lfuLarge);
+	auto decayResult = timed(decayLarge);
+	cout << "stable zipf 0.8: LFU " << lfuResult.first << "% (" << lfuResult.second << " ns/op), DecayLFU "
+		<< decayResult.first << "% (" << decayResult.second << " ns/op), evictions " << decayLarge.getEvictions() << endl;
+
+	// 分数每过一个半衰期减半
+	DecayLFUCache<int, int> check(16, 100);
+	for (int i = 0; i < 8; ++i) check.put(1, i);
+	double before = check.frequency(1);
+	for (int i = 0; i < 100; ++i) check.get(2);
+	double after = check.frequency(1);
+	// 一致性：随机读写删除，容量不超限且值不错
+	DecayLFUCache<int, int> consistency(300, 500);
+	mt19937 rng(43);
+	int wrong = 0;
+	bool overflow = false;
+	for (int i = 0; i < 300000; ++i) {
+		int key = static_cast<int>(rng() % 2000) + 1;
+		int value = 0;
+		uint32_t op = rng() % 10;
+		if (op == 0) consistency.remove(key);
+		else if (consistency.get(key, value)) wrong += value != key * 7;
+		else consistency.put(key, key * 7);
+		overflow |= consistency.size() > 300;
+	}
+	cout << "score after 8 touches " << before << ", one half-life later " << after << "; consistency: size " << consistency.size()
+		<< ", overflow " << overflow << ", wrong " << wrong << endl;
+}
+
+#ifdef SHMLRUCACHE_SUPPORTED
+void testShmCache() {
+	const string name = "/mylrucache_test_" + to_string(getpid());
+	const int capacity = 4096;
+	const int shardNum = 8;
+	const int workers = 4;
+	const int perWorker = 500;
+	ShmLRUCache<int, int>::unlink(name);
+	ShmLRUCache<int, int> cache(name, capacity, shardNum);
+	// 多个 worker 进程各自写入一段 key，父进程能读到全部
+	vector<pid_t> children;
+	for (int w = 0; w < workers; ++w) {
+		pid_t pid = fork();
+		if (pid == 0) {
+			ShmLRUCache<int, int> worker(name, capacity, shardNum);
+			if (!worker.isOpen()) _exit(1);
+			for (int i = 0; i < perWorker; ++i) {
+				int key = w * perWorker + i;
+				worker.put(key, key * 3);
+			}
+			_exit(0);
+		}
+		children.push_back(pid);
+	}
+	int failedWorkers = 0;
+	for (pid_t pid : children) {
+		int status = 0;
+		waitpid(pid, &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) ++failedWorkers;
+	}
+	int shared = 0;
+	for (int key = 0; key < workers * perWorker; ++key) {
+		int value = 0;
+		if (cache.get(key, value) && value == key * 3) ++shared;
+	}
+	ShmLRUCache<int, int> mismatched(name, capacity * 2, shardNum);
+	cout << "shm: workers failed " << failedWorkers << ", entries visible to parent " << shared << "/" << workers * perWorker
+		<< ", attach with other capacity " << (mismatched.isOpen() ? "opened" : "rejected") << endl;
+
+	// 持续写入的进程被 SIGKILL，可能正持有某个分片的锁；之后的访问不能卡住，分片保持一致
+	for (int round = 0; round < 5; ++round) {
+		pid_t pid = fork();
+		if (pid == 0) {
+			ShmLRUCache<int, int> worker(name, capacity, shardNum);
+			for (int i = 0;; ++i) {
+				worker.put(100000 + i % 20000, i);
+			}
+		}
+		this_thread::sleep_for(chrono::milliseconds(20));
+		kill(pid, SIGKILL);
+		waitpid(pid, nullptr, 0);
+		for (int key = 0; key < 20000; ++key) {
+			cache.put(200000 + key, key);
+		}
+	}
+	int wrong = 0;
+	for (int key = 0; key < 20000; ++key) {
+		cache.put(300000 + key, key);
+		int value = -1;
+		if (!cache.get(300000 + key, value) || value != key) ++wrong;
+	}
+	auto stats = cache.getStats();
+	cout << "shm after 5 killed writers: size " << cache.size() << "/" << capacity << ", wrong " << wrong
+		<< ", owner deaths " << stats.ownerDeaths << ", shard resets " << stats.shardResets
+		<< ", evictions " << stats.evictions << endl;
+	ShmLRUCache<int, int>::unlink(name);
+}
+#endif
+
 int main() 
 {
 	//testHashList();
+	//testProfiler();
+	//testSnapshot();
+	//testArenaCache();
+	//testTieredCache();
+	//testCompressedCache();
+	//testFlatHashMap();
+	//testPolicyComparison();
+	//testResize();
+	//testFrontCache();
+	//testAsyncCache();
+	//testAdaptiveCache();
+	//testStaticCache();
+	//testSoACache();
+	//testBackgroundEviction();
+	//testWriteBack();
+	//testDoorkeeper();
+	//testTagInvalidation();
+	//testSampledLRU();
+	//testGDSF();
+	//testHotKeys();
+	//testPinnedHandle();
+	//testDecayLFU();
+#ifdef SHMLRUCACHE_SUPPORTED
+	//testShmCache();
+#endif
 	testCache();
 	return 0;
 }